@@ -61,6 +61,7 @@
 #include "error.h"
 #include "error_val.h"
 #include "heap.h"
+#include "protect.h"
 
 /*
  * Library Copyright and URL information for ident and what programs
@@ -89,6 +90,27 @@ static char *information = "@(#) $Information: lock-threads is enabled $";
 /* limit in how much memory we are allowed to allocate */
 unsigned long		_dmalloc_memory_limit = 0;
 
+/* fully check only 1 in this many allocations, 0 or 1 to check all */
+unsigned long		_dmalloc_sample_rate = 0;
+
+/* bytes and pointers of freed memory to hold on to before reusing it */
+unsigned long		_dmalloc_quarantine_size = 0;
+unsigned long		_dmalloc_quarantine_count = 0;
+
+/* check only this many blocks of the heap per transaction, 0 for all */
+unsigned long		_dmalloc_check_budget = 0;
+
+/* split the full heap check between this many threads */
+unsigned long		_dmalloc_check_threads = 0;
+
+/* put a guard page after allocations from this file and line */
+char			*_dmalloc_guard_file = NULL;
+int			_dmalloc_guard_line = 0;
+
+/* put a guard page after allocations of this range of sizes */
+unsigned long		_dmalloc_guard_min = 0;
+unsigned long		_dmalloc_guard_max = 0;
+
 /* total number of bytes that the heap has allocated */
 unsigned long		_dmalloc_alloc_total = 0;
 
@@ -97,11 +119,11 @@ unsigned long		_dmalloc_alloc_total = 0;
  */
 
 /*
- * Skip list of our free list sorted by size in bytes.  Bit of a hack
- * here.  Basically we cannot do a alloc for the structure and we'd
- * like it to be static storage so we allocate an array of them to
- * make sure we have enough forward pointers, when all we need is
- * SKIP_SLOT_SIZE(MAX_SKIP_LEVEL + 1) bytes.
+ * Skip list of our free list sorted by size in bytes and then by
+ * address.  Bit of a hack here.  Basically we cannot do a alloc for
+ * the structure and we'd like it to be static storage so we allocate
+ * an array of them to make sure we have enough forward pointers, when
+ * all we need is SKIP_SLOT_SIZE(MAX_SKIP_LEVEL + 1) bytes.
  */
 static	skip_alloc_t	skip_free_alloc[MAX_SKIP_LEVEL /* read note ^^ */];
 static	skip_alloc_t	*skip_free_list = skip_free_alloc;
@@ -110,6 +132,10 @@ static	skip_alloc_t	*skip_free_list = skip_free_alloc;
 static	skip_alloc_t	skip_address_alloc[MAX_SKIP_LEVEL /* read note ^^ */];
 static	skip_alloc_t	*skip_address_list = skip_address_alloc;
 
+/* highest levels in use in the lists which is where the searches start */
+static	int		skip_free_level = 0;
+static	int		skip_address_level = 0;
+
 /* update slots which we use to update the skip lists */
 static	skip_alloc_t	skip_update[MAX_SKIP_LEVEL /* read note ^^ */];
 
@@ -117,14 +143,70 @@ static	skip_alloc_t	skip_update[MAX_SKIP_LEVEL /* read note ^^ */];
 static	skip_alloc_t	*entry_free_list[MAX_SKIP_LEVEL];
 /* linked list of blocks of the sizes */
 static	entry_block_t	*entry_blocks[MAX_SKIP_LEVEL];
-/* linked list of freed blocks on hold waiting for the FREED_POINTER_DELAY */
+/*
+ * radix tree from the blocks of the used allocations and divided-blocks
+ * and from the blocks at the ends of the free runs to their slots
+ */
+static	skip_alloc_t	***page_map[PAGE_MAP_SIZE];
+/*
+ * Linked list of freed blocks on hold waiting for the FREED_POINTER_DELAY
+ * or, with a quarantine, until they are pushed out by newer frees.
+ */
 static	skip_alloc_t	*free_wait_list_head = NULL;
 static	skip_alloc_t	*free_wait_list_tail = NULL;
+/* linked lists of all of the divided-blocks of each of the bit-sizes */
+static	slab_block_t	*slab_blocks[BASIC_BLOCK];
+/* linked lists of divided-blocks which have chunks available */
+static	slab_block_t	*slab_avail[BASIC_BLOCK];
+/* admin space of the reclaimed divided-blocks to be used again */
+static	slab_block_t	*slab_spare[BASIC_BLOCK];
+/* counts of the divided-blocks of each of the bit-sizes */
+static	unsigned long	slab_block_c[BASIC_BLOCK];
+static	unsigned long	slab_reclaim_c[BASIC_BLOCK];
+#if FREE_RELEASE_OKAY
+/* iteration when we next look for idle free memory to release */
+static	unsigned long	release_iter = FREE_RELEASE_DELAY;
+#endif
+/* where the incremental heap check left off */
+static	int		step_pass_b = 0;	/* are we in a pass? */
+static	int		step_level_c = 0;	/* level of admin blocks */
+static	entry_block_t	*step_block_p = NULL;	/* next admin block */
+static	heap_walk_t	step_walk;		/* place in the slot lists */
+/* the parts of the heap handed out to the check-threads */
+static	check_range_t	check_ranges[CHECK_RANGE_MAX];
+#if LOCK_THREADS
+static	pthread_mutex_t	check_mutex = PTHREAD_MUTEX_INITIALIZER;
+static	pthread_cond_t	check_work_cond = PTHREAD_COND_INITIALIZER;
+static	pthread_cond_t	check_done_cond = PTHREAD_COND_INITIALIZER;
+static	int		check_range_n = 0;	/* parts to be checked */
+static	int		check_range_next = 0;	/* next part to hand out */
+static	int		check_range_done = 0;	/* parts that are done */
+static	unsigned long	check_thread_n = 0;	/* threads started */
+static	unsigned long	check_thread_want = 0;	/* setting when started */
+#endif
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+/* linked list of all of the thread caches */
+static	thread_cache_t	*thread_caches = NULL;
+/* key to get the current thread's cache */
+static	pthread_key_t	cache_key;
+static	int		cache_key_b = 0;	/* has the key been created? */
+/* odd while counts are being moved from a cache to the library */
+static	volatile unsigned long	stats_seq = 0;
+/* pointers handed out of the caches in each bucket of user addresses */
+static	volatile unsigned int	cache_handed[CACHE_HANDED_BUCKETS];
+#endif
 
 /* administrative structures */
 static	char		fence_bottom[FENCE_BOTTOM_SIZE];
 static	char		fence_top[FENCE_TOP_SIZE];
+/* first overwritten byte found by the last blank check for the log */
+#if LOCK_THREADS && defined(THREAD_LOCAL)
+static	THREAD_LOCAL const char	*overwrite_p = NULL;
+#else
+static	const char	*overwrite_p = NULL;
+#endif
 static	int		bit_sizes[BASIC_BLOCK]; /* number bits for div-blocks*/
+static	int		plain_b = 0;	/* only tracking the pointers */
 
 /* memory tables */
 static	mem_table_t	mem_table_alloc;
@@ -139,6 +221,10 @@ static	unsigned long	alloc_cur_given = 0;	/* current mem given */
 static	unsigned long	alloc_max_given = 0;	/* maximum mem given  */
 static	unsigned long	alloc_one_max = 0;	/* maximum at once */
 static	unsigned long	free_space_bytes = 0;	/* count the free bytes */
+static	unsigned long	free_release_bytes = 0;	/* free bytes given back */
+static	unsigned long	free_wait_bytes = 0;	/* bytes on the wait list */
+static	unsigned long	free_wait_pnts = 0;	/* pnts on the wait list */
+static	unsigned long	free_protect_bytes = 0;	/* freed bytes no-access */
 
 /* pointer stats */
 static	unsigned long	alloc_cur_pnts = 0;	/* current pointers */
@@ -161,6 +247,9 @@ static	unsigned long	func_new_c = 0;		/* count the news */
 static	unsigned long	func_free_c = 0;	/* count the frees */
 static	unsigned long	func_delete_c = 0;	/* count the deletes */
 
+/* sampling */
+static	unsigned long	sample_c = 0;		/* allocs until next sample */
+
 /**************************** skip list routines *****************************/
 
 /*
@@ -239,12 +328,12 @@ static	skip_alloc_t	*find_address(const void *address, const int free_b,
   int		level_c;
   skip_alloc_t 	*slot_p, *found_p = NULL, *next_p;
   
-  /* skip_address_max_level */
-  level_c = MAX_SKIP_LEVEL - 1;
   if (free_b) {
+    level_c = skip_free_level;
     slot_p = skip_free_list;
   }
   else {
+    level_c = skip_address_level;
     slot_p = skip_address_list;
   }
   
@@ -329,8 +418,7 @@ static	skip_alloc_t	*find_free_size(const unsigned int size,
   int		level_c, cmp;
   skip_alloc_t 	*slot_p, *found_p = NULL, *next_p;
   
-  /* skip_free_max_level */
-  level_c = MAX_SKIP_LEVEL - 1;
+  level_c = skip_free_level;
   slot_p = skip_free_list;
   
   /* traverse list to smallest entry */
@@ -380,6 +468,71 @@ static	skip_alloc_t	*find_free_size(const unsigned int size,
   return found_p;
 }
 
+/*
+ * static skip_alloc_t *find_free_slot
+ *
+ * DESCRIPTION:
+ *
+ * Look for a specific slot in the free skip list which is ordered by
+ * size and then by address.  Either way, the links that were
+ * traversed to get to where the slot is or would be are set in the
+ * update slot which has the maximum number of levels.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the slot if it is on the list.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * find_p -> Slot we are looking for.
+ *
+ * update_p -> Pointer to the skip_alloc entry we are using to hold
+ * the update pointers.
+ */
+static	skip_alloc_t	*find_free_slot(const skip_alloc_t *find_p,
+					skip_alloc_t *update_p)
+{
+  int		level_c;
+  skip_alloc_t 	*slot_p, *found_p = NULL, *next_p;
+  
+  level_c = skip_free_level;
+  slot_p = skip_free_list;
+  
+  while (1) {
+    
+    /* next on we are looking for */
+    next_p = slot_p->sa_next_p[level_c];
+    
+    /* are we are at the end of a row? */
+    if (next_p == NULL
+	|| next_p == found_p) {
+      /* just go down a level */
+    }
+    else if (next_p->sa_total_size < find_p->sa_total_size
+	     || (next_p->sa_total_size == find_p->sa_total_size
+		 && (char *)next_p->sa_mem < (char *)find_p->sa_mem)) {
+      /* next slot is less, go right */
+      slot_p = next_p;
+      continue;
+    }
+    else if (next_p == find_p) {
+      found_p = next_p;
+    }
+    
+    /* we are lowering the level */
+    
+    update_p->sa_next_p[level_c] = slot_p;
+    if (level_c == 0) {
+      break;
+    }
+    level_c--;
+  }
+  
+  return found_p;
+}
+
 /*
  * static int insert_slot
  *
@@ -407,11 +560,26 @@ static	int	insert_slot(skip_alloc_t *slot_p, const int free_b)
   
   update_p = skip_update;
   
+  /* the searches below need to start at or above our level */
+  if (free_b) {
+    if (slot_p->sa_level_n > skip_free_level) {
+      skip_free_level = slot_p->sa_level_n;
+    }
+  }
+  else if (slot_p->sa_level_n > skip_address_level) {
+    skip_address_level = slot_p->sa_level_n;
+  }
+  
   if (free_b) {
-    (void)find_free_size(slot_p->sa_total_size, update_p);
+    if (find_free_slot(slot_p, update_p) != NULL) {
+      /* Sanity check.  We should not already be on the free list. */
+      dmalloc_errno = ERROR_ADDRESS_LIST;
+      dmalloc_error("insert_slot");
+      return 0;
+    }
     /*
-     * NOTE: we can get a new_p because there might be other blocks of
-     * the same size which we will be inserting before.
+     * NOTE: other blocks of the same size are kept in address order so
+     * the lowest address is used first.
      */
   }
   else if (find_address(slot_p->sa_mem, 0 /* used list */, 1 /* exact */,
@@ -544,7 +712,7 @@ static	int	remove_slot(skip_alloc_t *delete_p, skip_alloc_t *update_p)
   int		level_c;
   
   /* update the block skip list */
-  for (level_c = 0; level_c <= MAX_SKIP_LEVEL; level_c++) {
+  for (level_c = 0; level_c <= delete_p->sa_level_n; level_c++) {
     
     /*
      * The update node holds pointers to the slots which are pointing
@@ -688,6 +856,33 @@ static	skip_alloc_t	*get_slot(void)
   return new_p;
 }
 
+/*
+ * static void free_slot
+ *
+ * DESCRIPTION:
+ *
+ * Give a slot which is no longer on any of the lists back to the
+ * entry free list of its level so get_slot can use it again.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are freeing.
+ */
+static	void	free_slot(skip_alloc_t *slot_p)
+{
+  int	level_n;
+  
+  level_n = slot_p->sa_level_n;
+  memset(slot_p, 0, SKIP_SLOT_SIZE(level_n));
+  slot_p->sa_level_n = level_n;
+  slot_p->sa_next_p[0] = entry_free_list[level_n];
+  entry_free_list[level_n] = slot_p;
+}
+
 /*
  * static skip_alloc_t *insert_address
  *
@@ -740,1590 +935,5499 @@ static	skip_alloc_t	*insert_address(void *address, const int free_b,
   return new_p;
 }
 
-/******************************* misc routines *******************************/
-
 /*
- * static int expand_chars
+ * static void *page_map_node
  *
  * DESCRIPTION:
  *
- * Copies a buffer into a output buffer while translates
- * non-printables into %03o octal values.  If it can, it will also
- * translate certain \ characters (\r, \n, etc.) into \\%c.  The
- * routine is useful for printing out binary values.
- *
- * Note: It does _not_ add a \0 at the end of the output buffer.
+ * Allocate a zeroed node of the page map tree from the heap and
+ * account for it on the used list.
  *
  * RETURNS:
  *
- * Returns the number of characters added to the output buffer.
+ * Success - Pointer to the node.
+ *
+ * Failure - NULL
  *
  * ARGUMENTS:
  *
- * buf - the buffer to convert.
+ * None.
+ */
+static	void	*page_map_node(void)
+{
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("need a page map node");
+  }
+  
+  /* error code set in _dmalloc_chunk_admin_alloc */
+  return _dmalloc_chunk_admin_alloc(PAGE_MAP_SIZE * sizeof(void *));
+}
+
+/*
+ * static skip_alloc_t **page_map_entry
  *
- * buf_size - size of the buffer.  If < 0 then it will expand till it
- * sees a \0 character.
+ * DESCRIPTION:
  *
- * out - destination buffer for the convertion.
+ * Find the page map entry for the block which holds an address.
  *
- * out_size - size of the output buffer.
+ * NOTE: creating the entry may call get_slot which will overwrite the
+ * skip_update pointers.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the entry.
+ *
+ * Failure - NULL if the entry does not exist and we are not creating
+ * it or if the address is past what the map covers.
+ *
+ * ARGUMENTS:
+ *
+ * address -> Address in the block whose entry we are looking for.
+ *
+ * create_b -> Set to 1 to allocate the nodes of the tree as needed.
  */
-static	int	expand_chars(const void *buf, const int buf_size,
-			     char *out, const int out_size)
+static	skip_alloc_t	**page_map_entry(const void *address,
+					 const int create_b)
 {
-  const unsigned char	*buf_p, *spec_p;
-  char	 		*out_p = out, *bounds_p;
+  unsigned long	block_n, root_c;
+  skip_alloc_t	***mid_p, **leaf_p;
   
-  /* setup our max pointer */
-  bounds_p = out + out_size;
+  block_n = (unsigned long)address >> BASIC_BLOCK;
+  root_c = block_n >> (PAGE_MAP_BITS * 2);
+  if (root_c >= PAGE_MAP_SIZE) {
+    return NULL;
+  }
   
-  /* run through the input buffer, counting the characters as we go */
-  for (buf_p = (const unsigned char *)buf;
-       buf_p < (const unsigned char *)buf + buf_size;
-       buf_p++) {
-    
-    /* search for special characters */
-    for (spec_p = (unsigned char *)SPECIAL_CHARS + 1;
-	 *(spec_p - 1) != '\0';
-	 spec_p += 2) {
-      if (*spec_p == *buf_p) {
-	break;
-      }
+  mid_p = page_map[root_c];
+  if (mid_p == NULL) {
+    if (! create_b) {
+      return NULL;
     }
-    
-    /* did we find one? */
-    if (*(spec_p - 1) != '\0') {
-      if (out_p + 2 >= bounds_p) {
-	break;
-      }
-      out_p += loc_snprintf(out_p, bounds_p - out_p, "\\%c", *(spec_p - 1));
-      continue;
+    mid_p = page_map_node();
+    if (mid_p == NULL) {
+      /* error code set in page_map_node */
+      return NULL;
     }
-    
-    /* print out any 7-bit printable characters */
-    if (*buf_p < 128 && isprint(*buf_p)) {
-      if (out_p + 1 >= bounds_p) {
-	break;
-      }
-      *out_p = *(char *)buf_p;
-      out_p += 1;
+    page_map[root_c] = mid_p;
+  }
+  
+  leaf_p = mid_p[(block_n >> PAGE_MAP_BITS) & PAGE_MAP_MASK];
+  if (leaf_p == NULL) {
+    if (! create_b) {
+      return NULL;
     }
-    else {
-      if (out_p + 4 >= bounds_p) {
-	break;
-      }
-      out_p += loc_snprintf(out_p, bounds_p - out_p, "\\%03o", *buf_p);
+    leaf_p = page_map_node();
+    if (leaf_p == NULL) {
+      /* error code set in page_map_node */
+      return NULL;
     }
-  }
-  /* try to punch the null if we have space in case the %.*s doesn't work */
-  if (out_p < bounds_p) {
-    *out_p = '\0';
+    mid_p[(block_n >> PAGE_MAP_BITS) & PAGE_MAP_MASK] = leaf_p;
   }
   
-  return out_p - out;
+  return leaf_p + (block_n & PAGE_MAP_MASK);
 }
 
 /*
- * static void get_pnt_info
+ * static skip_alloc_t *page_map_get
  *
  * DESCRIPTION:
  *
- * With a slot, set a number of pointers to places within the block.
+ * Get the slot in the page map for the block which holds an address.
+ * The entries can be stale so the caller must check that the slot
+ * really is the one that they are interested in.
  *
  * RETURNS:
  *
- * None.
+ * Success - Slot of the free run.
  *
- * ARGUMENTS:
+ * Failure - NULL
  *
- * slot_p -> Pointer to a slot structure that we are getting info on.
+ * ARGUMENTS:
  *
- * info_p <-> Pointer to an info structure that we are filling with
- * information.
+ * address -> Address in the block that we are looking up.
  */
-static	void	get_pnt_info(const skip_alloc_t *slot_p, pnt_info_t *info_p)
+static	skip_alloc_t	*page_map_get(const void *address)
 {
-  info_p->pi_fence_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE);
-  info_p->pi_valloc_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC);
-  info_p->pi_blanked_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
-  
-  info_p->pi_alloc_start = slot_p->sa_mem;
+  skip_alloc_t	**entry_p;
   
-  if (info_p->pi_fence_b) {
-    if (info_p->pi_valloc_b) {
-      info_p->pi_user_start = (char *)info_p->pi_alloc_start + BLOCK_SIZE;
-      info_p->pi_fence_bottom = (char *)info_p->pi_user_start -
-	FENCE_BOTTOM_SIZE;
-    }
-    else {
-      info_p->pi_fence_bottom = info_p->pi_alloc_start;
-      info_p->pi_user_start = (char *)info_p->pi_alloc_start +
-	FENCE_BOTTOM_SIZE;
-    }
-  }
-  else {
-    info_p->pi_fence_bottom = NULL;
-    info_p->pi_user_start = info_p->pi_alloc_start;
+  entry_p = page_map_entry(address, 0 /* don't create */);
+  if (entry_p == NULL) {
+    return NULL;
   }
+  return *entry_p;
+}
+
+/*
+ * static void page_map_set
+ *
+ * DESCRIPTION:
+ *
+ * Set the page map entries for the first and last blocks of a free
+ * run.  If we cannot allocate the map then the run is simply not
+ * merged with its neighbors.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot of the free run.
+ *
+ * value_p -> Value to store in the entries which is the slot itself
+ * or NULL to clear them.
+ */
+static	void	page_map_set(const skip_alloc_t *slot_p, skip_alloc_t *value_p)
+{
+  skip_alloc_t	**entry_p;
   
-  info_p->pi_user_bounds = (char *)info_p->pi_user_start +
-    slot_p->sa_user_size;
-  
-  info_p->pi_alloc_bounds = (char *)slot_p->sa_mem + slot_p->sa_total_size;
-  
-  if (info_p->pi_fence_b) {
-    info_p->pi_fence_top = info_p->pi_user_bounds;
-    info_p->pi_upper_bounds = (char *)info_p->pi_alloc_bounds - FENCE_TOP_SIZE;
+  entry_p = page_map_entry(slot_p->sa_mem, value_p != NULL);
+  if (entry_p != NULL) {
+    *entry_p = value_p;
   }
-  else {
-    info_p->pi_fence_top = NULL;
-    info_p->pi_upper_bounds = info_p->pi_alloc_bounds;
+  entry_p = page_map_entry((char *)slot_p->sa_mem + slot_p->sa_total_size - 1,
+			   value_p != NULL);
+  if (entry_p != NULL) {
+    *entry_p = value_p;
   }
 }
 
 /*
- * static char *display_pnt
+ * static void page_map_fill
  *
  * DESCRIPTION:
  *
- * Write into a buffer a discription of a pointer.
+ * Set the page map entries for all of the blocks of a used allocation
+ * or divided-block.  If we cannot allocate the map then the lookups
+ * fall back to the used list.
  *
  * RETURNS:
  *
- * Pointer to buffer 1st argument.
+ * None.
  *
  * ARGUMENTS:
  *
- * user_pnt -> Pointer that we are displaying.
- *
- * alloc_p -> Pointer to the skip slot which we are displaying.
- *
- * buf <-> Passed in buffer which will be filled with a description of
- * the pointer.
+ * slot_p -> Slot of the used memory.
  *
- * buf_size -> Size of the buffer in bytes.
+ * value_p -> Value to store in the entries which is the slot itself
+ * or NULL to clear them.
  */
-static	char	*display_pnt(const void *user_pnt, const skip_alloc_t *alloc_p,
-			     char *buf, const int buf_size)
+static	void	page_map_fill(const skip_alloc_t *slot_p, skip_alloc_t *value_p)
 {
-  char	*buf_p, *bounds_p;
-  int	elapsed_b;
-  
-  buf_p = buf;
-  bounds_p = buf_p + buf_size;
-  
-  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%#lx",
-			(unsigned long)user_pnt);
-  
-#if LOG_PNT_SEEN_COUNT
-  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|s%lu", alloc_p->sa_seen_c);
-#endif
-  
-#if LOG_PNT_ITERATION
-  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|i%lu",
-			alloc_p->sa_iteration);
-#endif
-  
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ELAPSED_TIME)) {
-    elapsed_b = 1;
-  }
-  else {
-    elapsed_b = 0;
-  }
-  if (elapsed_b || BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_CURRENT_TIME)) {
-#if LOG_PNT_TIMEVAL
-    {
-      char	time_buf[64];
-      buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|w%s",
-			    _dmalloc_ptimeval(&alloc_p->sa_timeval, time_buf,
-					      sizeof(time_buf), elapsed_b));
+  skip_alloc_t	**entry_p;
+  char		*mem_p, *bounds_p;
+  
+  bounds_p = (char *)slot_p->sa_mem + slot_p->sa_total_size;
+  for (mem_p = slot_p->sa_mem; mem_p < bounds_p; mem_p += BLOCK_SIZE) {
+    entry_p = page_map_entry(mem_p, value_p != NULL);
+    if (entry_p != NULL) {
+      *entry_p = value_p;
     }
-#else
-#if LOG_PNT_TIME
-    {
-      char	time_buf[64];
-      buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|w%s",
-			    _dmalloc_ptime(&alloc_p->sa_time, time_buf,
-					   sizeof(time_buf), elapsed_b));
+    else if (value_p != NULL) {
+      return;
     }
-#endif
-#endif
-  }
-  
-#if LOG_PNT_THREAD_ID
-  {
-    char	thread_id[256];
-    
-    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|t");
-    THREAD_ID_TO_STRING(thread_id, sizeof(thread_id), alloc_p->sa_thread_id);
-    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s", thread_id);
   }
-#endif
-  
-  return buf;
 }
 
 /*
- * static void log_error_info
+ * static skip_alloc_t *find_used_slot
  *
  * DESCRIPTION:
  *
- * Logging information about a pointer, usually during an error
- * condition.
- *
- * RETURNS:
- *
- * None.
- *
- * ARGUMENTS:
+ * Look for the slot on the used list which holds an address.  The
+ * page map is tried first.  Its entries can be stale for blocks that
+ * are not in use so the slot it gives us must hold the address.
+ * Otherwise we walk the used list for the addresses in the heap that
+ * the map does not cover such as the admin blocks.
  *
- * now_file -> File from where we generated the error.
+ * NOTE: this does not set the skip_update pointers.
  *
- * now_line -> Line number from where we generated the error.
+ * RETURNS:
  *
- * user_pnt -> Pointer in question.  This can be 0L then it will use
- * the slot_p memory pointer.
+ * Success - Pointer to the slot which holds the address.
  *
- * slot_p -> Pointer to the slot associated with the user_pnt or 0L.
+ * Failure - NULL
  *
- * reason -> Reason string why something happened.
+ * ARGUMENTS:
  *
- * where -> What routine is calling log_error_info.  For instance
- * malloc or chunk_check.
+ * address -> Address we are looking for.
  */
-static	void	log_error_info(const char *now_file,
-			       const unsigned int now_line,
-			       const void *user_pnt,
-			       const skip_alloc_t *slot_p,
-			       const char *reason, const char *where)
+static	skip_alloc_t	*find_used_slot(const void *address)
 {
-  static int	dump_bottom_b = 0, dump_top_b = 0;
-  char		out[(DUMP_SPACE + FENCE_BOTTOM_SIZE + FENCE_TOP_SIZE) * 4];
-  char		where_buf[MAX_FILE_LENGTH + 64];
-  char		where_buf2[MAX_FILE_LENGTH + 64];
-  const char	*prev_file;
-  const void	*dump_pnt = user_pnt;
-  const void	*start_user;
-  unsigned int	prev_line, user_size;
-  skip_alloc_t	*other_p;
-  pnt_info_t	pnt_info;
-  int		out_len, dump_size, offset;
-  
-  if (slot_p == NULL) {
-    prev_file = NULL;
-    prev_line = 0;
-    user_size = 0;
-    start_user = user_pnt;
-  }
-  else {
-    prev_file = slot_p->sa_file;
-    prev_line = slot_p->sa_line;
-    user_size = slot_p->sa_user_size;
-    if (user_pnt == NULL) {
-      get_pnt_info(slot_p, &pnt_info);
-      start_user = pnt_info.pi_user_start;
-    }
-    else {
-      start_user = user_pnt;
-    }
-  }
-  
-  /* get a proper reason string */
-  if (reason != NULL) {
-    dmalloc_message("  error details: %s", reason);
-  }
-  
-  /* dump the pointer information */
-  if (start_user == NULL) {
-    dmalloc_message("  from '%s' prev access '%s'",
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					    now_file, now_line),
-		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
-					    prev_file, prev_line));
-  }
-  else {
-    dmalloc_message("  pointer '%#lx' from '%s' prev access '%s'",
-		    (unsigned long)start_user,
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					    now_file, now_line),
-		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
-					    prev_file, prev_line));
-  }
-  
-  /*
-   * If we aren't logging bad space or we didn't error with an
-   * overwrite error then don't log the bad bytes.
-   */
-  if ((! BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_BAD_SPACE))
-      || (dmalloc_errno != ERROR_UNDER_FENCE
-	  && dmalloc_errno != ERROR_OVER_FENCE
-	  && dmalloc_errno != ERROR_FREE_OVERWRITTEN)) {
-    /* we call the error function after writing more info to the logfile */
-    dmalloc_error(where);
-    return;
-  }
-  
-  /* NOTE: display memory like this has the potential for generating a core */
-  if (dmalloc_errno == ERROR_UNDER_FENCE) {
-    /* NOTE: only dump out the proper fence-post area once */
-    if (! dump_bottom_b) {
-      out_len = expand_chars(fence_bottom, FENCE_BOTTOM_SIZE, out,
-			     sizeof(out));
-      dmalloc_message("  dump of proper fence-bottom bytes: '%.*s'",
-		      out_len, out);
-      dump_bottom_b = 1;
-    }
-    offset = -FENCE_BOTTOM_SIZE;
-    dump_size = DUMP_SPACE + FENCE_BOTTOM_SIZE;
-    if (dump_size > user_size + FENCE_OVERHEAD_SIZE) {
-      dump_size = user_size + FENCE_OVERHEAD_SIZE;
-    }
-  }
-  else if (dmalloc_errno == ERROR_OVER_FENCE
-	   && user_size > 0) {
-    /* NOTE: only dump out the proper fence-post area once */
-    if (! dump_top_b) {
-      out_len = expand_chars(fence_top, FENCE_TOP_SIZE, out, sizeof(out));
-      dmalloc_message("  dump of proper fence-top bytes: '%.*s'",
-		      out_len, out);
-      dump_top_b = 1;
-    }
-    /*
-     * The size includes the bottom fence post area.  We want it to
-     * align with the start of the top fence post area.
-     */
-    if (DUMP_SPACE > user_size + FENCE_OVERHEAD_SIZE) {
-      dump_size = user_size + FENCE_OVERHEAD_SIZE;
-      offset = -FENCE_BOTTOM_SIZE;
-    }
-    else {
-      dump_size = DUMP_SPACE;
-      /* we will go backwards possibly up to FENCE_BOTTOM_SIZE offset */
-      offset = user_size + FENCE_TOP_SIZE - DUMP_SPACE;
-    }
-  }
-  else {
-    dump_size = DUMP_SPACE;
-    offset = 0;
-    if (user_size > 0 && dump_size > user_size) {
-      dump_size = user_size;
-    }
-  }
+  skip_alloc_t	*slot_p;
   
-  dump_pnt = (char *)start_user + offset;
-  if (IS_IN_HEAP(dump_pnt)) {
-    out_len = expand_chars(dump_pnt, dump_size, out, sizeof(out));
-    dmalloc_message("  dump of '%#lx'%+d: '%.*s'",
-		    (unsigned long)start_user, offset, out_len, out);
-  }
-  else {
-    dmalloc_message("  dump of '%#lx'%+d failed: not in heap",
-		    (unsigned long)start_user, offset);
+  slot_p = page_map_get(address);
+  if (slot_p != NULL
+      && (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER)
+	  || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_SLAB))
+      && (char *)slot_p->sa_mem <= (char *)address
+      && (char *)slot_p->sa_mem + slot_p->sa_total_size > (char *)address) {
+    return slot_p;
   }
   
-  /* find the previous pointer in case it ran over */
-  if (dmalloc_errno == ERROR_UNDER_FENCE && start_user != NULL) {
-    other_p = find_address((char *)start_user - FENCE_BOTTOM_SIZE - 1,
-			   0 /* used list */, 1 /* not exact pointer */,
-			   skip_update);
-    if (other_p != NULL) {
-      dmalloc_message("  prev pointer '%#lx' (size %u) may have run over from '%s'",
-		      (unsigned long)other_p->sa_mem, other_p->sa_user_size,
-		      _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					      other_p->sa_file,
-					      other_p->sa_line));
-    }
-  }
-  /* find the next pointer in case it ran under */
-  else if (dmalloc_errno == ERROR_OVER_FENCE
-	   && start_user != NULL
-	   && slot_p != NULL) {
-    other_p = find_address((char *)slot_p->sa_mem + slot_p->sa_total_size,
-			   0 /* used list */, 1 /* not exact pointer */,
-			   skip_update);
-    if (other_p != NULL) {
-      dmalloc_message("  next pointer '%#lx' (size %u) may have run under from '%s'",
-		      (unsigned long)other_p->sa_mem, other_p->sa_user_size,
-		      _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					      other_p->sa_file,
-					      other_p->sa_line));
-    }
+  if (! IS_IN_HEAP(address)) {
+    return NULL;
   }
   
-  /* we call the error function after writing more info to the logfile */
-  dmalloc_error(where);
+  return find_address(address, 0 /* used list */, 0 /* not exact pointer */,
+		      skip_update);
 }
 
 /*
- * static int fence_read
+ * static slab_block_t *find_slab
  *
- * DESCRIPTION
+ * DESCRIPTION:
  *
- * Check a pointer for fence-post magic numbers.
+ * Look for the divided-block which holds an address.
  *
  * RETURNS:
  *
- * Success - 1 if the fence posts are good.
+ * Success - Pointer to the divided-block.
  *
- * Failure - 0 if they are not.
+ * Failure - NULL if the address is not in a divided-block.
  *
  * ARGUMENTS:
  *
- * info_p -> Pointer information that we are checking.
+ * address -> Address we are looking for.
  */
-static	int	fence_read(const pnt_info_t *info_p)
+static	slab_block_t	*find_slab(const void *address)
 {
-  /* check magic numbers in bottom of allocation block */
-  if (memcmp(fence_bottom, info_p->pi_fence_bottom, FENCE_BOTTOM_SIZE) != 0) {
-    dmalloc_errno = ERROR_UNDER_FENCE;
-    return 0;
-  }
+  skip_alloc_t	*slot_p;
   
-  /* check numbers at top of allocation block */
-  if (memcmp(fence_top, info_p->pi_fence_top, FENCE_TOP_SIZE) != 0) {
-    dmalloc_errno = ERROR_OVER_FENCE;
-    return 0;
+  slot_p = find_used_slot(address);
+  if (slot_p == NULL || (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_SLAB))) {
+    return NULL;
   }
   
-  return 1;
+  /* the slot is at the front of the divided-block structure */
+  return (slab_block_t *)slot_p;
 }
 
 /*
- * static void clear_alloc
+ * static skip_alloc_t *find_user_slot
  *
- * DESCRIPTION
+ * DESCRIPTION:
  *
- * Setup allocations by writing fence post and doing any necessary
- * clearing of memory.
+ * Look for an address on the used list.  If the address is inside of
+ * a divided-block then the slot of the chunk which holds it is
+ * returned instead of the slot for the whole block.
  *
  * RETURNS:
  *
- * Success - 1 if the fence posts are good.
+ * Success - Pointer to the slot which holds the address.
  *
- * Failure - 0 if they are not.
+ * Failure - NULL if the address is not in a used allocation.
  *
  * ARGUMENTS:
  *
- * slot_p <-> Slot we are clearing.
- *
- * info_p -> Pointer to information about the allocation.
+ * address -> Address we are looking for.
  *
- * old_size -> If there was an old-size that we have copied into the
- * new pointer then set this.  If 0 then it will clear the entire
- * allocation.
- *
- * func_id -> ID of the function which is doing the allocation.  Used
- * to determine if we should 0 memory for [re]calloc.
+ * exact_b -> Set to 1 to find the exact pointer.  If 0 then the
+ * address could be inside a block.
  */
-static	void	clear_alloc(skip_alloc_t *slot_p, pnt_info_t *info_p,
-			    const unsigned int old_size, const int func_id)
+static	skip_alloc_t	*find_user_slot(const void *address, const int exact_b)
 {
-  char	*start_p;
-  int	num;
-  
-  /*
-   * NOTE: The alloc blank flag is set so we blank a slot when it is
-   * allocated.  It used to be that the allocated spaces were blanked
-   * and the free spaces of the allocated chunk were blanked only if
-   * the FREE_BLANK flag was enabled.  Wrong!
-   */
+  skip_alloc_t	*slot_p;
+  slab_block_t	*slab_p;
   
-  /*
-   * Set our slot blank flag if the flags are set now.  This will
-   * carry over with a realloc.
-   */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_ALLOC_BLANK)
-      || BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK)) {
-    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
+  slot_p = find_used_slot(address);
+  if (slot_p == NULL) {
+    return NULL;
   }
   
-  /*
-   * If we have a fence post protected valloc then there is almost a
-   * full block at the front what is "free".  Set it with blank chars.
-   */
-  if (info_p->pi_fence_b) {
-    num = (char *)info_p->pi_fence_bottom - (char *)info_p->pi_alloc_start;
-    /* alloc-blank NOT free-blank */
-    if (num > 0 && BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
-      memset(info_p->pi_alloc_start, ALLOC_BLANK_CHAR, num);
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_SLAB)) {
+    slab_p = (slab_block_t *)slot_p;
+    slot_p = SLAB_CHUNK(slab_p, address);
+    /* the free chunks are in the block but are not on the used list */
+    if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER)) {
+      return NULL;
     }
   }
   
-  /*
-   * If we are allocating or extending memory, write in our alloc
-   * chars.
-   */
-  start_p = (char *)info_p->pi_user_start + old_size;
-  
-  num = (char *)info_p->pi_user_bounds - start_p;
-  if (num > 0) {
-    if (func_id == DMALLOC_FUNC_CALLOC || func_id == DMALLOC_FUNC_RECALLOC) {
-      memset(start_p, 0, num);
-    }
-    else if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
-      memset(start_p, ALLOC_BLANK_CHAR, num);
-    }
+  if (exact_b && slot_p->sa_mem != address) {
+    return NULL;
   }
   
-  /* write in fence-post info */
-  if (info_p->pi_fence_b) {
-    memcpy(info_p->pi_fence_bottom, fence_bottom, FENCE_BOTTOM_SIZE);
-    memcpy(info_p->pi_fence_top, fence_top, FENCE_TOP_SIZE);
-  }
+  return slot_p;
+}
+
+/*
+ * static skip_alloc_t *heap_walk_next
+ *
+ * DESCRIPTION:
+ *
+ * Get the next slot in a walk through all of the used, free, and
+ * waiting slots in the heap.  The divided-blocks on the used list are
+ * expanded into the slots of each of their chunks.  The chunks on the
+ * wait list are skipped because they are seen in their blocks.
+ *
+ * RETURNS:
+ *
+ * Success - Valid slot pointer.
+ *
+ * Failure - NULL when the walk is done.
+ *
+ * ARGUMENTS:
+ *
+ * walk_p <-> Pointer to the walk structure which holds our place.  It
+ * should be zeroed before the first call.
+ */
+static	skip_alloc_t	*heap_walk_next(heap_walk_t *walk_p)
+{
+  skip_alloc_t	*slot_p;
+  slab_block_t	*slab_p;
   
-  /*
-   * Now clear the rest of the block above any fence post space with
-   * free characters.
-   *
-   * NOTE alloc-blank NOT free-blank
-   */
-  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+  while (1) {
     
-    if (info_p->pi_fence_b) {
-      start_p = (char *)info_p->pi_fence_top + FENCE_TOP_SIZE;
+    /* are we in the middle of the chunks of a divided-block? */
+    slab_p = walk_p->hw_slab_p;
+    if (slab_p != NULL) {
+      if (walk_p->hw_chunk_c < slab_p->sb_chunk_n) {
+	slot_p = slab_p->sb_chunks + walk_p->hw_chunk_c;
+	walk_p->hw_chunk_c++;
+	return slot_p;
+      }
+      walk_p->hw_slab_p = NULL;
+    }
+    
+    if (walk_p->hw_slot_p == NULL) {
+      /* start up the next list */
+      switch (walk_p->hw_list_c) {
+      case HEAP_WALK_USED:
+	slot_p = skip_address_list->sa_next_p[0];
+	break;
+      case HEAP_WALK_FREE:
+	slot_p = skip_free_list->sa_next_p[0];
+	break;
+      case HEAP_WALK_WAIT:
+	slot_p = free_wait_list_head;
+	break;
+      default:
+	/* we are done */
+	return NULL;
+      }
     }
     else {
-      start_p = info_p->pi_user_bounds;
+      slot_p = walk_p->hw_slot_p->sa_next_p[0];
     }
     
-    num = (char *)info_p->pi_alloc_bounds - start_p;
-    if (num > 0) {
-      memset(start_p, ALLOC_BLANK_CHAR, num);
+    walk_p->hw_slot_p = slot_p;
+    if (slot_p == NULL) {
+      walk_p->hw_list_c++;
+      continue;
+    }
+    walk_p->hw_mem = slot_p->sa_mem;
+    walk_p->hw_size = slot_p->sa_total_size;
+    
+    if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_SLAB)) {
+      walk_p->hw_slab_p = (slab_block_t *)slot_p;
+      walk_p->hw_chunk_c = 0;
+      continue;
+    }
+    if (walk_p->hw_list_c == HEAP_WALK_WAIT
+	&& BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED)) {
+      continue;
     }
+    
+    return slot_p;
   }
 }
 
-/************************** administration functions *************************/
-
 /*
- * static int create_divided_chunks
+ * static void heap_walk_resume
  *
  * DESCRIPTION:
  *
- * Get a divided-block from the free list or heap allocation.
+ * Find our place again in a heap walk that was put aside while the
+ * library was handing out and taking back memory.  The slot that we
+ * were on may be gone so we look up where it was on the used and free
+ * lists and go on from there.  The wait list is only taken from at
+ * the front so if our slot is no longer on it we start at its front.
  *
  * RETURNS:
  *
- * Success - 1
- *
- * Failure - 0
+ * None.
  *
  * ARGUMENTS:
  *
- * div_size -> Size of the divided block that we are allocating.
+ * walk_p <-> Pointer to the walk structure which holds our place.
  */
-static	int	create_divided_chunks(const unsigned int div_size)
+static	void	heap_walk_resume(heap_walk_t *walk_p)
 {
-  void		*mem, *bounds_p;
+  skip_alloc_t	*prev_p, *next_p, key;
   
-  /* allocate a 1 block chunk that we will cut up into pieces */
-  mem = _dmalloc_heap_alloc(BLOCK_SIZE);
-  if (mem == HEAP_ALLOC_ERROR) {
-    /* error code set in _dmalloc_heap_alloc */
-    return 0;
+  /* are we at the start of a list? */
+  if (walk_p->hw_slot_p == NULL) {
+    return;
   }
-  user_block_c++;
-  
-  /*
-   * now run through the block and add the the locations to the
-   * free-list
-   */
   
-  /* end of the block */
-  bounds_p = (char *)mem + BLOCK_SIZE - div_size;
-  
-  for (; mem <= bounds_p; mem = (char *)mem + div_size) {
-    /* insert the rest of the blocks into the free-list */
-    if (insert_address(mem, 1 /* free list */, div_size) == NULL) {
-      /* error set in insert_address */
-      return 0;
+  switch (walk_p->hw_list_c) {
+  case HEAP_WALK_USED:
+    (void)find_address(walk_p->hw_mem, 0 /* used list */, 1 /* exact */,
+		       skip_update);
+    break;
+  case HEAP_WALK_FREE:
+    key.sa_mem = walk_p->hw_mem;
+    key.sa_total_size = walk_p->hw_size;
+    (void)find_free_slot(&key, skip_update);
+    break;
+  case HEAP_WALK_WAIT:
+    if (! BIT_IS_SET(walk_p->hw_slot_p->sa_flags, ALLOC_FLAG_WAIT)) {
+      walk_p->hw_slot_p = NULL;
     }
-    free_space_bytes += div_size;
+    return;
+  default:
+    return;
   }
   
-  return 1;
+  /* go on after our slot if it is still there or after the one below it */
+  prev_p = skip_update->sa_next_p[0];
+  next_p = prev_p->sa_next_p[0];
+  if (next_p != NULL && next_p->sa_mem == walk_p->hw_mem) {
+    prev_p = next_p;
+  }
+  
+  /* if we were in a divided-block, it has to be the same one */
+  if ((skip_alloc_t *)walk_p->hw_slab_p != prev_p
+      || (! BIT_IS_SET(prev_p->sa_flags, ALLOC_FLAG_SLAB))) {
+    walk_p->hw_slab_p = NULL;
+  }
+  walk_p->hw_slot_p = prev_p;
 }
 
+/******************************* misc routines *******************************/
+
 /*
- * static skip_alloc_t *use_free_memory
+ * static int expand_chars
  *
  * DESCRIPTION:
  *
- * Find a free memory chunk and remove it from the free list and put
- * it on the used list if available.
+ * Copies a buffer into a output buffer while translates
+ * non-printables into %03o octal values.  If it can, it will also
+ * translate certain \ characters (\r, \n, etc.) into \\%c.  The
+ * routine is useful for printing out binary values.
  *
- * RETURNS:
+ * Note: It does _not_ add a \0 at the end of the output buffer.
  *
- * Success - Valid slot pointer
+ * RETURNS:
  *
- * Failure - NULL
+ * Returns the number of characters added to the output buffer.
  *
  * ARGUMENTS:
  *
- * size -> Size of the block that we are looking for.
+ * buf - the buffer to convert.
  *
- * update_p -> Pointer to the skip_alloc entry we are using to hold
- * the update pointers.
+ * buf_size - size of the buffer.  If < 0 then it will expand till it
+ * sees a \0 character.
+ *
+ * out - destination buffer for the convertion.
+ *
+ * out_size - size of the output buffer.
  */
-static	skip_alloc_t	*use_free_memory(const unsigned int size,
-					 skip_alloc_t *update_p)
+static	int	expand_chars(const void *buf, const int buf_size,
+			     char *out, const int out_size)
 {
-  skip_alloc_t	*slot_p;
+  const unsigned char	*buf_p, *spec_p;
+  char	 		*out_p = out, *bounds_p;
   
-#if FREED_POINTER_DELAY
-  /*
-   * check the free wait list to see if any of the waiting pointers
-   * need to be moved off and inserted into the free list
-   */
-  for (slot_p = free_wait_list_head; slot_p != NULL; ) {
-    skip_alloc_t	*next_p;
+  /* setup our max pointer */
+  bounds_p = out + out_size;
+  
+  /* run through the input buffer, counting the characters as we go */
+  for (buf_p = (const unsigned char *)buf;
+       buf_p < (const unsigned char *)buf + buf_size;
+       buf_p++) {
     
-    /* we are done if we find a pointer delay in the future */
-    if (slot_p->sa_use_iter + FREED_POINTER_DELAY > _dmalloc_iter_c) {
-      break;
+    /* search for special characters */
+    for (spec_p = (unsigned char *)SPECIAL_CHARS + 1;
+	 *(spec_p - 1) != '\0';
+	 spec_p += 2) {
+      if (*spec_p == *buf_p) {
+	break;
+      }
     }
     
-    /* put slot on free list */
-    next_p = slot_p->sa_next_p[0];
-    if (! insert_slot(slot_p, 1 /* free list */)) {
-      /* error dumped in insert_slot */
-      return NULL;
+    /* did we find one? */
+    if (*(spec_p - 1) != '\0') {
+      if (out_p + 2 >= bounds_p) {
+	break;
+      }
+      out_p += loc_snprintf(out_p, bounds_p - out_p, "\\%c", *(spec_p - 1));
+      continue;
     }
     
-    /* adjust our linked list */
-    slot_p = next_p;
-    free_wait_list_head = slot_p;
-    if (slot_p == NULL) {
-      free_wait_list_tail = NULL;
+    /* print out any 7-bit printable characters */
+    if (*buf_p < 128 && isprint(*buf_p)) {
+      if (out_p + 1 >= bounds_p) {
+	break;
+      }
+      *out_p = *(char *)buf_p;
+      out_p += 1;
+    }
+    else {
+      if (out_p + 4 >= bounds_p) {
+	break;
+      }
+      out_p += loc_snprintf(out_p, bounds_p - out_p, "\\%03o", *buf_p);
     }
   }
-#endif
-  
-  /* find a free block which matches the size */ 
-  slot_p = find_free_size(size, update_p);
-  if (slot_p == NULL) {
-    return NULL;
-  }
-  
-  /* sanity check */
-  if (slot_p->sa_total_size != size) {
-    dmalloc_errno = ERROR_ADDRESS_LIST;
-    dmalloc_error("use_free_memory");
-    return NULL;
-  }
-  
-  /* remove from free list */
-  if (! remove_slot(slot_p, update_p)) {
-    /* error reported in remove_slot */
-    return NULL;
-  }
-  
-  /* set to user allocated space */
-  slot_p->sa_flags = ALLOC_FLAG_USER;
-  
-  /* insert it into our address list */
-  if (! insert_slot(slot_p, 0 /* used list */)) {
-    /* error set in insert_slot */
-    return NULL;
+  /* try to punch the null if we have space in case the %.*s doesn't work */
+  if (out_p < bounds_p) {
+    *out_p = '\0';
   }
   
-  free_space_bytes -= slot_p->sa_total_size;
-  
-  return slot_p;
+  return out_p - out;
 }
 
 /*
- * static skip_alloc_t *get_divided_memory
+ * static void get_pnt_info
  *
  * DESCRIPTION:
  *
- * Get a divided memory block from the free list or heap allocation.
+ * With a slot, set a number of pointers to places within the block.
  *
  * RETURNS:
  *
- * Success - Valid skip slot pointer.
- *
- * Failure - NULL
+ * None.
  *
  * ARGUMENTS:
  *
- * size -> Size of the block that we are allocating.
+ * slot_p -> Pointer to a slot structure that we are getting info on.
+ *
+ * info_p <-> Pointer to an info structure that we are filling with
+ * information.
  */
-static	skip_alloc_t	*get_divided_memory(const unsigned int size)
+static	void	get_pnt_info(const skip_alloc_t *slot_p, pnt_info_t *info_p)
 {
-  skip_alloc_t	*slot_p;
-  unsigned int	need_size;
-  int		*bits_p;
+  info_p->pi_fence_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE);
+  info_p->pi_valloc_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC);
+  info_p->pi_blanked_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
+  info_p->pi_guard_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_GUARD);
   
-  for (bits_p = bit_sizes;; bits_p++) {
-    if (*bits_p >= size) {
-      break;
-    }
-  }
-  need_size = *bits_p;
+  info_p->pi_alloc_start = slot_p->sa_mem;
   
-  /* find a free block which matches the size */ 
-  slot_p = use_free_memory(need_size, skip_update);
-  if (slot_p != NULL) {
-    return slot_p;
+  if (info_p->pi_fence_b) {
+    if (info_p->pi_valloc_b) {
+      info_p->pi_user_start = (char *)info_p->pi_alloc_start + BLOCK_SIZE;
+      info_p->pi_fence_bottom = (char *)info_p->pi_user_start -
+	FENCE_BOTTOM_SIZE;
+    }
+    else if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ALIGNED)) {
+      info_p->pi_user_start = (char *)info_p->pi_alloc_start +
+	slot_p->sa_align_off;
+      info_p->pi_fence_bottom = (char *)info_p->pi_user_start -
+	FENCE_BOTTOM_SIZE;
+    }
+    else {
+      info_p->pi_fence_bottom = info_p->pi_alloc_start;
+      info_p->pi_user_start = (char *)info_p->pi_alloc_start +
+	FENCE_BOTTOM_SIZE;
+    }
   }
-  
-  /* need to get more slots */
-  if (! create_divided_chunks(need_size)) {
-    /* errors dumped in  create_divided_chunks */
-    return NULL;
+  else if (info_p->pi_guard_b) {
+    /* the user pointer is pushed up against the guard page */
+    info_p->pi_fence_bottom = NULL;
+    info_p->pi_user_start = (char *)info_p->pi_alloc_start +
+      slot_p->sa_align_off;
+  }
+  else {
+    info_p->pi_fence_bottom = NULL;
+    info_p->pi_user_start = info_p->pi_alloc_start;
   }
   
-  /* now we ask again for the free memory */
-  slot_p = use_free_memory(need_size, skip_update);
-  if (slot_p == NULL) {
-    /* huh?  This isn't right. */
-    dmalloc_errno = ERROR_ADDRESS_LIST;
-    dmalloc_error("get_divided_memory");
-    return NULL;
+  info_p->pi_user_bounds = (char *)info_p->pi_user_start +
+    slot_p->sa_user_size;
+  
+  info_p->pi_alloc_bounds = (char *)slot_p->sa_mem + slot_p->sa_total_size;
+  if (info_p->pi_guard_b) {
+    info_p->pi_alloc_bounds = (char *)info_p->pi_alloc_bounds - BLOCK_SIZE;
   }
   
-  return slot_p;
+  if (info_p->pi_fence_b) {
+    info_p->pi_fence_top = info_p->pi_user_bounds;
+    info_p->pi_upper_bounds = (char *)info_p->pi_alloc_bounds - FENCE_TOP_SIZE;
+  }
+  else {
+    info_p->pi_fence_top = NULL;
+    info_p->pi_upper_bounds = info_p->pi_alloc_bounds;
+  }
 }
 
 /*
- * static skip_alloc_t *get_memory
+ * static char *display_pnt
  *
  * DESCRIPTION:
  *
- * Get a block from the free list or heap allocation.
+ * Write into a buffer a discription of a pointer.
  *
  * RETURNS:
  *
- * Success - Valid skip slot pointer.
- *
- * Failure - NULL
+ * Pointer to buffer 1st argument.
  *
  * ARGUMENTS:
  *
- * size -> Size of the block that we are allocating.
+ * user_pnt -> Pointer that we are displaying.
+ *
+ * alloc_p -> Pointer to the skip slot which we are displaying.
+ *
+ * buf <-> Passed in buffer which will be filled with a description of
+ * the pointer.
+ *
+ * buf_size -> Size of the buffer in bytes.
  */
-static	skip_alloc_t	*get_memory(const unsigned int size)
+static	char	*display_pnt(const void *user_pnt, const skip_alloc_t *alloc_p,
+			     char *buf, const int buf_size)
 {
-  skip_alloc_t	*slot_p, *update_p;
-  void		*mem;
-  unsigned int	need_size, block_n;
-  
-  /* do we need to print admin info? */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
-    dmalloc_message("need %d bytes", size);
-  }
+  char	*buf_p, *bounds_p;
+  int	elapsed_b;
   
-  /* will this allocate put us over the limit? */
-  if (_dmalloc_memory_limit > 0
-      && alloc_cur_given + size > _dmalloc_memory_limit) {
-    dmalloc_errno = ERROR_OVER_LIMIT;
-    dmalloc_error("get_memory");
-    return NULL;
-  }
+  buf_p = buf;
+  bounds_p = buf_p + buf_size;
   
-  /* do we have a divided block here? */
-  if (size <= BLOCK_SIZE / 2) {
-    return get_divided_memory(size);
-  }
+  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%#lx",
+			(unsigned long)user_pnt);
   
-  /* round up to the nearest block size */
-  need_size = size + BLOCK_SIZE - 1;
-  block_n = need_size / BLOCK_SIZE;
-  need_size = block_n * BLOCK_SIZE;
+#if LOG_PNT_SEEN_COUNT
+  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|s%lu", alloc_p->sa_seen_c);
+#endif
   
-  update_p = skip_update;
+#if LOG_PNT_ITERATION
+  buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|i%lu",
+			alloc_p->sa_iteration);
+#endif
   
-  /* find a free block which matches the size */ 
-  slot_p = use_free_memory(need_size, update_p);
-  if (slot_p != NULL) {
-    return slot_p;
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ELAPSED_TIME)) {
+    elapsed_b = 1;
   }
-  
-  /* if there are blocks that are larger than this */
-  slot_p = update_p->sa_next_p[0];
-  if (slot_p != NULL && slot_p->sa_total_size > size) {
-    
-    /*
-     * now we ask again for the memory because we need to reset the
-     * update pointer list
-     */
-    slot_p = use_free_memory(need_size, update_p);
-    if (slot_p != NULL) {
-      /* huh?  This isn't right. */
-      dmalloc_errno = ERROR_ADDRESS_LIST;
-      dmalloc_error("get_memory");
-      return NULL;
-    }
+  else {
+    elapsed_b = 0;
   }
-  
-  /* allocate the memory necessary for the new blocks */
-  mem = _dmalloc_heap_alloc(need_size);
-  if (mem == HEAP_ALLOC_ERROR) {
-    /* error code set in _dmalloc_heap_alloc */
-    return NULL;
+  if (elapsed_b || BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_CURRENT_TIME)) {
+#if LOG_PNT_TIMEVAL
+    {
+      char	time_buf[64];
+      buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|w%s",
+			    _dmalloc_ptimeval(&alloc_p->sa_timeval, time_buf,
+					      sizeof(time_buf), elapsed_b));
+    }
+#else
+#if LOG_PNT_TIME
+    {
+      char	time_buf[64];
+      buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|w%s",
+			    _dmalloc_ptime(&alloc_p->sa_time, time_buf,
+					   sizeof(time_buf), elapsed_b));
+    }
+#endif
+#endif
   }
-  user_block_c += block_n;
   
-  /* create our slot */
-  slot_p = insert_address(mem, 0 /* used list */, need_size);
-  if (slot_p == NULL) {
-    /* error set in insert_address */
-    return NULL;
+#if LOG_PNT_THREAD_ID
+  {
+    char	thread_id[256];
+    
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "|t");
+    THREAD_ID_TO_STRING(thread_id, sizeof(thread_id), alloc_p->sa_thread_id);
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s", thread_id);
   }
+#endif
   
-  return slot_p;
+  return buf;
 }
 
 /*
- * static int check_used_slot
+ * static void log_error_info
  *
- * Check out the pointer in a allocated slot to make sure it is good.
+ * DESCRIPTION:
  *
- * RETURNS:
+ * Logging information about a pointer, usually during an error
+ * condition.
  *
- * Success - 1
+ * RETURNS:
  *
- * Failure - 0
+ * None.
  *
  * ARGUMENTS:
  *
- * slot_p -> Slot that we are checking.
+ * now_file -> File from where we generated the error.
  *
- * user_pnt -> User pointer which was used to get the slot or NULL.
+ * now_line -> Line number from where we generated the error.
  *
- * exact_b -> Set to 1 to find the pointer specifically.  Otherwise we
- * can find the pointer inside of an allocation.
+ * user_pnt -> Pointer in question.  This can be 0L then it will use
+ * the slot_p memory pointer.
  *
- * strlen_b -> Make sure that pnt can hold at least a strlen + 1
- * bytes.  If 0 then ignore.
+ * slot_p -> Pointer to the slot associated with the user_pnt or 0L.
  *
- * min_size -> Make sure that pnt can hold at least that many bytes.
- * If 0 then ignore.
+ * reason -> Reason string why something happened.
+ *
+ * where -> What routine is calling log_error_info.  For instance
+ * malloc or chunk_check.
  */
-static	int	check_used_slot(const skip_alloc_t *slot_p,
-				const void *user_pnt, const int exact_b,
-				const int strlen_b, const int min_size)
+static	void	log_error_info(const char *now_file,
+			       const unsigned int now_line,
+			       const void *user_pnt,
+			       const skip_alloc_t *slot_p,
+			       const char *reason, const char *where)
 {
-  const char	*file, *name_p, *bounds_p, *mem_p;
-  unsigned int	line, num;
+  static int	dump_bottom_b = 0, dump_top_b = 0;
+  char		out[(DUMP_SPACE + FENCE_BOTTOM_SIZE + FENCE_TOP_SIZE) * 4];
+  char		where_buf[MAX_FILE_LENGTH + 64];
+  char		where_buf2[MAX_FILE_LENGTH + 64];
+  const char	*prev_file;
+  const void	*dump_pnt = user_pnt;
+  const void	*start_user;
+  unsigned int	prev_line, user_size;
+  skip_alloc_t	*other_p;
   pnt_info_t	pnt_info;
+  int		out_len, dump_size, offset;
   
-  if (! (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER)
-	 || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_EXTERN)
-	 || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ADMIN))) {
-    dmalloc_errno = ERROR_SLOT_CORRUPT;
-    return 0;
+  if (slot_p == NULL) {
+    prev_file = NULL;
+    prev_line = 0;
+    user_size = 0;
+    start_user = user_pnt;
   }
-  
-  /* get pointer info */
-  get_pnt_info(slot_p, &pnt_info);
-  
-  /* the user pointer needs to be within the user space */
-  if (user_pnt != NULL && (char *)user_pnt < (char *)pnt_info.pi_user_start) {
-    dmalloc_errno = ERROR_WOULD_OVERWRITE;
-    return 0;
+  else {
+    prev_file = slot_p->sa_file;
+    prev_line = slot_p->sa_line;
+    user_size = slot_p->sa_user_size;
+    if (user_pnt == NULL) {
+      get_pnt_info(slot_p, &pnt_info);
+      start_user = pnt_info.pi_user_start;
+    }
+    else {
+      start_user = user_pnt;
+    }
   }
   
-  /* if we need the exact pointer, make sure that the user_pnt agrees */
-  if (exact_b && user_pnt != pnt_info.pi_user_start) {
-    dmalloc_errno = ERROR_NOT_START_BLOCK;
-    return 0;
+  /* get a proper reason string */
+  if (reason != NULL) {
+    dmalloc_message("  error details: %s", reason);
   }
   
-#if LARGEST_ALLOCATION
-  /* have we exceeded the upper bounds */
-  if (slot_p->sa_user_size > LARGEST_ALLOCATION) {
-    dmalloc_errno = ERROR_BAD_SIZE;
-    return 0;
+  /* dump the pointer information */
+  if (start_user == NULL) {
+    dmalloc_message("  from '%s' prev access '%s'",
+		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					    now_file, now_line),
+		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
+					    prev_file, prev_line));
   }
-#endif
-  
-  /* check our total block size */
-  if (slot_p->sa_total_size > BLOCK_SIZE / 2
-      && slot_p->sa_total_size % BLOCK_SIZE != 0) {
-    dmalloc_errno = ERROR_BAD_SIZE;
-    return 0;
+  else {
+    dmalloc_message("  pointer '%#lx' from '%s' prev access '%s'",
+		    (unsigned long)start_user,
+		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					    now_file, now_line),
+		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
+					    prev_file, prev_line));
   }
   
   /*
-   * If we have a valloc allocation then the _user_ pnt should be
-   * block aligned otherwise the chunk_pnt should be.
+   * If we aren't logging bad space or we didn't error with an
+   * overwrite error then don't log the bad bytes.
    */
-  if (pnt_info.pi_valloc_b) {
-    
-    if ((long)pnt_info.pi_user_start % BLOCK_SIZE != 0) {
-      dmalloc_errno = ERROR_NOT_ON_BLOCK;
-      return 0;
-    }
-    if (slot_p->sa_total_size < BLOCK_SIZE) {
-      dmalloc_errno = ERROR_SLOT_CORRUPT;
-      return 0;
-    }
-    
-    /* now check the below space to make sure it is still clear */
-    if (pnt_info.pi_fence_b && pnt_info.pi_blanked_b) {
-      num = (char *)pnt_info.pi_fence_bottom - (char *)pnt_info.pi_alloc_start;
-      if (num > 0) {
-	for (mem_p = pnt_info.pi_alloc_start;
-	     mem_p < (char *)pnt_info.pi_fence_bottom;
-	     mem_p++) {
-	  if (*mem_p != ALLOC_BLANK_CHAR) {
-	    dmalloc_errno = ERROR_FREE_OVERWRITTEN;
-	    return 0;
-	  }
-	}
-      }
-    }
+  if ((! BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_BAD_SPACE))
+      || (dmalloc_errno != ERROR_UNDER_FENCE
+	  && dmalloc_errno != ERROR_OVER_FENCE
+	  && dmalloc_errno != ERROR_FREE_OVERWRITTEN)) {
+    /* we call the error function after writing more info to the logfile */
+    dmalloc_error(where);
+    return;
   }
   
-  /* check out the fence-posts */
-  if (pnt_info.pi_fence_b && (! fence_read(&pnt_info))) {
-    /* errno set in fence_read */
-    return 0;
+  /* NOTE: display memory like this has the potential for generating a core */
+  if (dmalloc_errno == ERROR_UNDER_FENCE) {
+    /* NOTE: only dump out the proper fence-post area once */
+    if (! dump_bottom_b) {
+      out_len = expand_chars(fence_bottom, FENCE_BOTTOM_SIZE, out,
+			     sizeof(out));
+      dmalloc_message("  dump of proper fence-bottom bytes: '%.*s'",
+		      out_len, out);
+      dump_bottom_b = 1;
+    }
+    offset = -FENCE_BOTTOM_SIZE;
+    dump_size = DUMP_SPACE + FENCE_BOTTOM_SIZE;
+    if (dump_size > user_size + FENCE_OVERHEAD_SIZE) {
+      dump_size = user_size + FENCE_OVERHEAD_SIZE;
+    }
   }
-  
-  /* check above the allocation to see if it's been overwritten */
-  if (pnt_info.pi_blanked_b) {
-    
-    if (pnt_info.pi_fence_b) {
-      mem_p = (char *)pnt_info.pi_fence_top + FENCE_TOP_SIZE;
+  else if (dmalloc_errno == ERROR_OVER_FENCE
+	   && user_size > 0) {
+    /* NOTE: only dump out the proper fence-post area once */
+    if (! dump_top_b) {
+      out_len = expand_chars(fence_top, FENCE_TOP_SIZE, out, sizeof(out));
+      dmalloc_message("  dump of proper fence-top bytes: '%.*s'",
+		      out_len, out);
+      dump_top_b = 1;
+    }
+    /*
+     * The size includes the bottom fence post area.  We want it to
+     * align with the start of the top fence post area.
+     */
+    if (DUMP_SPACE > user_size + FENCE_OVERHEAD_SIZE) {
+      dump_size = user_size + FENCE_OVERHEAD_SIZE;
+      offset = -FENCE_BOTTOM_SIZE;
     }
     else {
-      mem_p = pnt_info.pi_user_bounds;
+      dump_size = DUMP_SPACE;
+      /* we will go backwards possibly up to FENCE_BOTTOM_SIZE offset */
+      offset = user_size + FENCE_TOP_SIZE - DUMP_SPACE;
     }
-    
-    for (; mem_p < (char *)pnt_info.pi_alloc_bounds; mem_p++) {
-      if (*mem_p != ALLOC_BLANK_CHAR) {
-	dmalloc_errno = ERROR_FREE_OVERWRITTEN;
-	return 0;
-      }
+  }
+  else if (dmalloc_errno == ERROR_FREE_OVERWRITTEN
+	   && slot_p != NULL && overwrite_p != NULL
+	   && overwrite_p >= (char *)slot_p->sa_mem
+	   && overwrite_p < (char *)slot_p->sa_mem + slot_p->sa_total_size) {
+    /* start the dump at the first byte that the blank check found */
+    offset = overwrite_p - (char *)start_user;
+    dump_size = MIN(DUMP_SPACE,
+		    (char *)slot_p->sa_mem + slot_p->sa_total_size
+		    - overwrite_p);
+  }
+  else {
+    dump_size = DUMP_SPACE;
+    offset = 0;
+    if (user_size > 0 && dump_size > user_size) {
+      dump_size = user_size;
     }
   }
-
-  file = slot_p->sa_file;
-  line = slot_p->sa_line;
   
-  /* check line number */
-#if MAX_LINE_NUMBER
-  if (line > MAX_LINE_NUMBER) {
-    dmalloc_errno = ERROR_BAD_LINE;
-    return 0;
-  }
-#endif
+  dump_pnt = (char *)start_user + offset;
   
-  /*
-   * Check file pointer only if file is not NULL and line is not 0
-   * which implies that file is a return-addr.
-   */
-#if MAX_FILE_LENGTH
-  if (file != DMALLOC_DEFAULT_FILE && line != DMALLOC_DEFAULT_LINE) {
-    /* NOTE: we don't use strlen here because we might check too far */
-    bounds_p = file + MAX_FILE_LENGTH;
-    for (name_p = file; name_p <= bounds_p && *name_p != '\0'; name_p++) {
-    }
-    if (name_p > bounds_p
-	|| name_p < file + MIN_FILE_LENGTH) {
-      dmalloc_errno = ERROR_BAD_FILE;
-      return 0;
+  /* we cannot dump the guard page of a guarded allocation */
+  if (slot_p != NULL && BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_GUARD)) {
+    get_pnt_info(slot_p, &pnt_info);
+    if ((char *)dump_pnt + dump_size > (char *)pnt_info.pi_alloc_bounds) {
+      dump_size = MAX((char *)pnt_info.pi_alloc_bounds - (char *)dump_pnt, 0);
     }
   }
-#endif
-  
-#if LOG_PNT_SEEN_COUNT
-  /*
-   * We divide by 2 here because realloc which returns the same
-   * pointer will seen_c += 2.  However, it will never be more than
-   * twice the iteration value.  We divide by two to not overflow
-   * iter_c * 2.
-   */
-  if (slot_p->sa_seen_c / 2 > _dmalloc_iter_c) {
-    dmalloc_errno = ERROR_SLOT_CORRUPT;
-    return 0;
+  if (IS_IN_HEAP(dump_pnt)) {
+    out_len = expand_chars(dump_pnt, dump_size, out, sizeof(out));
+    dmalloc_message("  dump of '%#lx'%+d: '%.*s'",
+		    (unsigned long)start_user, offset, out_len, out);
+  }
+  else {
+    dmalloc_message("  dump of '%#lx'%+d failed: not in heap",
+		    (unsigned long)start_user, offset);
   }
-#endif
   
-  if (strlen_b) {
-    int	equals_okay_b = 0;
-    mem_p = (char *)user_pnt;
-    if (min_size > 0) {
-      bounds_p = mem_p + min_size;
-      /* min_size can be out of bounds as long as we find a \0 beforehand */
-      if (bounds_p > (char *)pnt_info.pi_user_bounds) {
-	bounds_p = (char *)pnt_info.pi_user_bounds;
-      } else {
-	/* we can equals our boundary if our min_size <= user_bounds */
-	equals_okay_b = 1;
-      }
-    } else {
-      bounds_p = (char *)pnt_info.pi_user_bounds;
-    }
-    for (; mem_p < bounds_p; mem_p++) {
-      if (*mem_p == '\0') {
-	break;
-      }
-    }
-    /* mem_p can == bounds_p if we hit the min_size but can't >= user_bounds*/ 
-    if (mem_p > (char *)pnt_info.pi_user_bounds
-	|| ((! equals_okay_b) && mem_p == (char *)pnt_info.pi_user_bounds)) {
-      dmalloc_errno = ERROR_WOULD_OVERWRITE;
-      return 0;
+  /* find the previous pointer in case it ran over */
+  if (dmalloc_errno == ERROR_UNDER_FENCE && start_user != NULL) {
+    other_p = find_user_slot((char *)start_user - FENCE_BOTTOM_SIZE - 1,
+			     1 /* not exact pointer */);
+    if (other_p != NULL) {
+      dmalloc_message("  prev pointer '%#lx' (size %u) may have run over from '%s'",
+		      (unsigned long)other_p->sa_mem, other_p->sa_user_size,
+		      _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					      other_p->sa_file,
+					      other_p->sa_line));
     }
-  } else if (min_size > 0) {
-    if ((char *)user_pnt + min_size > (char *)pnt_info.pi_user_bounds) {
-      dmalloc_errno = ERROR_WOULD_OVERWRITE;
-      return 0;
+  }
+  /* find the next pointer in case it ran under */
+  else if (dmalloc_errno == ERROR_OVER_FENCE
+	   && start_user != NULL
+	   && slot_p != NULL) {
+    other_p = find_user_slot((char *)slot_p->sa_mem + slot_p->sa_total_size,
+			     1 /* not exact pointer */);
+    if (other_p != NULL) {
+      dmalloc_message("  next pointer '%#lx' (size %u) may have run under from '%s'",
+		      (unsigned long)other_p->sa_mem, other_p->sa_user_size,
+		      _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					      other_p->sa_file,
+					      other_p->sa_line));
     }
   }
   
-  return 1;
+  /* we call the error function after writing more info to the logfile */
+  dmalloc_error(where);
 }
 
 /*
- * static int check_free_slot
+ * static int fence_read
  *
- * Check out the pointer in a slot to make sure it is good.
+ * DESCRIPTION
+ *
+ * Check a pointer for fence-post magic numbers.
  *
  * RETURNS:
  *
- * Success - 1
+ * Success - 1 if the fence posts are good.
  *
- * Failure - 0
+ * Failure - 0 if they are not.
  *
  * ARGUMENTS:
  *
- * slot_p -> Slot that we are checking.
+ * info_p -> Pointer information that we are checking.
  */
-static	int	check_free_slot(const skip_alloc_t *slot_p)
+static	int	fence_read(const pnt_info_t *info_p)
 {
-  char	*check_p;
-  
-  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FREE)) {
-    dmalloc_errno = ERROR_SLOT_CORRUPT;
+  /* check magic numbers in bottom of allocation block */
+  if (memcmp(fence_bottom, info_p->pi_fence_bottom, FENCE_BOTTOM_SIZE) != 0) {
+    dmalloc_errno = ERROR_UNDER_FENCE;
     return 0;
   }
   
-  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
-    for (check_p = (char *)slot_p->sa_mem;
-	 check_p < (char *)slot_p->sa_mem + slot_p->sa_total_size;
-	 check_p++) {
-      if (*check_p != FREE_BLANK_CHAR) {
-	dmalloc_errno = ERROR_FREE_OVERWRITTEN;
-	return 0;
-      }
-    }
-  }
-  
-#if LOG_PNT_SEEN_COUNT
-  /*
-   * We divide by 2 here because realloc which returns the same
-   * pointer will seen_c += 2.  However, it will never be more than
-   * twice the iteration value.  We divide by two to not overflow
-   * iter_c * 2.
-   */
-  if (slot_p->sa_seen_c / 2 > _dmalloc_iter_c) {
-    dmalloc_errno = ERROR_SLOT_CORRUPT;
+  /* check numbers at top of allocation block */
+  if (memcmp(fence_top, info_p->pi_fence_top, FENCE_TOP_SIZE) != 0) {
+    dmalloc_errno = ERROR_OVER_FENCE;
     return 0;
   }
-#endif
   
   return 1;
 }
 
-/***************************** exported routines *****************************/
-
 /*
- * int _dmalloc_chunk_startup
- * 
- * DESCRIPTION:
+ * static void clear_alloc
  *
- * Startup the low level malloc routines.
+ * DESCRIPTION
+ *
+ * Setup allocations by writing fence post and doing any necessary
+ * clearing of memory.
  *
  * RETURNS:
  *
- * Success - 1
+ * Success - 1 if the fence posts are good.
  *
- * Failure - 0
+ * Failure - 0 if they are not.
  *
  * ARGUMENTS:
  *
- * None.
+ * slot_p <-> Slot we are clearing.
+ *
+ * info_p -> Pointer to information about the allocation.
+ *
+ * old_size -> If there was an old-size that we have copied into the
+ * new pointer then set this.  If 0 then it will clear the entire
+ * allocation.
+ *
+ * func_id -> ID of the function which is doing the allocation.  Used
+ * to determine if we should 0 memory for [re]calloc.  We don't have
+ * to if the slot's memory is known to be zeros already.
  */
-int	_dmalloc_chunk_startup(void)
+static	void	clear_alloc(skip_alloc_t *slot_p, pnt_info_t *info_p,
+			    const unsigned int old_size, const int func_id)
 {
-  unsigned int	value;
-  char		*pos_p, *max_p;
-  int		bit_c, *bits_p;
+  char	*start_p;
+  int	num;
   
-  value = FENCE_MAGIC_BOTTOM;
-  max_p = fence_bottom + FENCE_BOTTOM_SIZE;
-  for (pos_p = fence_bottom;
-       pos_p < max_p;
-       pos_p += sizeof(value)) {
-    if (pos_p + sizeof(value) <= max_p) {
-      memcpy(pos_p, (char *)&value, sizeof(value));
+  /*
+   * NOTE: The alloc blank flag is set so we blank a slot when it is
+   * allocated.  It used to be that the allocated spaces were blanked
+   * and the free spaces of the allocated chunk were blanked only if
+   * the FREE_BLANK flag was enabled.  Wrong!
+   */
+  
+  /*
+   * Set our slot blank flag if the flags are set now.  This will
+   * carry over with a realloc.
+   */
+  if ((BIT_IS_SET(_dmalloc_flags, DEBUG_ALLOC_BLANK)
+       || BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK))
+      && (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT))) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
+  }
+  
+  /*
+   * If we have a fence post protected valloc then there is almost a
+   * full block at the front what is "free".  Set it with blank chars.
+   * The same goes for the space below a guarded allocation.
+   */
+  if (info_p->pi_fence_b) {
+    num = (char *)info_p->pi_fence_bottom - (char *)info_p->pi_alloc_start;
+  }
+  else {
+    num = (char *)info_p->pi_user_start - (char *)info_p->pi_alloc_start;
+  }
+  /* alloc-blank NOT free-blank */
+  if (num > 0 && BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+    memset(info_p->pi_alloc_start, ALLOC_BLANK_CHAR, num);
+  }
+  
+  /*
+   * If we are allocating or extending memory, write in our alloc
+   * chars.
+   */
+  start_p = (char *)info_p->pi_user_start + old_size;
+  
+  num = (char *)info_p->pi_user_bounds - start_p;
+  if (num > 0) {
+    if (func_id == DMALLOC_FUNC_CALLOC || func_id == DMALLOC_FUNC_RECALLOC) {
+      if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO)) {
+	memset(start_p, 0, num);
+      }
     }
-    else {
-      memcpy(pos_p, (char *)&value, max_p - pos_p);
+    else if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+      memset(start_p, ALLOC_BLANK_CHAR, num);
     }
   }
   
-  value = FENCE_MAGIC_TOP;
-  max_p = fence_top + FENCE_TOP_SIZE;
-  for (pos_p = fence_top; pos_p < max_p; pos_p += sizeof(value)) {
-    if (pos_p + sizeof(value) <= max_p) {
-      memcpy(pos_p, (char *)&value, sizeof(value));
+  /* write in fence-post info */
+  if (info_p->pi_fence_b) {
+    memcpy(info_p->pi_fence_bottom, fence_bottom, FENCE_BOTTOM_SIZE);
+    memcpy(info_p->pi_fence_top, fence_top, FENCE_TOP_SIZE);
+  }
+  
+  /*
+   * Now clear the rest of the block above any fence post space with
+   * free characters.
+   *
+   * NOTE alloc-blank NOT free-blank
+   */
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+    
+    if (info_p->pi_fence_b) {
+      start_p = (char *)info_p->pi_fence_top + FENCE_TOP_SIZE;
     }
     else {
-      memcpy(pos_p, (char *)&value, max_p - pos_p);
+      start_p = info_p->pi_user_bounds;
     }
-  }
-  
-  /* initialize the bits array */
-  bits_p = bit_sizes;
-  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
-    if ((1 << bit_c) >= CHUNK_SMALLEST_BLOCK) {
-      *bits_p++ = 1 << bit_c;
+    
+    num = (char *)info_p->pi_alloc_bounds - start_p;
+    if (num > 0) {
+      memset(start_p, ALLOC_BLANK_CHAR, num);
     }
   }
   
-  /* set the admin flags on the two statically allocated slots */
-  skip_free_list->sa_flags = ALLOC_FLAG_ADMIN;
-  skip_address_list->sa_flags = ALLOC_FLAG_ADMIN;
-  
-  _dmalloc_table_init(&mem_table_alloc, mem_table_alloc_entries,
-		      sizeof(mem_table_alloc_entries) /
-		      sizeof(*mem_table_alloc_entries));
-  _dmalloc_table_init(&mem_table_changed, mem_table_changed_entries,
-		      sizeof(mem_table_changed_entries) /
-		      sizeof(*mem_table_changed_entries));
-  
-  return 1;
+  /* the user owns the memory now so we can't say what is in it */
+  BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_ZERO);
 }
 
+/************************** administration functions *************************/
+
 /*
- * char *_dmalloc_chunk_desc_pnt
+ * static int release_pages
  *
  * DESCRIPTION:
  *
- * Write into a buffer a pointer description with file and
- * line-number.
+ * Give the pages of some free memory back to the system.  Our blocks
+ * are at least as large as the system pages so the memory is page
+ * aligned.
  *
  * RETURNS:
  *
- * Pointer to buffer 1st argument.
+ * 1 if the pages were released otherwise 0.
  *
  * ARGUMENTS:
  *
- * buf <-> Passed in buffer which will be filled with a description of
- * the pointer.
- *
- * buf_size -> Size of the buffer in bytes.
+ * mem -> Start of the memory we are releasing.
  *
- * file -> File name, return address, or NULL.
- *
- * line -> Line number or 0.
+ * size -> Size of the memory which is a multiple of the block-size.
  */
-char	*_dmalloc_chunk_desc_pnt(char *buf, const int buf_size,
-				 const char *file, const unsigned int line)
+static	int	release_pages(void *mem, const unsigned int size)
 {
-  if (file == DMALLOC_DEFAULT_FILE && line == DMALLOC_DEFAULT_LINE) {
-    (void)loc_snprintf(buf, buf_size, "unknown");
-  }
-  else if (line == DMALLOC_DEFAULT_LINE) {
-    (void)loc_snprintf(buf, buf_size, "ra=%#lx", (unsigned long)file);
-  }
-  else if (file == DMALLOC_DEFAULT_FILE) {
-    (void)loc_snprintf(buf, buf_size, "ra=ERROR(line=%u)", line);
+#if FREE_RELEASE_OKAY
+  if (madvise(mem, size, FREE_RELEASE_ADVICE) != 0) {
+    /* we just don't get the memory back */
+    return 0;
   }
-  else {
-    (void)loc_snprintf(buf, buf_size, "%.*s:%u", MAX_FILE_LENGTH, file, line);
+  free_release_bytes += size;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("released free memory '%#lx' (size %u) to the system",
+		    (unsigned long)mem, size);
   }
   
-  return buf;
+  return 1;
+#else
+  return 0;
+#endif
 }
 
 /*
- * int _dmalloc_chunk_read_info
+ * static int remove_free_run
  *
  * DESCRIPTION:
  *
- * Return some information associated with a pointer.
+ * Take a run of free blocks off of the free list and out of the page
+ * map so it can be merged into its neighbor.
  *
  * RETURNS:
  *
- * Success - 1 pointer is okay
+ * Success - 1
  *
- * Failure - 0 problem with pointer
+ * Failure - 0
  *
  * ARGUMENTS:
  *
- * user_pnt -> Pointer we are checking.
- *
- * where <- Where the check is being made from.
- *
- * user_size_p <- Pointer to an unsigned int which, if not NULL, will
- * be set to the size of bytes that the user requested.
- *
- * alloc_size_p <- Pointer to an unsigned int which, if not NULL, will
- * be set to the total given size of bytes including block overhead.
+ * slot_p -> Slot of the free run that we are removing.
+ */
+static	int	remove_free_run(skip_alloc_t *slot_p)
+{
+  if (find_free_slot(slot_p, skip_update) != slot_p) {
+    /* sanity check */
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("remove_free_run");
+    return 0;
+  }
+  if (! remove_slot(slot_p, skip_update)) {
+    /* error dumped in remove_slot */
+    return 0;
+  }
+  page_map_set(slot_p, NULL);
+  
+  return 1;
+}
+
+/*
+ * static void absorb_free_run
  *
- * file_p <- Pointer to a character pointer which, if not NULL, will
- * be set to the file where the pointer was allocated.
+ * DESCRIPTION:
  *
- * line_p <- Pointer to a character pointer which, if not NULL, will
- * be set to the line-number where the pointer was allocated.
+ * Add a free run to the one which is directly below it in memory and
+ * give its slot back.  The lower slot keeps its file/line and seen
+ * count since they describe its address which has not changed.
  *
- * ret_attr_p <- Pointer to a void pointer, if not NULL, will be set
- * to the return-address where the pointer was allocated.
+ * RETURNS:
  *
- * seen_cp <- Pointer to an unsigned long which, if not NULL, will be
- * set to the number of times the pointer has been "seen".
+ * None.
  *
- * used_p <- Pointer to an unsigned long which, if not NULL, will be
- * set to the last time the pointer was "used".
+ * ARGUMENTS:
  *
- * valloc_bp <- Pointer to an integer which, if not NULL, will be set
- * to 1 if the pointer was allocated with valloc otherwise 0.
+ * lower_p <-> Slot of the run which is lower in memory.
  *
- * fence_bp <- Pointer to an integer which, if not NULL, will be set
- * to 1 if the pointer has the fence bit set otherwise 0.
+ * upper_p -> Slot of the run directly above which we are absorbing.
  */
-int	_dmalloc_chunk_read_info(const void *user_pnt, const char *where,
-				 unsigned int *user_size_p,
-				 unsigned int *alloc_size_p, char **file_p,
-				 unsigned int *line_p, void **ret_attr_p,
-				 unsigned long **seen_cp,
-				 unsigned long *used_p, int *valloc_bp,
-				 int *fence_bp)
+static	void	absorb_free_run(skip_alloc_t *lower_p, skip_alloc_t *upper_p)
 {
-  skip_alloc_t	*slot_p;
-  
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
-    dmalloc_message("reading info about pointer '%#lx'",
-		    (unsigned long)user_pnt);
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("merging free blocks '%#lx' (size %u) and '%#lx' "
+		    "(size %u)",
+		    (unsigned long)lower_p->sa_mem, lower_p->sa_total_size,
+		    (unsigned long)upper_p->sa_mem, upper_p->sa_total_size);
+  }
+  
+  /* the run is only all blank if both of the pieces were */
+  if (! BIT_IS_SET(upper_p->sa_flags, ALLOC_FLAG_BLANK)) {
+    BIT_CLEAR(lower_p->sa_flags, ALLOC_FLAG_BLANK);
+  }
+  /* if either of the pieces was released then we release them both */
+  if (BIT_IS_SET(lower_p->sa_flags, ALLOC_FLAG_RELEASED)
+      && (! BIT_IS_SET(upper_p->sa_flags, ALLOC_FLAG_RELEASED))) {
+    if (release_pages(upper_p->sa_mem, upper_p->sa_total_size)
+	&& FREE_RELEASE_ZEROS) {
+      BIT_SET(upper_p->sa_flags, ALLOC_FLAG_ZERO);
+    }
   }
-  
-  /* find the pointer with loose checking for fence */
-  slot_p = find_address(user_pnt, 0 /* used list */, 0 /* not exact pointer */,
-			skip_update);
-  if (slot_p == NULL) {
-    dmalloc_errno = ERROR_NOT_FOUND;
-    log_error_info(NULL, 0, user_pnt, NULL, "finding address in heap", where);
-    return 0;
+  else if (BIT_IS_SET(upper_p->sa_flags, ALLOC_FLAG_RELEASED)
+	   && (! BIT_IS_SET(lower_p->sa_flags, ALLOC_FLAG_RELEASED))) {
+    if (release_pages(lower_p->sa_mem, lower_p->sa_total_size)
+	&& FREE_RELEASE_ZEROS) {
+      BIT_SET(lower_p->sa_flags, ALLOC_FLAG_ZERO);
+    }
+    BIT_SET(lower_p->sa_flags, ALLOC_FLAG_RELEASED);
   }
-  
-  /* might as well check the pointer now */
-  if (! check_used_slot(slot_p, user_pnt, 1 /* exact */, 0 /* no strlen */,
-			0 /* no min-size */)) {
-    /* errno set in check_slot */
-    log_error_info(NULL, 0, user_pnt, slot_p, "checking pointer admin", where);
-    return 0;
+  /* the run is only all zeros if both of the pieces were */
+  if (! BIT_IS_SET(upper_p->sa_flags, ALLOC_FLAG_ZERO)) {
+    BIT_CLEAR(lower_p->sa_flags, ALLOC_FLAG_ZERO);
   }
   
-  /* write info back to user space */
-  SET_POINTER(user_size_p, slot_p->sa_user_size);
-  SET_POINTER(alloc_size_p, slot_p->sa_total_size);
-  if (slot_p->sa_file == DMALLOC_DEFAULT_FILE) {
-    SET_POINTER(file_p, NULL);
-  }
-  else {
-    SET_POINTER(file_p, (char *)slot_p->sa_file);
+  lower_p->sa_total_size += upper_p->sa_total_size;
+  if (upper_p->sa_use_iter > lower_p->sa_use_iter) {
+    lower_p->sa_use_iter = upper_p->sa_use_iter;
   }
-  SET_POINTER(line_p, slot_p->sa_line);
-  /* if the line is blank then the file will be 0 or the return address */
-  if (slot_p->sa_line == DMALLOC_DEFAULT_LINE) {
-    SET_POINTER(ret_attr_p, (char *)slot_p->sa_file);
+  
+  free_slot(upper_p);
+}
+
+/*
+ * static int insert_free_run
+ *
+ * DESCRIPTION:
+ *
+ * Insert a freed slot into the free list after merging it with any
+ * runs of free blocks which are directly below and above it in
+ * memory.  The page map points us at the neighbors.  Pointers on the
+ * free wait list are left in the map so double frees can be found
+ * but they are marked so they are not merged until they are released.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p <-> Slot which has been freed.
+ */
+static	int	insert_free_run(skip_alloc_t *slot_p)
+{
+  skip_alloc_t	*prev_p, *next_p;
+  
+  /* look for a free run which ends right below us */
+  prev_p = page_map_get((char *)slot_p->sa_mem - 1);
+  if (prev_p != NULL
+      && BIT_IS_SET(prev_p->sa_flags, ALLOC_FLAG_FREE)
+      && (! BIT_IS_SET(prev_p->sa_flags, ALLOC_FLAG_WAIT))
+      && (char *)prev_p->sa_mem + prev_p->sa_total_size ==
+      (char *)slot_p->sa_mem
+      && prev_p->sa_total_size <= FREE_RUN_MAX - slot_p->sa_total_size) {
+    if (! remove_free_run(prev_p)) {
+      /* error dumped in remove_free_run */
+      return 0;
+    }
+    absorb_free_run(prev_p, slot_p);
+    slot_p = prev_p;
+  }
+  
+  /* look for a free run which starts right above us */
+  next_p = page_map_get((char *)slot_p->sa_mem + slot_p->sa_total_size);
+  if (next_p != NULL
+      && BIT_IS_SET(next_p->sa_flags, ALLOC_FLAG_FREE)
+      && (! BIT_IS_SET(next_p->sa_flags, ALLOC_FLAG_WAIT))
+      && next_p->sa_mem == (char *)slot_p->sa_mem + slot_p->sa_total_size
+      && next_p->sa_total_size <= FREE_RUN_MAX - slot_p->sa_total_size) {
+    if (! remove_free_run(next_p)) {
+      /* error dumped in remove_free_run */
+      return 0;
+    }
+    absorb_free_run(slot_p, next_p);
   }
-  else {
-    SET_POINTER(ret_attr_p, NULL);
+  
+  if (! insert_slot(slot_p, 1 /* free list */)) {
+    /* error dumped in insert_slot */
+    return 0;
   }
-#if LOG_PNT_SEEN_COUNT
-  SET_POINTER(seen_cp, &slot_p->sa_seen_c);
-#else
-  SET_POINTER(seen_cp, NULL);
-#endif
-  SET_POINTER(used_p, slot_p->sa_use_iter);
-  SET_POINTER(valloc_bp, BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC));
-  SET_POINTER(fence_bp, BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE));
+  page_map_set(slot_p, slot_p);
   
   return 1;
 }
 
-/******************************* heap checking *******************************/
-
 /*
- * int _dmalloc_chunk_heap_check
+ * static int reclaim_slab
  *
  * DESCRIPTION:
  *
- * Run extensive tests on the entire heap.
+ * Take a divided-block whose chunks are all free off of the used list
+ * and put its memory on the free list as a run of free blocks.  Its
+ * admin space is saved to be used by the next block of the same size.
  *
  * RETURNS:
  *
- * Success - 1 if the heap is okay
+ * Success - 1
  *
- * Failure - 0 if a problem was detected
+ * Failure - 0
  *
  * ARGUMENTS:
  *
- * None.
+ * slab_p -> Divided-block that we are reclaiming.
  */
-int	_dmalloc_chunk_heap_check(void)
+static	int	reclaim_slab(slab_block_t *slab_p)
 {
-  skip_alloc_t	*slot_p;
-  entry_block_t	*block_p;
-  int		ret, level_c, checking_list_c = 0;
-  int		final = 1;
+  skip_alloc_t	*run_p, *chunk_p, *bounds_p;
+  unsigned int	bit_c;
   
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+  bit_c = slab_p->sb_bit_c;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("reclaiming divided-block '%#lx' of %u byte chunks",
+		    (unsigned long)slab_p->sb_slot.sa_mem,
+		    slab_p->sb_chunk_size);
+  }
+  
+  /* NOTE: get_slot may overwrite the skip_update pointers */
+  run_p = get_slot();
+  if (run_p == NULL) {
+    /* error code set in get_slot */
+    return 0;
+  }
+  
+  /* take the block off of the used list */
+  if (find_address(slab_p->sb_slot.sa_mem, 0 /* used list */, 1 /* exact */,
+		   skip_update) != &slab_p->sb_slot) {
+    /* sanity check */
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("reclaim_slab");
+    return 0;
+  }
+  if (! remove_slot(&slab_p->sb_slot, skip_update)) {
+    /* error dumped in remove_slot */
+    return 0;
+  }
+  
+  /*
+   * The run is only blank if all of the chunks were.  If any of them
+   * were released then the page may read back as zeros.
+   */
+  run_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_BLANK;
+  bounds_p = slab_p->sb_chunks + slab_p->sb_chunk_n;
+  for (chunk_p = slab_p->sb_chunks; chunk_p < bounds_p; chunk_p++) {
+    if (! BIT_IS_SET(chunk_p->sa_flags, ALLOC_FLAG_BLANK)) {
+      BIT_CLEAR(run_p->sa_flags, ALLOC_FLAG_BLANK);
+    }
+    if (BIT_IS_SET(chunk_p->sa_flags, ALLOC_FLAG_RELEASED)) {
+      BIT_SET(run_p->sa_flags, ALLOC_FLAG_RELEASED);
+    }
+    if (chunk_p->sa_use_iter > run_p->sa_use_iter) {
+      run_p->sa_use_iter = chunk_p->sa_use_iter;
+    }
+  }
+  run_p->sa_mem = slab_p->sb_slot.sa_mem;
+  run_p->sa_total_size = BLOCK_SIZE;
+  
+  /* the chunks are already counted as free space */
+  free_space_bytes += BLOCK_SIZE - slab_p->sb_chunk_n * slab_p->sb_chunk_size;
+  
+  /* unlink the block from its lists */
+  if (slab_p->sb_prev_p == NULL) {
+    slab_blocks[bit_c] = slab_p->sb_next_p;
+  }
+  else {
+    slab_p->sb_prev_p->sb_next_p = slab_p->sb_next_p;
+  }
+  if (slab_p->sb_next_p != NULL) {
+    slab_p->sb_next_p->sb_prev_p = slab_p->sb_prev_p;
+  }
+  if (slab_p->sb_avail_prev_p == NULL) {
+    slab_avail[bit_c] = slab_p->sb_avail_next_p;
+  }
+  else {
+    slab_p->sb_avail_prev_p->sb_avail_next_p = slab_p->sb_avail_next_p;
+  }
+  if (slab_p->sb_avail_next_p != NULL) {
+    slab_p->sb_avail_next_p->sb_avail_prev_p = slab_p->sb_avail_prev_p;
+  }
+  slab_block_c[bit_c]--;
+  slab_reclaim_c[bit_c]++;
+  
+  /* save the admin space with its slot looking like nothing */
+  slab_p->sb_slot.sa_flags = 0;
+  slab_p->sb_next_p = slab_spare[bit_c];
+  slab_spare[bit_c] = slab_p;
+  
+  /* error dumped in insert_free_run */
+  return insert_free_run(run_p);
+}
+
+/*
+ * static int release_slot
+ *
+ * DESCRIPTION:
+ *
+ * Make a freed slot available to be used again.  Divided-block chunks
+ * are marked as available in their block's bitmap, the others are
+ * inserted into the free list.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot which has been freed.
+ */
+static	int	release_slot(skip_alloc_t *slot_p)
+{
+  slab_block_t	*slab_p;
+  unsigned int	chunk_c;
+  
+  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED)) {
+    /* error dumped in insert_free_run */
+    return insert_free_run(slot_p);
+  }
+  
+  slab_p = find_slab(slot_p->sa_mem);
+  if (slab_p == NULL) {
+    /* sanity check */
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("release_slot");
+    return 0;
+  }
+  
+  chunk_c = slot_p - slab_p->sb_chunks;
+  slab_p->sb_avail_map[chunk_c / SLAB_MAP_BITS] |=
+    1UL << (chunk_c % SLAB_MAP_BITS);
+  
+  /* if the block was full then it is available again */
+  if (slab_p->sb_avail_n == 0) {
+    slab_p->sb_avail_prev_p = NULL;
+    slab_p->sb_avail_next_p = slab_avail[slab_p->sb_bit_c];
+    if (slab_p->sb_avail_next_p != NULL) {
+      slab_p->sb_avail_next_p->sb_avail_prev_p = slab_p;
+    }
+    slab_avail[slab_p->sb_bit_c] = slab_p;
+  }
+  slab_p->sb_avail_n++;
+  
+  /*
+   * Once all of the chunks are free we give the block back to the
+   * free list so it can be used for other sizes.  We hold on to it if
+   * it is the only block of its size with chunks available so we do
+   * not thrash when one pointer is allocated and freed over and over.
+   */
+  if (slab_p->sb_avail_n == slab_p->sb_chunk_n
+      && (slab_p->sb_avail_prev_p != NULL
+	  || slab_p->sb_avail_next_p != NULL)) {
+    /* error dumped in reclaim_slab */
+    return reclaim_slab(slab_p);
+  }
+  
+  return 1;
+}
+
+/* with a quarantine the wait list is kept by size instead of by time */
+#define QUARANTINE_SET()	\
+	(_dmalloc_quarantine_size > 0 || _dmalloc_quarantine_count > 0)
+
+/*
+ * static int drain_wait_list
+ *
+ * DESCRIPTION:
+ *
+ * Check the free wait list to see if any of the waiting pointers have
+ * been there longer than the FREED_POINTER_DELAY and can be used
+ * again.  With the quarantine settings, we instead release the oldest
+ * pointers until the list is back within its byte and pointer budget.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	int	drain_wait_list(void)
+{
+  skip_alloc_t	*slot_p, *next_p;
+  
+  for (slot_p = free_wait_list_head; slot_p != NULL; ) {
+    
+    if (QUARANTINE_SET()) {
+      /* we are done if the rest of the list fits in the quarantine */
+      if ((_dmalloc_quarantine_size == 0
+	   || free_wait_bytes <= _dmalloc_quarantine_size)
+	  && (_dmalloc_quarantine_count == 0
+	      || free_wait_pnts <= _dmalloc_quarantine_count)) {
+	break;
+      }
+    }
+    /* we are done if we find a pointer delay in the future */
+    else if (slot_p->sa_use_iter + FREED_POINTER_DELAY > _dmalloc_iter_c) {
+      break;
+    }
+    
+    /* the memory needs to be accessible again before it is reused */
+    if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_PROTECTED)) {
+      if (! _dmalloc_protect_set_read_write(slot_p->sa_mem,
+					    slot_p->sa_total_size /
+					    BLOCK_SIZE)) {
+	dmalloc_errno = ERROR_ALLOC_FAILED;
+	dmalloc_error("drain_wait_list");
+	return 0;
+      }
+      BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_PROTECTED);
+      free_protect_bytes -= slot_p->sa_total_size;
+    }
+    
+    /* put slot back into service */
+    next_p = slot_p->sa_next_p[0];
+    BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_WAIT);
+    free_wait_bytes -= slot_p->sa_total_size;
+    free_wait_pnts--;
+    if (! release_slot(slot_p)) {
+      /* error dumped in release_slot */
+      return 0;
+    }
+    
+    /* adjust our linked list */
+    slot_p = next_p;
+    free_wait_list_head = slot_p;
+    if (slot_p == NULL) {
+      free_wait_list_tail = NULL;
+    }
+  }
+  
+  return 1;
+}
+
+/*
+ * static int wait_slot
+ *
+ * DESCRIPTION:
+ *
+ * Put a freed slot on the end of the free wait list so it is not used
+ * again until after the FREED_POINTER_DELAY or until the quarantine
+ * is full.  Without either, the slot is put back into service right
+ * away.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot which has been freed.
+ */
+static	int	wait_slot(skip_alloc_t *slot_p)
+{
+#if FREED_POINTER_DELAY == 0
+  if (! QUARANTINE_SET()) {
+    /* error dumped in release_slot */
+    return release_slot(slot_p);
+  }
+#endif
+  
+  BIT_SET(slot_p->sa_flags, ALLOC_FLAG_WAIT);
+  slot_p->sa_next_p[0] = NULL;
+  if (free_wait_list_head == NULL) {
+    free_wait_list_head = slot_p;
+  }
+  else {
+    free_wait_list_tail->sa_next_p[0] = slot_p;
+  }
+  free_wait_list_tail = slot_p;
+  free_wait_bytes += slot_p->sa_total_size;
+  free_wait_pnts++;
+  
+  /* push the oldest pointers out if we are over the quarantine */
+  if (QUARANTINE_SET()) {
+    /* error dumped in drain_wait_list */
+    return drain_wait_list();
+  }
+  
+  return 1;
+}
+
+/*
+ * static void release_idle_memory
+ *
+ * DESCRIPTION:
+ *
+ * Give the large runs of free blocks and the empty divided-blocks
+ * which have not been used for FREE_RELEASE_DELAY iterations back to
+ * the system.  We only look every FREE_RELEASE_DELAY iterations.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	void	release_idle_memory(void)
+{
+#if FREE_RELEASE_OKAY
+  skip_alloc_t	*slot_p, *chunk_p, *bounds_p;
+  slab_block_t	*slab_p;
+  int		bit_c, idle_b, released_b;
+  
+  if (_dmalloc_iter_c < release_iter) {
+    return;
+  }
+  release_iter = _dmalloc_iter_c + FREE_RELEASE_DELAY;
+  
+  /* the free list is sorted by size so we start with the large runs */
+  (void)find_free_size(FREE_RELEASE_SIZE, skip_update);
+  for (slot_p = skip_update->sa_next_p[0]->sa_next_p[0];
+       slot_p != NULL;
+       slot_p = slot_p->sa_next_p[0]) {
+    if ((! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_RELEASED))
+	&& slot_p->sa_use_iter + FREE_RELEASE_DELAY <= _dmalloc_iter_c) {
+      if (release_pages(slot_p->sa_mem, slot_p->sa_total_size)
+	  && FREE_RELEASE_ZEROS) {
+	BIT_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO);
+      }
+      BIT_SET(slot_p->sa_flags, ALLOC_FLAG_RELEASED);
+    }
+  }
+  
+  /* empty divided-blocks are on the available lists */
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    for (slab_p = slab_avail[bit_c];
+	 slab_p != NULL;
+	 slab_p = slab_p->sb_avail_next_p) {
+      if (slab_p->sb_avail_n != slab_p->sb_chunk_n) {
+	continue;
+      }
+      idle_b = 1;
+      released_b = 1;
+      bounds_p = slab_p->sb_chunks + slab_p->sb_chunk_n;
+      for (chunk_p = slab_p->sb_chunks; chunk_p < bounds_p; chunk_p++) {
+	if (chunk_p->sa_use_iter + FREE_RELEASE_DELAY > _dmalloc_iter_c) {
+	  idle_b = 0;
+	  break;
+	}
+	if (! BIT_IS_SET(chunk_p->sa_flags, ALLOC_FLAG_RELEASED)) {
+	  released_b = 0;
+	}
+      }
+      if ((! idle_b) || released_b) {
+	continue;
+      }
+      
+      (void)release_pages(slab_p->sb_slot.sa_mem, BLOCK_SIZE);
+      for (chunk_p = slab_p->sb_chunks; chunk_p < bounds_p; chunk_p++) {
+	BIT_SET(chunk_p->sa_flags, ALLOC_FLAG_RELEASED);
+      }
+    }
+  }
+#endif
+}
+
+/*
+ * static int split_free_run
+ *
+ * DESCRIPTION:
+ *
+ * Cut the blocks past a size off of a run which has been taken off of
+ * the free list and put them back on the free list as their own run.
+ *
+ * NOTE: this may call get_slot which will overwrite the skip_update
+ * pointers.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p <-> Slot of the run that we are cutting down.
+ *
+ * size -> Size in bytes that we are leaving in the slot.
+ */
+static	int	split_free_run(skip_alloc_t *slot_p, const unsigned int size)
+{
+  skip_alloc_t	*rest_p;
+  
+  rest_p = get_slot();
+  if (rest_p == NULL) {
+    /* error code set in get_slot */
+    return 0;
+  }
+  
+  /* the rest of the blocks are as free and as blank as they were */
+  rest_p->sa_flags = ALLOC_FLAG_FREE;
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+    BIT_SET(rest_p->sa_flags, ALLOC_FLAG_BLANK);
+  }
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_RELEASED)) {
+    BIT_SET(rest_p->sa_flags, ALLOC_FLAG_RELEASED);
+  }
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO)) {
+    BIT_SET(rest_p->sa_flags, ALLOC_FLAG_ZERO);
+  }
+  rest_p->sa_mem = (char *)slot_p->sa_mem + size;
+  rest_p->sa_total_size = slot_p->sa_total_size - size;
+  rest_p->sa_file = slot_p->sa_file;
+  rest_p->sa_line = slot_p->sa_line;
+  rest_p->sa_use_iter = slot_p->sa_use_iter;
+  
+  slot_p->sa_total_size = size;
+  /* the page map may point at the slot so it must not be merged back */
+  BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_FREE);
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("splitting free blocks '%#lx' (size %u) off of '%#lx'",
+		    (unsigned long)rest_p->sa_mem, rest_p->sa_total_size,
+		    (unsigned long)slot_p->sa_mem);
+  }
+  
+  /* error dumped in insert_free_run */
+  return insert_free_run(rest_p);
+}
+
+/*
+ * static skip_alloc_t *take_free_run
+ *
+ * DESCRIPTION:
+ *
+ * Find a free memory chunk and remove it from the free list if
+ * available.  If there is no chunk of the exact size then we take the
+ * smallest one which is larger and put the extra blocks back on the
+ * free list.  The slot is not on any of the lists when we return.
+ *
+ * RETURNS:
+ *
+ * Success - Valid slot pointer
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Size of the block that we are looking for.
+ *
+ * update_p -> Pointer to the skip_alloc entry we are using to hold
+ * the update pointers.
+ */
+static	skip_alloc_t	*take_free_run(const unsigned int size,
+				       skip_alloc_t *update_p)
+{
+  skip_alloc_t	*slot_p;
+  
+  if (! drain_wait_list()) {
+    /* error dumped in drain_wait_list */
+    return NULL;
+  }
+  
+  /* find a free block which matches the size */ 
+  slot_p = find_free_size(size, update_p);
+  if (slot_p == NULL) {
+    /* the list is sorted so the next slot is the best larger fit */
+    slot_p = update_p->sa_next_p[0]->sa_next_p[0];
+    if (slot_p == NULL) {
+      return NULL;
+    }
+  }
+  
+  /* sanity check */
+  if (slot_p->sa_total_size < size
+      || (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FREE))) {
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("take_free_run");
+    return NULL;
+  }
+  
+  /* remove from free list */
+  if (! remove_slot(slot_p, update_p)) {
+    /* error reported in remove_slot */
+    return NULL;
+  }
+  page_map_set(slot_p, NULL);
+  
+  /* put any extra blocks back on the free list with our flags */
+  if (slot_p->sa_total_size > size && (! split_free_run(slot_p, size))) {
+    /* error dumped in split_free_run */
+    return NULL;
+  }
+  
+  return slot_p;
+}
+
+/*
+ * static skip_alloc_t *use_free_memory
+ *
+ * DESCRIPTION:
+ *
+ * Find a free memory chunk and remove it from the free list and put
+ * it on the used list if available.
+ *
+ * RETURNS:
+ *
+ * Success - Valid slot pointer
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Size of the block that we are looking for.
+ *
+ * update_p -> Pointer to the skip_alloc entry we are using to hold
+ * the update pointers.
+ */
+static	skip_alloc_t	*use_free_memory(const unsigned int size,
+					 skip_alloc_t *update_p)
+{
+  skip_alloc_t	*slot_p;
+  
+  slot_p = take_free_run(size, update_p);
+  if (slot_p == NULL) {
+    /* no free memory or error dumped in take_free_run */
+    return NULL;
+  }
+  
+  /* set to user allocated space remembering if it is still all zeros */
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO)) {
+    slot_p->sa_flags = ALLOC_FLAG_USER | ALLOC_FLAG_ZERO;
+  }
+  else {
+    slot_p->sa_flags = ALLOC_FLAG_USER;
+  }
+  
+  /* insert it into our address list */
+  if (! insert_slot(slot_p, 0 /* used list */)) {
+    /* error set in insert_slot */
+    return NULL;
+  }
+  
+  free_space_bytes -= slot_p->sa_total_size;
+  
+  return slot_p;
+}
+
+/*
+ * static slab_block_t *create_divided_chunks
+ *
+ * DESCRIPTION:
+ *
+ * Make a new divided-block along with the admin block(s) which hold
+ * its chunk bitmap and slots.  The block comes from the free list if
+ * possible otherwise from the heap and the admin space of a reclaimed
+ * block of the same size is used again.  The block is added to the
+ * used list and all of its chunks are available.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the new divided-block.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * bit_c -> Index into the bit_sizes array of the size of the chunks
+ * that we are creating.
+ */
+static	slab_block_t	*create_divided_chunks(const int bit_c)
+{
+  slab_block_t	*slab_p;
+  skip_alloc_t	*admin_p, *chunk_p, *run_p;
+  void		*mem;
+  unsigned int	chunk_size, chunk_n, map_n, admin_size, chunk_c;
+  
+  chunk_size = bit_sizes[bit_c];
+  chunk_n = BLOCK_SIZE / chunk_size;
+  map_n = (chunk_n + SLAB_MAP_BITS - 1) / SLAB_MAP_BITS;
+  
+  /* the structure, bitmap, and chunk slots rounded up to the block-size */
+  admin_size = sizeof(slab_block_t) + map_n * sizeof(unsigned long) +
+    chunk_n * sizeof(skip_alloc_t);
+  admin_size = (admin_size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("need a divided-block of %u byte chunks", chunk_size);
+  }
+  
+  /* get a 1 block chunk that we will cut up into pieces */
+  run_p = take_free_run(BLOCK_SIZE, skip_update);
+  if (run_p != NULL) {
+    mem = run_p->sa_mem;
+    free_space_bytes -= BLOCK_SIZE;
+    free_slot(run_p);
+  }
+  else {
+    mem = _dmalloc_heap_alloc(BLOCK_SIZE);
+    if (mem == HEAP_ALLOC_ERROR) {
+      /* error code set in _dmalloc_heap_alloc */
+      return NULL;
+    }
+    user_block_c++;
+  }
+  
+  slab_p = slab_spare[bit_c];
+  if (slab_p != NULL) {
+    /* the admin space is still accounted for on the used list */
+    slab_spare[bit_c] = slab_p->sb_next_p;
+    memset(slab_p, 0, admin_size);
+  }
+  else {
+    /* allocate the admin space which tracks the chunks */
+    slab_p = _dmalloc_heap_alloc(admin_size);
+    if (slab_p == HEAP_ALLOC_ERROR) {
+      /* error code set in _dmalloc_heap_alloc */
+      return NULL;
+    }
+    memset(slab_p, 0, admin_size);
+    admin_block_c += admin_size / BLOCK_SIZE;
+    
+    /* account for the admin space on the used list */
+    admin_p = get_slot();
+    if (admin_p == NULL) {
+      /* error code set in get_slot */
+      return NULL;
+    }
+    admin_p->sa_flags = ALLOC_FLAG_ADMIN;
+    admin_p->sa_mem = slab_p;
+    admin_p->sa_total_size = admin_size;
+    if (! insert_slot(admin_p, 0 /* used list */)) {
+      /* error set in insert_slot */
+      return NULL;
+    }
+  }
+  
+  /* intialize the block structure */
+  slab_p->sb_magic1 = SLAB_BLOCK_MAGIC1;
+  slab_p->sb_bit_c = bit_c;
+  slab_p->sb_chunk_size = chunk_size;
+  slab_p->sb_chunk_n = chunk_n;
+  slab_p->sb_avail_n = chunk_n;
+  slab_p->sb_admin_size = admin_size;
+  slab_p->sb_avail_map = (unsigned long *)(slab_p + 1);
+  slab_p->sb_chunks = (skip_alloc_t *)(slab_p->sb_avail_map + map_n);
+  slab_p->sb_magic2 = SLAB_BLOCK_MAGIC2;
+  
+  /* now run through the block and make all of the chunks available */
+  chunk_p = slab_p->sb_chunks;
+  for (chunk_c = 0; chunk_c < chunk_n; chunk_c++, chunk_p++) {
+    slab_p->sb_avail_map[chunk_c / SLAB_MAP_BITS] |=
+      1UL << (chunk_c % SLAB_MAP_BITS);
+    chunk_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_DIVIDED;
+    chunk_p->sa_mem = (char *)mem + chunk_c * chunk_size;
+    chunk_p->sa_total_size = chunk_size;
+  }
+  free_space_bytes += chunk_n * chunk_size;
+  
+  /* put the whole block on the used list */
+  slab_p->sb_slot.sa_flags = ALLOC_FLAG_SLAB;
+  slab_p->sb_slot.sa_level_n = random_level(MAX_SKIP_LEVEL);
+  slab_p->sb_slot.sa_mem = mem;
+  slab_p->sb_slot.sa_total_size = BLOCK_SIZE;
+  if (! insert_slot(&slab_p->sb_slot, 0 /* used list */)) {
+    /* error set in insert_slot */
+    return NULL;
+  }
+  page_map_fill(&slab_p->sb_slot, &slab_p->sb_slot);
+  
+  slab_p->sb_next_p = slab_blocks[bit_c];
+  if (slab_p->sb_next_p != NULL) {
+    slab_p->sb_next_p->sb_prev_p = slab_p;
+  }
+  slab_blocks[bit_c] = slab_p;
+  slab_p->sb_avail_next_p = slab_avail[bit_c];
+  if (slab_p->sb_avail_next_p != NULL) {
+    slab_p->sb_avail_next_p->sb_avail_prev_p = slab_p;
+  }
+  slab_avail[bit_c] = slab_p;
+  slab_block_c[bit_c]++;
+  
+  return slab_p;
+}
+
+/*
+ * static skip_alloc_t *get_divided_memory
+ *
+ * DESCRIPTION:
+ *
+ * Get a chunk of a divided memory block, creating a new divided-block
+ * from the heap if none of them have chunks available.
+ *
+ * RETURNS:
+ *
+ * Success - Valid skip slot pointer.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Size of the block that we are allocating.
+ */
+static	skip_alloc_t	*get_divided_memory(const unsigned int size)
+{
+  skip_alloc_t	*slot_p;
+  slab_block_t	*slab_p;
+  unsigned long	*map_p, *bounds_p, bits;
+  unsigned int	chunk_c;
+  int		bit_c;
+  
+  for (bit_c = 0;; bit_c++) {
+    if (bit_sizes[bit_c] >= size) {
+      break;
+    }
+  }
+  
+  if (! drain_wait_list()) {
+    /* error dumped in drain_wait_list */
+    return NULL;
+  }
+  
+  /* find a block with available chunks of our size */
+  slab_p = slab_avail[bit_c];
+  if (slab_p == NULL) {
+    slab_p = create_divided_chunks(bit_c);
+    if (slab_p == NULL) {
+      /* errors dumped in create_divided_chunks */
+      return NULL;
+    }
+  }
+  
+  /* scan the bitmap for the first available chunk */
+  map_p = slab_p->sb_avail_map;
+  bounds_p = map_p + (slab_p->sb_chunk_n + SLAB_MAP_BITS - 1) / SLAB_MAP_BITS;
+  for (; map_p < bounds_p && *map_p == 0; map_p++) {
+  }
+  if (map_p >= bounds_p) {
+    /* huh?  This isn't right. */
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("get_divided_memory");
+    return NULL;
+  }
+  bits = *map_p;
+  chunk_c = (map_p - slab_p->sb_avail_map) * SLAB_MAP_BITS;
+  for (; (bits & 0xFF) == 0; bits >>= 8) {
+    chunk_c += 8;
+  }
+  for (; (bits & 1) == 0; bits >>= 1) {
+    chunk_c++;
+  }
+  *map_p &= ~(1UL << (chunk_c % SLAB_MAP_BITS));
+  
+  /* take the block off of the available list when it is full */
+  slab_p->sb_avail_n--;
+  if (slab_p->sb_avail_n == 0) {
+    slab_avail[bit_c] = slab_p->sb_avail_next_p;
+    if (slab_p->sb_avail_next_p != NULL) {
+      slab_p->sb_avail_next_p->sb_avail_prev_p = NULL;
+    }
+    slab_p->sb_avail_next_p = NULL;
+  }
+  
+  /* set to user allocated space */
+  slot_p = slab_p->sb_chunks + chunk_c;
+  slot_p->sa_flags = ALLOC_FLAG_USER | ALLOC_FLAG_DIVIDED;
+  
+  free_space_bytes -= slot_p->sa_total_size;
+  
+  return slot_p;
+}
+
+/*
+ * static skip_alloc_t *get_memory
+ *
+ * DESCRIPTION:
+ *
+ * Get a block from the free list or heap allocation.
+ *
+ * RETURNS:
+ *
+ * Success - Valid skip slot pointer.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Size of the block that we are allocating.
+ */
+static	skip_alloc_t	*get_memory(const unsigned int size)
+{
+  skip_alloc_t	*slot_p, *update_p;
+  void		*mem;
+  unsigned int	need_size, block_n;
+  
+  /* do we need to print admin info? */
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("need %d bytes", size);
+  }
+  
+  /* will this allocate put us over the limit? */
+  if (_dmalloc_memory_limit > 0
+      && alloc_cur_given + size > _dmalloc_memory_limit) {
+    dmalloc_errno = ERROR_OVER_LIMIT;
+    dmalloc_error("get_memory");
+    return NULL;
+  }
+  
+  /* do we have a divided block here? */
+  if (size <= BLOCK_SIZE / 2) {
+    return get_divided_memory(size);
+  }
+  
+  /* round up to the nearest block size */
+  need_size = size + BLOCK_SIZE - 1;
+  block_n = need_size / BLOCK_SIZE;
+  need_size = block_n * BLOCK_SIZE;
+  
+  update_p = skip_update;
+  
+  /* find a free block which is the best fit for the size */ 
+  slot_p = use_free_memory(need_size, update_p);
+  if (slot_p != NULL) {
+    page_map_fill(slot_p, slot_p);
+    return slot_p;
+  }
+  
+  /* allocate the memory necessary for the new blocks */
+  mem = _dmalloc_heap_alloc(need_size);
+  if (mem == HEAP_ALLOC_ERROR) {
+    /* error code set in _dmalloc_heap_alloc */
+    return NULL;
+  }
+  user_block_c += block_n;
+  
+  /* create our slot */
+  slot_p = insert_address(mem, 0 /* used list */, need_size);
+  if (slot_p == NULL) {
+    /* error set in insert_address */
+    return NULL;
+  }
+  if (_dmalloc_heap_mapped(need_size)) {
+    /* so realloc can remap it */
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_MAPPED);
+  }
+  if (HEAP_ALLOC_ZEROS) {
+    /* so calloc does not have to clear it */
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO);
+  }
+  page_map_fill(slot_p, slot_p);
+  
+  return slot_p;
+}
+
+/*
+ * static int grow_slot
+ *
+ * DESCRIPTION:
+ *
+ * Try to make a used allocation larger without moving the user's
+ * data.  We take the blocks from the start of a free run directly
+ * above it or, if the allocation has its own mapping, we have the
+ * system remap it which may change its address.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0 if the allocation could not grow.
+ *
+ * ARGUMENTS:
+ *
+ * slot_p <-> Slot of the used allocation that we are growing.
+ *
+ * size -> Number of bytes that we need to add to the allocation.
+ */
+static	int	grow_slot(skip_alloc_t *slot_p, const unsigned int size)
+{
+  skip_alloc_t	*next_p;
+  void		*mem;
+  unsigned int	need_size;
+  
+  need_size = (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  
+  /* will this put us over the limit? */
+  if (_dmalloc_memory_limit > 0
+      && alloc_cur_given + need_size > _dmalloc_memory_limit) {
+    return 0;
+  }
+  
+  mem = (char *)slot_p->sa_mem + slot_p->sa_total_size;
+  next_p = page_map_get(mem);
+  if (next_p != NULL
+      && BIT_IS_SET(next_p->sa_flags, ALLOC_FLAG_FREE)
+      && (! BIT_IS_SET(next_p->sa_flags, ALLOC_FLAG_WAIT))
+      && next_p->sa_mem == mem
+      && next_p->sa_total_size >= need_size) {
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+      dmalloc_message("growing '%#lx' (size %u) into free blocks '%#lx' (size %u)",
+		      (unsigned long)slot_p->sa_mem, slot_p->sa_total_size,
+		      (unsigned long)mem, next_p->sa_total_size);
+    }
+    if (! remove_free_run(next_p)) {
+      /* error dumped in remove_free_run */
+      return 0;
+    }
+    if (next_p->sa_total_size > need_size
+	&& (! split_free_run(next_p, need_size))) {
+      /* error dumped in split_free_run */
+      return 0;
+    }
+    free_slot(next_p);
+    free_space_bytes -= need_size;
+  }
+  else if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_MAPPED)) {
+    mem = _dmalloc_heap_remap(slot_p->sa_mem, slot_p->sa_total_size,
+			      slot_p->sa_total_size + need_size);
+    if (mem == HEAP_ALLOC_ERROR) {
+      return 0;
+    }
+    /* if the system moved it then it has a new place in the used list */
+    if (mem != slot_p->sa_mem) {
+      page_map_fill(slot_p, NULL);
+      if (find_address(slot_p->sa_mem, 0 /* used list */, 1 /* exact */,
+		       skip_update) != slot_p
+	  || (! remove_slot(slot_p, skip_update))) {
+	dmalloc_errno = ERROR_ADDRESS_LIST;
+	dmalloc_error("grow_slot");
+	return 0;
+      }
+      slot_p->sa_mem = mem;
+      if (! insert_slot(slot_p, 0 /* used list */)) {
+	/* error set in insert_slot */
+	return 0;
+      }
+    }
+    user_block_c += need_size / BLOCK_SIZE;
+  }
+  else {
+    return 0;
+  }
+  
+  slot_p->sa_total_size += need_size;
+  page_map_fill(slot_p, slot_p);
+  
+  alloc_cur_given += need_size;
+  alloc_max_given = MAX(alloc_max_given, alloc_cur_given);
+  
+  return 1;
+}
+
+/*
+ * static const char *blank_find
+ *
+ * DESCRIPTION:
+ *
+ * Find the first byte in a range of memory that is not a certain
+ * character.  Once the pointer is aligned we compare a word at a
+ * time, a few words per pass so the compiler can vectorize the loop,
+ * and only go back to bytes to find the exact byte in the word that
+ * is different.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the first byte that is different.
+ *
+ * Failure - NULL if all of the bytes are the character.
+ *
+ * ARGUMENTS:
+ *
+ * mem_p -> Start of the range of memory.
+ *
+ * bounds_p -> Pointer just past the end of the range.
+ *
+ * ch -> Character that the range should be filled with.
+ */
+static	const char	*blank_find(const char *mem_p, const char *bounds_p,
+				    const char ch)
+{
+  const unsigned long	*word_p, *word_bounds_p;
+  unsigned long		word;
+  
+  /* get up to a word boundary */
+  for (; mem_p < bounds_p && (unsigned long)mem_p % sizeof(word) != 0;
+       mem_p++) {
+    if (*mem_p != ch) {
+      return mem_p;
+    }
+  }
+  
+  if (bounds_p - mem_p >= (long)sizeof(word)) {
+    /* the character in each of the bytes of a word */
+    word = (unsigned long)(unsigned char)ch * (~0UL / 0xff);
+    word_p = (const unsigned long *)mem_p;
+    word_bounds_p = word_p + (bounds_p - mem_p) / sizeof(word);
+    for (; word_p + 4 <= word_bounds_p; word_p += 4) {
+      if (((word_p[0] ^ word) | (word_p[1] ^ word)
+	   | (word_p[2] ^ word) | (word_p[3] ^ word)) != 0) {
+	break;
+      }
+    }
+    for (; word_p < word_bounds_p; word_p++) {
+      if (*word_p != word) {
+	break;
+      }
+    }
+    mem_p = (const char *)word_p;
+  }
+  
+  /* the word that was different or the bytes past the last word */
+  for (; mem_p < bounds_p; mem_p++) {
+    if (*mem_p != ch) {
+      return mem_p;
+    }
+  }
+  
+  return NULL;
+}
+
+/*
+ * static const char *alloc_blank_bad
+ *
+ * DESCRIPTION:
+ *
+ * Make sure that the blanked space of an allocation below or above
+ * the user area has not been overwritten.  This does not set
+ * dmalloc_errno so the heap check threads can call it.
+ *
+ * RETURNS:
+ *
+ * Success - NULL if the space is still blank
+ *
+ * Failure - Pointer to the first byte that has been overwritten
+ *
+ * ARGUMENTS:
+ *
+ * info_p -> Information about the pointer.
+ *
+ * above_b -> Set to 1 to check the space above the user area
+ * otherwise the space below it is checked.
+ */
+static	const char	*alloc_blank_bad(const pnt_info_t *info_p,
+					 const int above_b)
+{
+  const char	*mem_p, *bounds_p;
+  
+  if (above_b) {
+    if (info_p->pi_fence_b) {
+      mem_p = (char *)info_p->pi_fence_top + FENCE_TOP_SIZE;
+    }
+    else {
+      mem_p = info_p->pi_user_bounds;
+    }
+    bounds_p = info_p->pi_alloc_bounds;
+  }
+  else {
+    mem_p = info_p->pi_alloc_start;
+    if (info_p->pi_fence_b) {
+      bounds_p = info_p->pi_fence_bottom;
+    }
+    else {
+      bounds_p = info_p->pi_user_start;
+    }
+  }
+  
+  return blank_find(mem_p, bounds_p, ALLOC_BLANK_CHAR);
+}
+
+/*
+ * static const char *free_blank_bad
+ *
+ * DESCRIPTION:
+ *
+ * Make sure that the blanked memory of a free slot has not been
+ * overwritten.  This does not set dmalloc_errno so the heap check
+ * threads can call it.
+ *
+ * RETURNS:
+ *
+ * Success - NULL if the memory is still blank
+ *
+ * Failure - Pointer to the first byte that has been overwritten
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Free slot whose memory we are checking.
+ */
+static	const char	*free_blank_bad(const skip_alloc_t *slot_p)
+{
+  const char	*check_p, *bounds_p;
+  
+  check_p = (char *)slot_p->sa_mem;
+  bounds_p = (char *)slot_p->sa_mem + slot_p->sa_total_size;
+  while (1) {
+    check_p = blank_find(check_p, bounds_p, FREE_BLANK_CHAR);
+    if (check_p == NULL) {
+      return NULL;
+    }
+    /* pages given back to the system may read back as zeros */
+    if (*check_p != '\0'
+	|| (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_RELEASED))) {
+      return check_p;
+    }
+    check_p = blank_find(check_p, bounds_p, '\0');
+    if (check_p == NULL) {
+      return NULL;
+    }
+  }
+}
+
+/*
+ * static int check_used_slot
+ *
+ * Check out the pointer in a allocated slot to make sure it is good.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are checking.
+ *
+ * user_pnt -> User pointer which was used to get the slot or NULL.
+ *
+ * exact_b -> Set to 1 to find the pointer specifically.  Otherwise we
+ * can find the pointer inside of an allocation.
+ *
+ * strlen_b -> Make sure that pnt can hold at least a strlen + 1
+ * bytes.  If 0 then ignore.
+ *
+ * min_size -> Make sure that pnt can hold at least that many bytes.
+ * If 0 then ignore.
+ *
+ * blank_b -> Set to 0 if the blanked space has already been checked.
+ */
+static	int	check_used_slot(const skip_alloc_t *slot_p,
+				const void *user_pnt, const int exact_b,
+				const int strlen_b, const int min_size,
+				const int blank_b)
+{
+  const char	*file, *name_p, *bounds_p, *mem_p;
+  unsigned int	line;
+  pnt_info_t	pnt_info;
+  
+  if (! (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER)
+	 || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_EXTERN)
+	 || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ADMIN))) {
+    dmalloc_errno = ERROR_SLOT_CORRUPT;
+    return 0;
+  }
+  
+  /* get pointer info */
+  get_pnt_info(slot_p, &pnt_info);
+  
+  /* the user pointer needs to be within the user space */
+  if (user_pnt != NULL && (char *)user_pnt < (char *)pnt_info.pi_user_start) {
+    dmalloc_errno = ERROR_WOULD_OVERWRITE;
+    return 0;
+  }
+  
+  /* if we need the exact pointer, make sure that the user_pnt agrees */
+  if (exact_b && user_pnt != pnt_info.pi_user_start) {
+    dmalloc_errno = ERROR_NOT_START_BLOCK;
+    return 0;
+  }
+  
+#if LARGEST_ALLOCATION
+  /* have we exceeded the upper bounds */
+  if (slot_p->sa_user_size > LARGEST_ALLOCATION) {
+    dmalloc_errno = ERROR_BAD_SIZE;
+    return 0;
+  }
+#endif
+  
+  /* check our total block size */
+  if (slot_p->sa_total_size > BLOCK_SIZE / 2
+      && slot_p->sa_total_size % BLOCK_SIZE != 0) {
+    dmalloc_errno = ERROR_BAD_SIZE;
+    return 0;
+  }
+  
+  /*
+   * If we have a valloc allocation then the _user_ pnt should be
+   * block aligned otherwise the chunk_pnt should be.
+   */
+  if (pnt_info.pi_valloc_b) {
+    
+    if ((long)pnt_info.pi_user_start % BLOCK_SIZE != 0) {
+      dmalloc_errno = ERROR_NOT_ON_BLOCK;
+      return 0;
+    }
+    if (slot_p->sa_total_size < BLOCK_SIZE) {
+      dmalloc_errno = ERROR_SLOT_CORRUPT;
+      return 0;
+    }
+  }
+  else if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ALIGNED)) {
+    if ((! pnt_info.pi_fence_b)
+	|| slot_p->sa_align_off < FENCE_BOTTOM_SIZE
+	|| slot_p->sa_align_off >= slot_p->sa_total_size) {
+      dmalloc_errno = ERROR_SLOT_CORRUPT;
+      return 0;
+    }
+  }
+  
+  /* the guard page must be above the user allocation */
+  if (pnt_info.pi_guard_b
+      && (pnt_info.pi_fence_b
+	  || slot_p->sa_total_size < BLOCK_SIZE * 2
+	  || (char *)pnt_info.pi_user_bounds >
+	  (char *)pnt_info.pi_alloc_bounds)) {
+    dmalloc_errno = ERROR_SLOT_CORRUPT;
+    return 0;
+  }
+  
+  /*
+   * Check the space below a valloc or memalign fence or a guarded
+   * allocation to see it is clear.
+   */
+  if (blank_b && pnt_info.pi_blanked_b) {
+    overwrite_p = alloc_blank_bad(&pnt_info, 0 /* below */);
+    if (overwrite_p != NULL) {
+      dmalloc_errno = ERROR_FREE_OVERWRITTEN;
+      return 0;
+    }
+  }
+  
+  /* check out the fence-posts */
+  if (pnt_info.pi_fence_b && (! fence_read(&pnt_info))) {
+    /* errno set in fence_read */
+    return 0;
+  }
+  
+  /* check above the allocation to see if it's been overwritten */
+  if (blank_b && pnt_info.pi_blanked_b) {
+    overwrite_p = alloc_blank_bad(&pnt_info, 1 /* above */);
+    if (overwrite_p != NULL) {
+      dmalloc_errno = ERROR_FREE_OVERWRITTEN;
+      return 0;
+    }
+  }
+
+  file = slot_p->sa_file;
+  line = slot_p->sa_line;
+  
+  /* check line number */
+#if MAX_LINE_NUMBER
+  if (line > MAX_LINE_NUMBER) {
+    dmalloc_errno = ERROR_BAD_LINE;
+    return 0;
+  }
+#endif
+  
+  /*
+   * Check file pointer only if file is not NULL and line is not 0
+   * which implies that file is a return-addr.
+   */
+#if MAX_FILE_LENGTH
+  if (file != DMALLOC_DEFAULT_FILE && line != DMALLOC_DEFAULT_LINE) {
+    /* NOTE: we don't use strlen here because we might check too far */
+    bounds_p = file + MAX_FILE_LENGTH;
+    for (name_p = file; name_p <= bounds_p && *name_p != '\0'; name_p++) {
+    }
+    if (name_p > bounds_p
+	|| name_p < file + MIN_FILE_LENGTH) {
+      dmalloc_errno = ERROR_BAD_FILE;
+      return 0;
+    }
+  }
+#endif
+  
+#if LOG_PNT_SEEN_COUNT
+  /*
+   * We divide by 2 here because realloc which returns the same
+   * pointer will seen_c += 2.  However, it will never be more than
+   * twice the iteration value.  We divide by two to not overflow
+   * iter_c * 2.
+   */
+  if (slot_p->sa_seen_c / 2 > _dmalloc_iter_c) {
+    dmalloc_errno = ERROR_SLOT_CORRUPT;
+    return 0;
+  }
+#endif
+  
+  if (strlen_b) {
+    int	equals_okay_b = 0;
+    mem_p = (char *)user_pnt;
+    if (min_size > 0) {
+      bounds_p = mem_p + min_size;
+      /* min_size can be out of bounds as long as we find a \0 beforehand */
+      if (bounds_p > (char *)pnt_info.pi_user_bounds) {
+	bounds_p = (char *)pnt_info.pi_user_bounds;
+      } else {
+	/* we can equals our boundary if our min_size <= user_bounds */
+	equals_okay_b = 1;
+      }
+    } else {
+      bounds_p = (char *)pnt_info.pi_user_bounds;
+    }
+    for (; mem_p < bounds_p; mem_p++) {
+      if (*mem_p == '\0') {
+	break;
+      }
+    }
+    /* mem_p can == bounds_p if we hit the min_size but can't >= user_bounds*/ 
+    if (mem_p > (char *)pnt_info.pi_user_bounds
+	|| ((! equals_okay_b) && mem_p == (char *)pnt_info.pi_user_bounds)) {
+      dmalloc_errno = ERROR_WOULD_OVERWRITE;
+      return 0;
+    }
+  } else if (min_size > 0) {
+    if ((char *)user_pnt + min_size > (char *)pnt_info.pi_user_bounds) {
+      dmalloc_errno = ERROR_WOULD_OVERWRITE;
+      return 0;
+    }
+  }
+  
+  return 1;
+}
+
+/*
+ * static int check_free_slot
+ *
+ * Check out the pointer in a slot to make sure it is good.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are checking.
+ *
+ * blank_b -> Set to 0 if the blanked memory has already been checked.
+ */
+static	int	check_free_slot(const skip_alloc_t *slot_p, const int blank_b)
+{
+  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FREE)) {
+    dmalloc_errno = ERROR_SLOT_CORRUPT;
+    return 0;
+  }
+  
+  /* no-access freed memory cannot have been overwritten */
+  if (blank_b && BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)
+      && (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_PROTECTED))) {
+    overwrite_p = free_blank_bad(slot_p);
+    if (overwrite_p != NULL) {
+      dmalloc_errno = ERROR_FREE_OVERWRITTEN;
+      return 0;
+    }
+  }
+  
+#if LOG_PNT_SEEN_COUNT
+  /*
+   * We divide by 2 here because realloc which returns the same
+   * pointer will seen_c += 2.  However, it will never be more than
+   * twice the iteration value.  We divide by two to not overflow
+   * iter_c * 2.
+   */
+  if (slot_p->sa_seen_c / 2 > _dmalloc_iter_c) {
+    dmalloc_errno = ERROR_SLOT_CORRUPT;
+    return 0;
+  }
+#endif
+  
+  return 1;
+}
+
+/*
+ * static int check_slab
+ *
+ * Check out the admin information of a divided-block to make sure it
+ * is good.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * slab_p -> Divided-block that we are checking.
+ *
+ * bit_c -> Index into the bit_sizes array of the list that the block
+ * was found on.
+ */
+static	int	check_slab(const slab_block_t *slab_p, const int bit_c)
+{
+  const skip_alloc_t	*slot_p, *chunk_p;
+  unsigned int		chunk_c, avail_c = 0;
+  int			avail_b;
+  
+  /* better be in the heap */
+  if (! IS_IN_HEAP(slab_p)) {
+    return 0;
+  }
+  
+  /* check magics and sizes */
+  if (slab_p->sb_magic1 != SLAB_BLOCK_MAGIC1
+      || slab_p->sb_magic2 != SLAB_BLOCK_MAGIC2
+      || slab_p->sb_bit_c != (unsigned int)bit_c
+      || slab_p->sb_chunk_size != (unsigned int)bit_sizes[bit_c]
+      || slab_p->sb_chunk_n != BLOCK_SIZE / slab_p->sb_chunk_size) {
+    return 0;
+  }
+  
+  /* the admin space should be on the used list */
+  slot_p = find_address(slab_p, 0 /* used list */, 1 /* exact */,
+			skip_update);
+  if (slot_p == NULL
+      || (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ADMIN))
+      || slot_p->sa_total_size != slab_p->sb_admin_size) {
+    return 0;
+  }
+  
+  /* as should the divided-block itself */
+  slot_p = find_address(slab_p->sb_slot.sa_mem, 0 /* used list */,
+			1 /* exact */, skip_update);
+  if (slot_p != &slab_p->sb_slot
+      || slot_p->sa_flags != ALLOC_FLAG_SLAB
+      || slot_p->sa_total_size != BLOCK_SIZE) {
+    return 0;
+  }
+  
+  /* the available chunks should agree with the bitmap */
+  chunk_p = slab_p->sb_chunks;
+  for (chunk_c = 0; chunk_c < slab_p->sb_chunk_n; chunk_c++, chunk_p++) {
+    if ((char *)chunk_p->sa_mem !=
+	(char *)slab_p->sb_slot.sa_mem + chunk_c * slab_p->sb_chunk_size
+	|| chunk_p->sa_total_size != slab_p->sb_chunk_size
+	|| (! BIT_IS_SET(chunk_p->sa_flags, ALLOC_FLAG_DIVIDED))) {
+      return 0;
+    }
+    avail_b = ((slab_p->sb_avail_map[chunk_c / SLAB_MAP_BITS] &
+		(1UL << (chunk_c % SLAB_MAP_BITS))) != 0);
+    if (avail_b) {
+      if (! BIT_IS_SET(chunk_p->sa_flags, ALLOC_FLAG_FREE)) {
+	return 0;
+      }
+      avail_c++;
+    }
+  }
+  if (avail_c != slab_p->sb_avail_n) {
+    return 0;
+  }
+  
+  return 1;
+}
+
+/**************************** thread cache routines **************************/
+
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+
+#if HAVE_PTHREAD_MUTEX_LOCK
+#define CACHE_LOCK(cache_p)	pthread_mutex_lock(&(cache_p)->tc_mutex)
+#else
+#define CACHE_LOCK(cache_p)
+#endif
+#if HAVE_PTHREAD_MUTEX_UNLOCK
+#define CACHE_UNLOCK(cache_p)	pthread_mutex_unlock(&(cache_p)->tc_mutex)
+#else
+#define CACHE_UNLOCK(cache_p)
+#endif
+
+/*
+ * Wrap the moving of a cache's counts to the library's so the
+ * unlocked stats readers can tell and read them again.  The library
+ * lock must be held.
+ */
+#define STATS_MOVE_START()	do { \
+				  stats_seq++; \
+				  __sync_synchronize(); \
+				} while (0)
+#define STATS_MOVE_END()	do { \
+				  __sync_synchronize(); \
+				  stats_seq++; \
+				} while (0)
+
+/* hash a user pointer into a cache's table of pointers */
+#define CACHE_PNT_HASH(pnt)						\
+	((((unsigned long)(pnt) >> 4) ^ ((unsigned long)(pnt) >> 12)) &	\
+	 (THREAD_CACHE_PNTS - 1))
+
+/* hash a user pointer into the cache_handed buckets */
+#define CACHE_HANDED_HASH(pnt)						\
+	((((unsigned long)(pnt) >> 4) ^ ((unsigned long)(pnt) >> 16)) &	\
+	 (CACHE_HANDED_BUCKETS - 1))
+
+/*
+ * static thread_cache_t *cache_current
+ *
+ * DESCRIPTION:
+ *
+ * Get the cache of the current thread.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the thread's cache.
+ *
+ * Failure - NULL if the thread does not have one.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	thread_cache_t	*cache_current(void)
+{
+  if (! cache_key_b) {
+    return NULL;
+  }
+  return (thread_cache_t *)pthread_getspecific(cache_key);
+}
+
+/*
+ * static void *cache_user_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Get the user pointer of a chunk which was handed out of a thread
+ * cache.  These are never valloc-ed so this is quicker than
+ * get_pnt_info.
+ *
+ * RETURNS:
+ *
+ * User pointer of the chunk.
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot of the chunk.
+ */
+static	void	*cache_user_pnt(const skip_alloc_t *slot_p)
+{
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE)) {
+    return (char *)slot_p->sa_mem + FENCE_BOTTOM_SIZE;
+  }
+  else {
+    return slot_p->sa_mem;
+  }
+}
+
+/*
+ * static int cache_find_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Look for a user pointer in the table of pointers handed out of a
+ * thread cache.
+ *
+ * RETURNS:
+ *
+ * Success - Index of the pointer's slot in the table.
+ *
+ * Failure - -1 if the pointer is not in the table.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache whose table we are searching.
+ *
+ * user_pnt -> User pointer we are looking for.
+ */
+static	int	cache_find_pnt(const thread_cache_t *cache_p,
+			       const void *user_pnt)
+{
+  skip_alloc_t	*slot_p;
+  unsigned int	pnt_c;
+  
+  for (pnt_c = CACHE_PNT_HASH(user_pnt);
+       (slot_p = cache_p->tc_pnts[pnt_c]) != NULL;
+       pnt_c = (pnt_c + 1) & (THREAD_CACHE_PNTS - 1)) {
+    if (cache_user_pnt(slot_p) == user_pnt) {
+      return pnt_c;
+    }
+  }
+  
+  return -1;
+}
+
+/*
+ * static void cache_insert_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Add the slot of a chunk to the table of pointers handed out of a
+ * thread cache and count it in its cache_handed bucket.  The table
+ * must not be full.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache whose table we are adding to.
+ *
+ * slot_p -> Slot of the chunk that we are handing out.
+ */
+static	void	cache_insert_pnt(thread_cache_t *cache_p, skip_alloc_t *slot_p)
+{
+  const void	*user_pnt = cache_user_pnt(slot_p);
+  unsigned int	pnt_c;
+  
+  for (pnt_c = CACHE_PNT_HASH(user_pnt);
+       cache_p->tc_pnts[pnt_c] != NULL;
+       pnt_c = (pnt_c + 1) & (THREAD_CACHE_PNTS - 1)) {
+  }
+  cache_p->tc_pnts[pnt_c] = slot_p;
+  cache_p->tc_pnt_n++;
+  (void)__sync_fetch_and_add(&cache_handed[CACHE_HANDED_HASH(user_pnt)], 1);
+}
+
+/*
+ * static void cache_drop_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Clear an entry from the table of pointers handed out of a thread
+ * cache and take it out of its cache_handed bucket.  This does not
+ * fix up the entries after it so the caller must do that unless the
+ * whole table is being emptied.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache whose table we are clearing.
+ *
+ * pnt_c -> Index of the entry that we are clearing.
+ */
+static	void	cache_drop_pnt(thread_cache_t *cache_p, unsigned int pnt_c)
+{
+  const void	*user_pnt = cache_user_pnt(cache_p->tc_pnts[pnt_c]);
+  
+  cache_p->tc_pnts[pnt_c] = NULL;
+  (void)__sync_fetch_and_sub(&cache_handed[CACHE_HANDED_HASH(user_pnt)], 1);
+}
+
+/*
+ * static void cache_remove_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Remove an entry from the table of pointers handed out of a thread
+ * cache.  The entries after it are shifted back so that our searches
+ * do not stop early.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache whose table we are removing from.
+ *
+ * pnt_c -> Index of the entry that we are removing.
+ */
+static	void	cache_remove_pnt(thread_cache_t *cache_p, unsigned int pnt_c)
+{
+  skip_alloc_t	*slot_p;
+  unsigned int	next_c, hash_c;
+  
+  cache_drop_pnt(cache_p, pnt_c);
+  cache_p->tc_pnt_n--;
+  
+  next_c = pnt_c;
+  while (1) {
+    next_c = (next_c + 1) & (THREAD_CACHE_PNTS - 1);
+    slot_p = cache_p->tc_pnts[next_c];
+    if (slot_p == NULL) {
+      break;
+    }
+    
+    /* leave the entry if its hash spot is between the hole and it */
+    hash_c = CACHE_PNT_HASH(cache_user_pnt(slot_p));
+    if (pnt_c <= next_c
+	? (pnt_c < hash_c && hash_c <= next_c)
+	: (pnt_c < hash_c || hash_c <= next_c)) {
+      continue;
+    }
+    
+    cache_p->tc_pnts[pnt_c] = slot_p;
+    cache_p->tc_pnts[next_c] = NULL;
+    pnt_c = next_c;
+  }
+}
+
+/*
+ * static int cache_size_bit
+ *
+ * DESCRIPTION:
+ *
+ * Find the chunk size that the thread caches use for an allocation.
+ *
+ * RETURNS:
+ *
+ * Index into the bit_sizes array.
+ *
+ * ARGUMENTS:
+ *
+ * size -> Size of the allocation including any fence-post overhead.
+ * It must not be larger than half a block.
+ */
+static	int	cache_size_bit(const unsigned int size)
+{
+  int	bit_c;
+  
+  for (bit_c = 0; (unsigned int)bit_sizes[bit_c] < size; bit_c++) {
+  }
+  
+  return bit_c;
+}
+
+/*
+ * static void cache_adopt
+ *
+ * DESCRIPTION:
+ *
+ * Take a pointer that was handed out of a thread cache back under the
+ * control of the library.  The cache's counts for the pointer are
+ * moved to the library's counts.  The caller must hold the library
+ * lock and the cache's lock and must have removed the pointer from
+ * the cache's table.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache which handed out the pointer.
+ *
+ * slot_p -> Slot of the pointer's chunk.
+ */
+static	void	cache_adopt(thread_cache_t *cache_p, skip_alloc_t *slot_p)
+{
+  BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_CACHED);
+  
+#if MEMORY_TABLE_TOP_LOG
+  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT)) {
+    _dmalloc_table_insert(&mem_table_alloc, slot_p->sa_file, slot_p->sa_line,
+			  slot_p->sa_user_size);
+  }
+#endif
+  
+  STATS_MOVE_START();
+  cache_p->tc_alloc_current -= slot_p->sa_user_size;
+  cache_p->tc_cur_given -= slot_p->sa_total_size;
+  cache_p->tc_cur_pnts--;
+  
+  alloc_current += slot_p->sa_user_size;
+  alloc_maximum = MAX(alloc_maximum, alloc_current);
+  alloc_cur_given += slot_p->sa_total_size;
+  alloc_max_given = MAX(alloc_max_given, alloc_cur_given);
+  free_space_bytes -= slot_p->sa_total_size;
+  alloc_cur_pnts++;
+  alloc_max_pnts = MAX(alloc_max_pnts, alloc_cur_pnts);
+  STATS_MOVE_END();
+}
+
+/*
+ * static int cache_flush
+ *
+ * DESCRIPTION:
+ *
+ * Give all of the chunks in a thread cache back to the library and
+ * add the cache's counts into the library's.  The caller must hold
+ * the library lock and the cache's lock.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Thread cache that we are flushing.
+ */
+static	int	cache_flush(thread_cache_t *cache_p)
+{
+  skip_alloc_t	*slot_p;
+  unsigned int	pnt_c;
+  int		bit_c, ret = 1;
+  
+  if (cache_p->tc_magic1 != THREAD_CACHE_MAGIC1
+      || cache_p->tc_magic2 != THREAD_CACHE_MAGIC2) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("cache_flush");
+    return 0;
+  }
+  
+  /* the freed chunks go on to the wait list in the order they were freed */
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    for (; cache_p->tc_free_n[bit_c] > 0; cache_p->tc_free_n[bit_c]--) {
+      slot_p = cache_p->tc_free[bit_c][cache_p->tc_free_start[bit_c]];
+      cache_p->tc_free_start[bit_c] =
+	(cache_p->tc_free_start[bit_c] + 1) % THREAD_CACHE_SIZE;
+      BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_CACHED);
+      if (BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)) {
+	continue;
+      }
+      if (! wait_slot(slot_p)) {
+	/* error dumped in wait_slot */
+	ret = 0;
+      }
+    }
+  }
+  
+  /* the pointers that were handed out now belong to the library */
+  for (pnt_c = 0; pnt_c < THREAD_CACHE_PNTS; pnt_c++) {
+    slot_p = cache_p->tc_pnts[pnt_c];
+    if (slot_p == NULL) {
+      continue;
+    }
+    cache_drop_pnt(cache_p, pnt_c);
+    BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_CACHED);
+#if MEMORY_TABLE_TOP_LOG
+    if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT)) {
+      _dmalloc_table_insert(&mem_table_alloc, slot_p->sa_file,
+			    slot_p->sa_line, slot_p->sa_user_size);
+    }
+#endif
+  }
+  cache_p->tc_pnt_n = 0;
+  
+  /* add in our counts */
+  STATS_MOVE_START();
+  alloc_maximum = MAX(alloc_maximum, alloc_current + cache_p->tc_alloc_peak);
+  alloc_current += cache_p->tc_alloc_current;
+  alloc_max_given = MAX(alloc_max_given,
+			alloc_cur_given + cache_p->tc_given_peak);
+  alloc_cur_given += cache_p->tc_cur_given;
+  free_space_bytes -= cache_p->tc_cur_given;
+  alloc_max_pnts = MAX(alloc_max_pnts, alloc_cur_pnts + cache_p->tc_pnts_peak);
+  alloc_cur_pnts += cache_p->tc_cur_pnts;
+  alloc_tot_pnts += cache_p->tc_tot_pnts;
+  _dmalloc_alloc_total += cache_p->tc_alloc_total;
+  alloc_one_max = MAX(alloc_one_max, cache_p->tc_one_max);
+  func_malloc_c += cache_p->tc_malloc_c;
+  func_calloc_c += cache_p->tc_calloc_c;
+  func_new_c += cache_p->tc_new_c;
+  func_free_c += cache_p->tc_free_c;
+  func_delete_c += cache_p->tc_delete_c;
+  
+  cache_p->tc_alloc_current = 0;
+  cache_p->tc_alloc_peak = 0;
+  cache_p->tc_cur_given = 0;
+  cache_p->tc_given_peak = 0;
+  cache_p->tc_cur_pnts = 0;
+  cache_p->tc_pnts_peak = 0;
+  cache_p->tc_alloc_total = 0;
+  cache_p->tc_one_max = 0;
+  cache_p->tc_tot_pnts = 0;
+  cache_p->tc_malloc_c = 0;
+  cache_p->tc_calloc_c = 0;
+  cache_p->tc_new_c = 0;
+  cache_p->tc_free_c = 0;
+  cache_p->tc_delete_c = 0;
+  STATS_MOVE_END();
+  
+  return ret;
+}
+
+/*
+ * static int cache_flush_all
+ *
+ * DESCRIPTION:
+ *
+ * Flush all of the thread caches so that the library can look at all
+ * of the chunks in the heap.  The caller must hold the library lock.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	int	cache_flush_all(void)
+{
+  thread_cache_t	*cache_p;
+  int			ret = 1;
+  
+  for (cache_p = thread_caches; cache_p != NULL; cache_p = cache_p->tc_next_p) {
+    CACHE_LOCK(cache_p);
+    if (! cache_flush(cache_p)) {
+      /* error dumped in cache_flush */
+      ret = 0;
+    }
+    CACHE_UNLOCK(cache_p);
+  }
+  
+  return ret;
+}
+
+/*
+ * static void cache_sum
+ *
+ * DESCRIPTION:
+ *
+ * Add up the counts that the thread caches have not yet given to the
+ * library.  This does not lock the library or the caches so that
+ * stats can be read while other threads allocate.  The counts are
+ * changed by their cache's owner and, under the cache's lock, by
+ * threads freeing its pointers so the sums may be a little behind.
+ * The caller must check stats_seq to not count a flush twice.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * sum_p <- Pointer to a cache structure whose counts will be set to
+ * the sums over all of the caches.
+ */
+static	void	cache_sum(thread_cache_t *sum_p)
+{
+  const thread_cache_t	*cache_p;
+  
+  memset(sum_p, 0, sizeof(*sum_p));
+  
+  for (cache_p = thread_caches; cache_p != NULL; cache_p = cache_p->tc_next_p) {
+    sum_p->tc_alloc_current += cache_p->tc_alloc_current;
+    sum_p->tc_cur_given += cache_p->tc_cur_given;
+    sum_p->tc_cur_pnts += cache_p->tc_cur_pnts;
+    sum_p->tc_alloc_total += cache_p->tc_alloc_total;
+    sum_p->tc_one_max = MAX(sum_p->tc_one_max, cache_p->tc_one_max);
+  }
+}
+
+/*
+ * static void cache_stats
+ *
+ * DESCRIPTION:
+ *
+ * Read the library's counts with the caches' added in without
+ * locking.  If a cache is flushed while we are reading, we read them
+ * again so its counts are not seen in both places.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * current_p <- Pointer to an unsigned long which will be set to the
+ * current allocated space.
+ *
+ * cur_pnts_p <- Pointer to an unsigned long which will be set to the
+ * current number of pointers.
+ *
+ * free_space_p <- Pointer to an unsigned long which will be set to
+ * the free user space.
+ *
+ * one_max_p <- Pointer to an unsigned long which will be set to the
+ * maximum allocated with 1 call.
+ *
+ * total_p <- Pointer to an unsigned long which will be set to the
+ * total bytes allocated so far.
+ */
+static	void	cache_stats(unsigned long *current_p,
+			    unsigned long *cur_pnts_p,
+			    unsigned long *free_space_p,
+			    unsigned long *one_max_p, unsigned long *total_p)
+{
+  thread_cache_t	sum;
+  unsigned long		seq, free_space;
+  
+  do {
+    seq = stats_seq;
+    __sync_synchronize();
+    *current_p = alloc_current;
+    *cur_pnts_p = alloc_cur_pnts;
+    free_space = free_space_bytes;
+    *one_max_p = alloc_one_max;
+    *total_p = _dmalloc_alloc_total;
+    cache_sum(&sum);
+    __sync_synchronize();
+  } while ((seq & 1) || seq != stats_seq);
+  
+  *current_p += sum.tc_alloc_current;
+  *cur_pnts_p += sum.tc_cur_pnts;
+  /* a cache may have handed out chunks it got after we read the space */
+  if (sum.tc_cur_given > 0 && (unsigned long)sum.tc_cur_given > free_space) {
+    free_space = 0;
+  }
+  else {
+    free_space -= sum.tc_cur_given;
+  }
+  *free_space_p = free_space;
+  *one_max_p = MAX(*one_max_p, sum.tc_one_max);
+  *total_p += sum.tc_alloc_total;
+}
+
+/*
+ * static thread_cache_t *cache_owner
+ *
+ * DESCRIPTION:
+ *
+ * Find the thread cache which handed out a user pointer when it was
+ * not the current thread's.  The caches are locked one at a time in
+ * the order of the cache list.  The list only grows at its head and
+ * caches are never freed so this does not need the library lock.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the owning cache which is left locked.
+ *
+ * Failure - NULL if no other cache handed out the pointer.
+ *
+ * ARGUMENTS:
+ *
+ * user_pnt -> User pointer we are looking for.
+ *
+ * skip_p -> Cache which has already been searched or NULL if none.
+ *
+ * pnt_cp <- Pointer to an integer which will be set to the index of
+ * the pointer's slot in the owning cache's table.
+ */
+static	thread_cache_t	*cache_owner(const void *user_pnt,
+				     const thread_cache_t *skip_p,
+				     int *pnt_cp)
+{
+  thread_cache_t	*cache_p;
+  int			pnt_c;
+  
+  for (cache_p = thread_caches; cache_p != NULL; cache_p = cache_p->tc_next_p) {
+    if (cache_p == skip_p) {
+      continue;
+    }
+    CACHE_LOCK(cache_p);
+    if (cache_p->tc_pnt_n > 0) {
+      pnt_c = cache_find_pnt(cache_p, user_pnt);
+      if (pnt_c >= 0) {
+	*pnt_cp = pnt_c;
+	return cache_p;
+      }
+    }
+    CACHE_UNLOCK(cache_p);
+  }
+  
+  return NULL;
+}
+
+/*
+ * static void cache_reclaim
+ *
+ * DESCRIPTION:
+ *
+ * Make sure that the chunk holding an address does not belong to a
+ * thread cache before the library looks at it.  If any thread handed
+ * out the pointer then we just take it back from that thread's cache.
+ * Otherwise the chunk is waiting in a cache's free ring and all of the
+ * caches are flushed.  The caller must hold the library lock.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * address -> Address that the library is about to look up.
+ */
+static	void	cache_reclaim(const void *address)
+{
+  thread_cache_t	*cache_p;
+  slab_block_t		*slab_p;
+  skip_alloc_t		*slot_p;
+  int			pnt_c;
+  
+  if (thread_caches == NULL || address == NULL) {
+    return;
+  }
+  
+  slab_p = find_slab(address);
+  if (slab_p == NULL) {
+    return;
+  }
+  slot_p = SLAB_CHUNK(slab_p, address);
+  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_CACHED)) {
+    return;
+  }
+  
+  cache_p = cache_current();
+  if (cache_p != NULL) {
+    CACHE_LOCK(cache_p);
+    pnt_c = cache_find_pnt(cache_p, address);
+    if (pnt_c >= 0) {
+      cache_remove_pnt(cache_p, pnt_c);
+      cache_adopt(cache_p, slot_p);
+      CACHE_UNLOCK(cache_p);
+      return;
+    }
+    CACHE_UNLOCK(cache_p);
+  }
+  
+  /* another thread may have handed it out */
+  cache_p = cache_owner(address, cache_p, &pnt_c);
+  if (cache_p != NULL) {
+    cache_remove_pnt(cache_p, pnt_c);
+    cache_adopt(cache_p, slot_p);
+    CACHE_UNLOCK(cache_p);
+    return;
+  }
+  
+  (void)cache_flush_all();
+}
+
+/*
+ * static thread_cache_t *cache_create
+ *
+ * DESCRIPTION:
+ *
+ * Set up a cache for the current thread.  We reuse the cache of a
+ * thread which has exited or allocate a new one from the heap.  The
+ * caller must hold the library lock.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the thread's cache.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	thread_cache_t	*cache_create(void)
+{
+  thread_cache_t	*cache_p;
+  skip_alloc_t		*admin_p;
+  unsigned int		admin_size;
+  
+  for (cache_p = thread_caches; cache_p != NULL; cache_p = cache_p->tc_next_p) {
+    if (! cache_p->tc_used_b) {
+      break;
+    }
+  }
+  
+  if (cache_p == NULL) {
+    admin_size = (sizeof(thread_cache_t) + BLOCK_SIZE - 1) / BLOCK_SIZE *
+      BLOCK_SIZE;
+    
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+      dmalloc_message("need a thread cache of %u bytes", admin_size);
+    }
+    
+    cache_p = _dmalloc_heap_alloc(admin_size);
+    if (cache_p == HEAP_ALLOC_ERROR) {
+      /* error code set in _dmalloc_heap_alloc */
+      return NULL;
+    }
+    memset(cache_p, 0, admin_size);
+    admin_block_c += admin_size / BLOCK_SIZE;
+    
+    /* account for the admin space on the used list */
+    admin_p = get_slot();
+    if (admin_p == NULL) {
+      /* error code set in get_slot */
+      return NULL;
+    }
+    admin_p->sa_flags = ALLOC_FLAG_ADMIN;
+    admin_p->sa_mem = cache_p;
+    admin_p->sa_total_size = admin_size;
+    if (! insert_slot(admin_p, 0 /* used list */)) {
+      /* error set in insert_slot */
+      return NULL;
+    }
+    
+    cache_p->tc_magic1 = THREAD_CACHE_MAGIC1;
+#if HAVE_PTHREAD_MUTEX_INIT
+    pthread_mutex_init(&cache_p->tc_mutex, THREAD_LOCK_INIT_VAL);
+#endif
+    cache_p->tc_magic2 = THREAD_CACHE_MAGIC2;
+    /* set up before it goes on the list since frees walk it unlocked */
+    cache_p->tc_next_p = thread_caches;
+    __sync_synchronize();
+    thread_caches = cache_p;
+  }
+  
+  if (pthread_setspecific(cache_key, cache_p) != 0) {
+    return NULL;
+  }
+  cache_p->tc_used_b = 1;
+  
+  return cache_p;
+}
+
+#endif /* LOCK_THREADS && THREAD_CACHE_SIZE > 0 */
+
+/***************************** exported routines *****************************/
+
+/*
+ * int _dmalloc_chunk_startup
+ * 
+ * DESCRIPTION:
+ *
+ * Startup the low level malloc routines.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+int	_dmalloc_chunk_startup(void)
+{
+  unsigned int	value;
+  char		*pos_p, *max_p;
+  int		bit_c, *bits_p;
+  
+  value = FENCE_MAGIC_BOTTOM;
+  max_p = fence_bottom + FENCE_BOTTOM_SIZE;
+  for (pos_p = fence_bottom;
+       pos_p < max_p;
+       pos_p += sizeof(value)) {
+    if (pos_p + sizeof(value) <= max_p) {
+      memcpy(pos_p, (char *)&value, sizeof(value));
+    }
+    else {
+      memcpy(pos_p, (char *)&value, max_p - pos_p);
+    }
+  }
+  
+  value = FENCE_MAGIC_TOP;
+  max_p = fence_top + FENCE_TOP_SIZE;
+  for (pos_p = fence_top; pos_p < max_p; pos_p += sizeof(value)) {
+    if (pos_p + sizeof(value) <= max_p) {
+      memcpy(pos_p, (char *)&value, sizeof(value));
+    }
+    else {
+      memcpy(pos_p, (char *)&value, max_p - pos_p);
+    }
+  }
+  
+  /* initialize the bits array */
+  bits_p = bit_sizes;
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    if ((1 << bit_c) >= CHUNK_SMALLEST_BLOCK) {
+      *bits_p++ = 1 << bit_c;
+    }
+  }
+  
+  /* set the admin flags on the two statically allocated slots */
+  skip_free_list->sa_flags = ALLOC_FLAG_ADMIN;
+  skip_address_list->sa_flags = ALLOC_FLAG_ADMIN;
+  
+  _dmalloc_table_init(&mem_table_alloc, mem_table_alloc_entries,
+		      sizeof(mem_table_alloc_entries) /
+		      sizeof(*mem_table_alloc_entries));
+  _dmalloc_table_init(&mem_table_changed, mem_table_changed_entries,
+		      sizeof(mem_table_changed_entries) /
+		      sizeof(*mem_table_changed_entries));
+  
+  _dmalloc_chunk_flags_changed();
+  
+  return 1;
+}
+
+/*
+ * void _dmalloc_chunk_flags_changed
+ *
+ * DESCRIPTION:
+ *
+ * Look at the debug flags after they have been changed to see if the
+ * allocation routines can take their short path which only tracks
+ * the pointers.  This should be called with the library lock held.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+void	_dmalloc_chunk_flags_changed(void)
+{
+  plain_b = (! BIT_IS_SET(_dmalloc_flags, POINTER_DEBUG_FLAGS));
+}
+
+/*
+ * char *_dmalloc_chunk_desc_pnt
+ *
+ * DESCRIPTION:
+ *
+ * Write into a buffer a pointer description with file and
+ * line-number.
+ *
+ * RETURNS:
+ *
+ * Pointer to buffer 1st argument.
+ *
+ * ARGUMENTS:
+ *
+ * buf <-> Passed in buffer which will be filled with a description of
+ * the pointer.
+ *
+ * buf_size -> Size of the buffer in bytes.
+ *
+ * file -> File name, return address, or NULL.
+ *
+ * line -> Line number or 0.
+ */
+char	*_dmalloc_chunk_desc_pnt(char *buf, const int buf_size,
+				 const char *file, const unsigned int line)
+{
+  if (file == DMALLOC_DEFAULT_FILE && line == DMALLOC_DEFAULT_LINE) {
+    (void)loc_snprintf(buf, buf_size, "unknown");
+  }
+  else if (line == DMALLOC_DEFAULT_LINE) {
+    (void)loc_snprintf(buf, buf_size, "ra=%#lx", (unsigned long)file);
+  }
+  else if (file == DMALLOC_DEFAULT_FILE) {
+    (void)loc_snprintf(buf, buf_size, "ra=ERROR(line=%u)", line);
+  }
+  else {
+    (void)loc_snprintf(buf, buf_size, "%.*s:%u", MAX_FILE_LENGTH, file, line);
+  }
+  
+  return buf;
+}
+
+/*
+ * void *_dmalloc_chunk_admin_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Get zeroed administrative space straight from the heap for the
+ * library's own tables so it never comes out of the user's
+ * allocations.  It is accounted for on the used list and is never
+ * given back.
+ *
+ * RETURNS:
+ *
+ * Success - Block aligned pointer to the space.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes that we need.  It is rounded up to the
+ * block-size.
+ */
+void	*_dmalloc_chunk_admin_alloc(const unsigned int size)
+{
+  skip_alloc_t	*admin_p;
+  void		*mem;
+  unsigned int	need_size;
+  
+  need_size = (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  
+  mem = _dmalloc_heap_alloc(need_size);
+  if (mem == HEAP_ALLOC_ERROR) {
+    /* error code set in _dmalloc_heap_alloc */
+    return NULL;
+  }
+  memset(mem, 0, need_size);
+  admin_block_c += need_size / BLOCK_SIZE;
+  
+  /* account for the space on the used list */
+  admin_p = get_slot();
+  if (admin_p == NULL) {
+    /* error code set in get_slot */
+    return NULL;
+  }
+  admin_p->sa_flags = ALLOC_FLAG_ADMIN;
+  admin_p->sa_mem = mem;
+  admin_p->sa_total_size = need_size;
+  if (! insert_slot(admin_p, 0 /* used list */)) {
+    /* error set in insert_slot */
+    return NULL;
+  }
+  
+  return mem;
+}
+
+/*
+ * int _dmalloc_chunk_read_info
+ *
+ * DESCRIPTION:
+ *
+ * Return some information associated with a pointer.
+ *
+ * RETURNS:
+ *
+ * Success - 1 pointer is okay
+ *
+ * Failure - 0 problem with pointer
+ *
+ * ARGUMENTS:
+ *
+ * user_pnt -> Pointer we are checking.
+ *
+ * where <- Where the check is being made from.
+ *
+ * user_size_p <- Pointer to an unsigned int which, if not NULL, will
+ * be set to the size of bytes that the user requested.
+ *
+ * alloc_size_p <- Pointer to an unsigned int which, if not NULL, will
+ * be set to the total given size of bytes including block overhead.
+ *
+ * file_p <- Pointer to a character pointer which, if not NULL, will
+ * be set to the file where the pointer was allocated.
+ *
+ * line_p <- Pointer to a character pointer which, if not NULL, will
+ * be set to the line-number where the pointer was allocated.
+ *
+ * ret_attr_p <- Pointer to a void pointer, if not NULL, will be set
+ * to the return-address where the pointer was allocated.
+ *
+ * seen_cp <- Pointer to an unsigned long which, if not NULL, will be
+ * set to the number of times the pointer has been "seen".
+ *
+ * used_p <- Pointer to an unsigned long which, if not NULL, will be
+ * set to the last time the pointer was "used".
+ *
+ * valloc_bp <- Pointer to an integer which, if not NULL, will be set
+ * to 1 if the pointer was allocated with valloc otherwise 0.
+ *
+ * fence_bp <- Pointer to an integer which, if not NULL, will be set
+ * to 1 if the pointer has the fence bit set otherwise 0.
+ */
+int	_dmalloc_chunk_read_info(const void *user_pnt, const char *where,
+				 unsigned int *user_size_p,
+				 unsigned int *alloc_size_p, char **file_p,
+				 unsigned int *line_p, void **ret_attr_p,
+				 unsigned long **seen_cp,
+				 unsigned long *used_p, int *valloc_bp,
+				 int *fence_bp)
+{
+  skip_alloc_t	*slot_p;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+    dmalloc_message("reading info about pointer '%#lx'",
+		    (unsigned long)user_pnt);
+  }
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  cache_reclaim(user_pnt);
+#endif
+  
+  /* find the pointer with loose checking for fence */
+  slot_p = find_user_slot(user_pnt, 0 /* not exact pointer */);
+  if (slot_p == NULL) {
+    dmalloc_errno = ERROR_NOT_FOUND;
+    log_error_info(NULL, 0, user_pnt, NULL, "finding address in heap", where);
+    return 0;
+  }
+  
+  /* might as well check the pointer now */
+  if (! check_used_slot(slot_p, user_pnt, 1 /* exact */, 0 /* no strlen */,
+			0 /* no min-size */, 1 /* check blank */)) {
+    /* errno set in check_slot */
+    log_error_info(NULL, 0, user_pnt, slot_p, "checking pointer admin", where);
+    return 0;
+  }
+  
+  /* write info back to user space */
+  SET_POINTER(user_size_p, slot_p->sa_user_size);
+  SET_POINTER(alloc_size_p, slot_p->sa_total_size);
+  if (slot_p->sa_file == DMALLOC_DEFAULT_FILE) {
+    SET_POINTER(file_p, NULL);
+  }
+  else {
+    SET_POINTER(file_p, (char *)slot_p->sa_file);
+  }
+  SET_POINTER(line_p, slot_p->sa_line);
+  /* if the line is blank then the file will be 0 or the return address */
+  if (slot_p->sa_line == DMALLOC_DEFAULT_LINE) {
+    SET_POINTER(ret_attr_p, (char *)slot_p->sa_file);
+  }
+  else {
+    SET_POINTER(ret_attr_p, NULL);
+  }
+#if LOG_PNT_SEEN_COUNT
+  SET_POINTER(seen_cp, &slot_p->sa_seen_c);
+#else
+  SET_POINTER(seen_cp, NULL);
+#endif
+  SET_POINTER(used_p, slot_p->sa_use_iter);
+  SET_POINTER(valloc_bp, BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC));
+  SET_POINTER(fence_bp, BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE));
+  
+  return 1;
+}
+
+/******************************* heap checking *******************************/
+
+/*
+ * static int check_entry_block
+ *
+ * DESCRIPTION:
+ *
+ * Check one of the blocks of admin slots.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the block is okay
+ *
+ * Failure - 0 if a problem was detected
+ *
+ * ARGUMENTS:
+ *
+ * block_p -> Admin block that we are checking.
+ *
+ * level_c -> Level of the slots which the block should hold.
+ */
+static	int	check_entry_block(const entry_block_t *block_p,
+				  const int level_c)
+{
+  skip_alloc_t	*slot_p;
+  unsigned int	*magic3_p, magic3;
+  
+  /* better be in the heap */
+  if (! IS_IN_HEAP(block_p)) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("check_entry_block");
+    return 0;
+  }
+  
+  /* get the magic3 at the end of the block */
+  magic3_p = (unsigned int *)((char *)block_p + BLOCK_SIZE -
+			      sizeof(*magic3_p));
+  memcpy(&magic3, magic3_p, sizeof(magic3));
+  
+  /* check magics */
+  if (block_p->eb_magic1 != ENTRY_BLOCK_MAGIC1
+      || block_p->eb_magic2 != ENTRY_BLOCK_MAGIC2
+      || magic3 != ENTRY_BLOCK_MAGIC3) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("check_entry_block");
+    return 0;
+  }
+  
+  /* check for a valid level */
+  if (block_p->eb_level_n != level_c) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("check_entry_block");
+    return 0;
+  }
+  
+  /* now we look up the block and make sure it exists and is valid */
+  slot_p = find_address(block_p, 0 /* used list */, 1 /* exact */,
+			skip_update);
+  if (slot_p == NULL) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("check_entry_block");
+    return 0;
+  }
+  if ((! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ADMIN))
+      || slot_p->sa_mem != block_p
+      || slot_p->sa_total_size != BLOCK_SIZE
+      || slot_p->sa_level_n != level_c) {
+    dmalloc_errno = ERROR_ADMIN_LIST;
+    dmalloc_error("check_entry_block");
+    return 0;
+  }
+  
+  /*
+   * NOTE: we could now check each of the entries in the block to
+   * make sure that they are valid and on the used or free list
+   */
+  
+  return 1;
+}
+
+/*
+ * static int check_walk_slot
+ *
+ * DESCRIPTION:
+ *
+ * Check one of the slots that we got from a heap walk.  Problems with
+ * the allocation itself are logged and we go on but problems with the
+ * admin lists mean that the walk cannot continue.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the walk can continue
+ *
+ * Failure - 0 if the admin lists are corrupt
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are checking.
+ *
+ * list_c -> Which list of the walk the slot came from.
+ *
+ * blank_b -> Set to 0 if the blanked memory of the slot has already
+ * been checked by the heap check threads.
+ *
+ * final_p <- Pointer to an integer which is set to 0 if there is a
+ * problem with the slot's allocation.
+ */
+static	int	check_walk_slot(const skip_alloc_t *slot_p, const int list_c,
+				const int blank_b, int *final_p)
+{
+  skip_alloc_t	*block_slot_p;
+  entry_block_t	*block_p;
+  int		used_b;
+  
+  /* better be in the heap */
+  if (! IS_IN_HEAP(slot_p)) {
+    dmalloc_errno = ERROR_ADDRESS_LIST;
+    dmalloc_error("check_walk_slot");
+    return 0;
+  }
+  
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED)) {
+    /* chunk slots are in the divided-block admin space checked already */
+    used_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER);
+  }
+  else {
+    /*
+     * now we look up the slot pointer itself and make sure it exists
+     * in a valid block
+     */
+    block_slot_p = find_address(slot_p, 0 /* used list */,
+				0 /* not exact pointer */, skip_update);
+    if (block_slot_p == NULL) {
+      dmalloc_errno = ERROR_ADMIN_LIST;
+      dmalloc_error("check_walk_slot");
+      return 0;
+    }
+    
+    /* point at the block */
+    block_p = block_slot_p->sa_mem;
+    
+    /* check block magic */
+    if (block_p->eb_magic1 != ENTRY_BLOCK_MAGIC1) {
+      dmalloc_errno = ERROR_ADDRESS_LIST;
+      dmalloc_error("check_walk_slot");
+      return 0;
+    }
+    
+    /* make sure the slot level matches */
+    if (slot_p->sa_level_n != block_p->eb_level_n) {
+      dmalloc_errno = ERROR_ADDRESS_LIST;
+      dmalloc_error("check_walk_slot");
+      return 0;
+    }
+    
+    /* used slots should be found through the page map */
+    if (list_c == HEAP_WALK_USED
+	&& find_used_slot(slot_p->sa_mem) != slot_p) {
+      dmalloc_errno = ERROR_ADDRESS_LIST;
+      dmalloc_error("check_walk_slot");
+      return 0;
+    }
+    
+    /* the ends of free runs should be in the page map */
+    if (list_c == HEAP_WALK_FREE
+	&& (page_map_get(slot_p->sa_mem) != slot_p
+	    || page_map_get((char *)slot_p->sa_mem +
+			    slot_p->sa_total_size - 1) != slot_p)) {
+      dmalloc_errno = ERROR_ADDRESS_LIST;
+      dmalloc_error("check_walk_slot");
+      return 0;
+    }
+    
+    used_b = (list_c == HEAP_WALK_USED);
+  }
+  
+  /* now check the allocation */
+  if (used_b) {
+    if (! check_used_slot(slot_p, NULL /* no user pnt */,
+			  0 /* loose pnt checking */, 0 /* no strlen */,
+			  0 /* no min-size */, blank_b)) {
+      /* error set in check_slot */
+      log_error_info(NULL, 0, NULL, slot_p, "checking user pointer",
+		     "check_walk_slot");
+      /* not a critical error */
+      *final_p = 0;
+    }
+  }
+  else {
+    if (! check_free_slot(slot_p, blank_b)) {
+      /* error set in check_slot */
+      log_error_info(NULL, 0, NULL, slot_p, "checking free pointer",
+		     "check_walk_slot");
+      /* not a critical error */
+      *final_p = 0;
+    }
+  }
+  
+  return 1;
+}
+
+/*
+ * static unsigned long scan_size
+ *
+ * DESCRIPTION:
+ *
+ * Get the number of bytes of blanked memory that the heap check has
+ * to read for a slot.
+ *
+ * RETURNS:
+ *
+ * Number of bytes.
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are checking.
+ *
+ * list_c -> Which list of the walk the slot came from.
+ */
+static	unsigned long	scan_size(const skip_alloc_t *slot_p, const int list_c)
+{
+  int	used_b;
+  
+  if ((! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK))
+      || BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_PROTECTED)) {
+    return 0;
+  }
+  
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED)) {
+    used_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER);
+  }
+  else {
+    used_b = (list_c == HEAP_WALK_USED);
+  }
+  
+  /* only the space around the user area of an allocation is blank */
+  if (used_b) {
+    return slot_p->sa_total_size - slot_p->sa_user_size;
+  }
+  else {
+    return slot_p->sa_total_size;
+  }
+}
+
+/*
+ * static int scan_slot
+ *
+ * DESCRIPTION:
+ *
+ * Check the blanked memory of a slot for one of the heap check
+ * threads.  This only reads the slot and its memory and does not
+ * report anything.  A slot that does not look sane enough to read
+ * also fails so that the full checks can report on it.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the blanked memory is okay
+ *
+ * Failure - 0 if the slot needs to be checked fully
+ *
+ * ARGUMENTS:
+ *
+ * slot_p -> Slot that we are checking.
+ *
+ * list_c -> Which list of the walk the slot came from.
+ */
+static	int	scan_slot(const skip_alloc_t *slot_p, const int list_c)
+{
+  pnt_info_t	pnt_info;
+  int		used_b;
+  
+  if ((! IS_IN_HEAP(slot_p))
+      || (! IS_IN_HEAP(slot_p->sa_mem))
+      || slot_p->sa_total_size == 0
+      || (! IS_IN_HEAP((char *)slot_p->sa_mem + slot_p->sa_total_size - 1))) {
+    return 0;
+  }
+  
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED)) {
+    used_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_USER);
+  }
+  else {
+    used_b = (list_c == HEAP_WALK_USED);
+  }
+  
+  if (! used_b) {
+    if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)
+	&& (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_PROTECTED))) {
+      return (free_blank_bad(slot_p) == NULL);
+    }
+    return 1;
+  }
+  
+  if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK)) {
+    return 1;
+  }
+  get_pnt_info(slot_p, &pnt_info);
+  if ((char *)pnt_info.pi_user_start < (char *)pnt_info.pi_alloc_start
+      || (char *)pnt_info.pi_user_bounds < (char *)pnt_info.pi_user_start
+      || (char *)pnt_info.pi_alloc_bounds < (char *)pnt_info.pi_user_bounds
+      || (char *)pnt_info.pi_alloc_bounds >
+      (char *)slot_p->sa_mem + slot_p->sa_total_size) {
+    return 0;
+  }
+  return (alloc_blank_bad(&pnt_info, 0 /* below */) == NULL
+	  && alloc_blank_bad(&pnt_info, 1 /* above */) == NULL);
+}
+
+/*
+ * static void check_range
+ *
+ * DESCRIPTION:
+ *
+ * Scan the blanked memory of the slots in one part of the heap
+ * and record the first slot that fails.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * range_p <-> Part of the heap that we are checking.
+ */
+static	void	check_range(check_range_t *range_p)
+{
+  heap_walk_t	walk;
+  skip_alloc_t	*slot_p;
+  unsigned long	slot_c;
+  
+  walk = range_p->cr_walk;
+  for (slot_c = 0; slot_c < range_p->cr_slot_n; slot_c++) {
+    slot_p = heap_walk_next(&walk);
+    if (slot_p == NULL || (! scan_slot(slot_p, walk.hw_list_c))) {
+      break;
+    }
+  }
+  range_p->cr_bad_c = slot_c;
+}
+
+#if LOCK_THREADS
+/*
+ * static void *check_thread
+ *
+ * DESCRIPTION:
+ *
+ * Body of the heap check threads.  They wait for the parts of a
+ * heap check to be handed out and scan them while the checking
+ * thread holds the library lock.
+ *
+ * RETURNS:
+ *
+ * Never returns.
+ *
+ * ARGUMENTS:
+ *
+ * arg -> Unused.
+ */
+static	void	*check_thread(void *arg)
+{
+  int	range_c;
+  
+  (void)arg;
+  
+  pthread_mutex_lock(&check_mutex);
+  while (1) {
+    while (check_range_next >= check_range_n) {
+      pthread_cond_wait(&check_work_cond, &check_mutex);
+    }
+    range_c = check_range_next++;
+    pthread_mutex_unlock(&check_mutex);
+    
+    check_range(check_ranges + range_c);
+    
+    pthread_mutex_lock(&check_mutex);
+    check_range_done++;
+    if (check_range_done == check_range_n) {
+      pthread_cond_signal(&check_done_cond);
+    }
+  }
+  
+  /*NOTREACHED*/
+  return NULL;
+}
+#endif
+
+/*
+ * static unsigned long check_split
+ *
+ * DESCRIPTION:
+ *
+ * Split the heap into a part for each of the check-threads, by
+ * the amount of blanked memory, and scan the parts at the same time.
+ * The parts are made and their results are merged in the order of
+ * the heap walk so the first slot that fails is always the same
+ * no matter which thread finished first.
+ *
+ * RETURNS:
+ *
+ * Number of slots at the start of the heap walk whose blanked memory
+ * is known to be okay.  The rest need the full checks.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	unsigned long	check_split(void)
+{
+  check_range_t	*range_p, *bounds_p;
+  skip_alloc_t	*slot_p;
+  heap_walk_t	walk, hold;
+  unsigned long	total, size, good_n;
+  int		range_n;
+  
+  if (_dmalloc_check_threads <= 1) {
+    return 0;
+  }
+  range_n = MIN(_dmalloc_check_threads, CHECK_RANGE_MAX);
+  
+  /* first find out how much we have to scan */
+  total = 0;
+  memset(&walk, 0, sizeof(walk));
+  while (1) {
+    slot_p = heap_walk_next(&walk);
+    if (slot_p == NULL) {
+      break;
+    }
+    total += scan_size(slot_p, walk.hw_list_c);
+  }
+  if (total < (unsigned long)range_n * CHECK_RANGE_MIN_SIZE) {
+    return 0;
+  }
+  
+  /* now cut the walk into parts with about the same amount to scan */
+  range_p = check_ranges;
+  bounds_p = check_ranges + range_n;
+  memset(&walk, 0, sizeof(walk));
+  range_p->cr_walk = walk;
+  range_p->cr_slot_n = 0;
+  size = 0;
+  while (1) {
+    hold = walk;
+    slot_p = heap_walk_next(&walk);
+    if (slot_p == NULL) {
+      break;
+    }
+    if (size >= total / range_n && range_p + 1 < bounds_p) {
+      range_p++;
+      range_p->cr_walk = hold;
+      range_p->cr_slot_n = 0;
+      size = 0;
+    }
+    range_p->cr_slot_n++;
+    size += scan_size(slot_p, walk.hw_list_c);
+  }
+  range_n = range_p + 1 - check_ranges;
+  
+#if LOCK_THREADS
+  /* hand out the parts and help with them until they are all done */
+  pthread_mutex_lock(&check_mutex);
+  check_range_next = 0;
+  check_range_done = 0;
+  check_range_n = range_n;
+  pthread_cond_broadcast(&check_work_cond);
+  while (check_range_next < check_range_n) {
+    range_p = check_ranges + check_range_next++;
+    pthread_mutex_unlock(&check_mutex);
+    check_range(range_p);
+    pthread_mutex_lock(&check_mutex);
+    check_range_done++;
+  }
+  while (check_range_done < check_range_n) {
+    pthread_cond_wait(&check_done_cond, &check_mutex);
+  }
+  check_range_n = 0;
+  check_range_next = 0;
+  pthread_mutex_unlock(&check_mutex);
+#else
+  for (range_p = check_ranges; range_p < check_ranges + range_n; range_p++) {
+    check_range(range_p);
+  }
+#endif
+  
+  /* the good slots run up to the first one that failed */
+  good_n = 0;
+  for (range_p = check_ranges; range_p < check_ranges + range_n; range_p++) {
+    good_n += range_p->cr_bad_c;
+    if (range_p->cr_bad_c < range_p->cr_slot_n) {
+      break;
+    }
+  }
+  
+  return good_n;
+}
+
+#if LOCK_THREADS
+/*
+ * void _dmalloc_chunk_check_start
+ *
+ * DESCRIPTION:
+ *
+ * Start the threads that help with the heap check if the
+ * check-threads setting asks for more of them.  This must be called
+ * without the library lock.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+void	_dmalloc_chunk_check_start(void)
+{
+  pthread_t	thread;
+  
+  /* the checking thread is one of them */
+  if (_dmalloc_check_threads == check_thread_want) {
+    return;
+  }
+  
+  pthread_mutex_lock(&check_mutex);
+  check_thread_want = _dmalloc_check_threads;
+  while (check_thread_n + 1 < MIN(check_thread_want, CHECK_RANGE_MAX)) {
+    if (pthread_create(&thread, NULL, check_thread, NULL) != 0) {
+      break;
+    }
+    (void)pthread_detach(thread);
+    check_thread_n++;
+  }
+  pthread_mutex_unlock(&check_mutex);
+}
+#endif
+
+/*
+ * int _dmalloc_chunk_heap_check
+ *
+ * DESCRIPTION:
+ *
+ * Run extensive tests on the entire heap.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the heap is okay
+ *
+ * Failure - 0 if a problem was detected
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+int	_dmalloc_chunk_heap_check(void)
+{
+  skip_alloc_t	*slot_p;
+  entry_block_t	*block_p;
+  slab_block_t	*slab_p;
+  heap_walk_t	walk;
+  unsigned long	slot_c, good_n;
+  int		level_c, bit_c;
+  int		final = 1;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
     dmalloc_message("checking heap");
   }
   
-  heap_check_c++;
+  heap_check_c++;
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  /* we need to see the chunks that the thread caches are holding */
+  if (! cache_flush_all()) {
+    /* error dumped in cache_flush_all */
+    final = 0;
+  }
+#endif
+  
+  /*
+   * first, run through all of the admin structures and check for
+   * validity
+   */
+  for (level_c = 0; level_c < MAX_SKIP_LEVEL; level_c++) {
+    for (block_p = entry_blocks[level_c];
+	 block_p != NULL;
+	 block_p = block_p->eb_next_p) {
+      if (! check_entry_block(block_p, level_c)) {
+	/* error dumped in check_entry_block */
+	return 0;
+      }
+    }
+  }
+  
+  /* now run through the divided-blocks and check their admin space */
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    for (slab_p = slab_blocks[bit_c];
+	 slab_p != NULL;
+	 slab_p = slab_p->sb_next_p) {
+      if (! check_slab(slab_p, bit_c)) {
+	dmalloc_errno = ERROR_ADMIN_LIST;
+	dmalloc_error("_dmalloc_chunk_heap_check");
+	return 0;
+      }
+    }
+  }
+  
+  /* have the check-threads scan the blanked memory */
+  good_n = check_split();
+  
+  /*
+   * Now run through the used pointers and check each one.  The
+   * blanked memory of the first good_n has already been scanned.
+   */
+  memset(&walk, 0, sizeof(walk));
+  for (slot_c = 0;; slot_c++) {
+    slot_p = heap_walk_next(&walk);
+    if (slot_p == NULL) {
+      break;
+    }
+    if (! check_walk_slot(slot_p, walk.hw_list_c, (slot_c >= good_n),
+			  &final)) {
+      /* error dumped in check_walk_slot */
+      return 0;
+    }
+  }
+  
+  return final;
+}
+
+/*
+ * int _dmalloc_chunk_heap_step
+ *
+ * DESCRIPTION:
+ *
+ * Run the tests of _dmalloc_chunk_heap_check on the next part of the
+ * heap, picking up where the last call left off, so that the work of
+ * each call is limited by the check-budget setting.  Each admin block
+ * and each block of memory in a slot counts as one against the
+ * budget.  When we get to the end of the heap, the next call starts
+ * over at the beginning.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the part of the heap is okay
+ *
+ * Failure - 0 if a problem was detected
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+int	_dmalloc_chunk_heap_step(void)
+{
+  skip_alloc_t	*slot_p;
+  slab_block_t	*slab_p;
+  unsigned long	budget = 0;
+  int		final = 1;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+    dmalloc_message("checking part of heap");
+  }
+  
+  /* are we starting a new pass through the heap? */
+  if (! step_pass_b) {
+    heap_check_c++;
+    
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+    /* we need to see the chunks that the thread caches are holding */
+    if (! cache_flush_all()) {
+      /* error dumped in cache_flush_all */
+      final = 0;
+    }
+#endif
+    
+    step_level_c = 0;
+    step_block_p = entry_blocks[0];
+    memset(&step_walk, 0, sizeof(step_walk));
+    step_pass_b = 1;
+  }
+  
+  /* the admin blocks are only ever added to the front of their lists */
+  while (step_level_c < MAX_SKIP_LEVEL && budget < _dmalloc_check_budget) {
+    if (step_block_p == NULL) {
+      step_level_c++;
+      if (step_level_c < MAX_SKIP_LEVEL) {
+	step_block_p = entry_blocks[step_level_c];
+      }
+      continue;
+    }
+    if (! check_entry_block(step_block_p, step_level_c)) {
+      /* error dumped in check_entry_block */
+      step_pass_b = 0;
+      return 0;
+    }
+    step_block_p = step_block_p->eb_next_p;
+    budget++;
+  }
+  
+  /* then the slots from where we left off */
+  heap_walk_resume(&step_walk);
+  while (budget < _dmalloc_check_budget) {
+    slot_p = heap_walk_next(&step_walk);
+    if (slot_p == NULL) {
+      step_pass_b = 0;
+      break;
+    }
+    
+    /* check the admin space of a divided-block at its first chunk */
+    slab_p = step_walk.hw_slab_p;
+    if (slab_p != NULL && step_walk.hw_chunk_c == 1
+	&& (slab_p->sb_bit_c >= BASIC_BLOCK
+	    || (! check_slab(slab_p, slab_p->sb_bit_c)))) {
+      dmalloc_errno = ERROR_ADMIN_LIST;
+      dmalloc_error("_dmalloc_chunk_heap_step");
+      step_pass_b = 0;
+      return 0;
+    }
+    
+    if (! check_walk_slot(slot_p, step_walk.hw_list_c, 1 /* check blank */,
+			  &final)) {
+      /* error dumped in check_walk_slot */
+      step_pass_b = 0;
+      return 0;
+    }
+    budget += (slot_p->sa_total_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  }
+  
+  return final;
+}
+
+/*
+ * int _dmalloc_chunk_pnt_check
+ *
+ * DESCRIPTION:
+ *
+ * Run extensive tests on a pointer.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the pointer is okay
+ *
+ * Failure - 0 if not
+ *
+ * ARGUMENTS:
+ *
+ * func -> Function string which is checking the pointer.
+ *
+ * user_pnt -> Pointer we are checking.
+ *
+ * exact_b -> Set to 1 to find the pointer specifically.  Otherwise we
+ * can find the pointer inside of an allocation.
+ *
+ * strlen_b -> Make sure that pnt can hold at least a strlen + 1
+ * bytes.  If 0 then ignore.
+ *
+ * min_size -> Make sure that pnt can hold at least that many bytes.
+ * If 0 then ignore.
+ */
+int	_dmalloc_chunk_pnt_check(const char *func, const void *user_pnt,
+				 const int exact_b, const int strlen_b,
+				 const int min_size)
+{
+  skip_alloc_t	*slot_p;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+    if (func == NULL) {
+      dmalloc_message("checking pointer '%#lx'", (unsigned long)user_pnt);
+    }
+    else {
+      dmalloc_message("checking func '%s' pointer '%#lx'",
+		      func, (unsigned long)user_pnt);
+    }
+  }
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  cache_reclaim(user_pnt);
+#endif
+  
+  /* try to find the address */
+  slot_p = find_user_slot(user_pnt, 0 /* not exact pointer */);
+  if (slot_p == NULL) {
+    if (exact_b) {
+      dmalloc_errno = ERROR_NOT_FOUND;
+      log_error_info(NULL, 0, user_pnt, NULL, "pointer-check", func);
+      return 0;
+    }
+    else {
+      return 1;
+    }
+  }
+  
+  /* now make sure that the user slot is valid */
+  if (! check_used_slot(slot_p, user_pnt, exact_b, strlen_b, min_size,
+			1 /* check blank */)) {
+    /* dmalloc_error set in check_used_slot */
+    log_error_info(NULL, 0, user_pnt, slot_p, "pointer-check", func);
+    return 0;
+  }
+  
+  return 1;
+}
+
+/*
+ * static int sample_skip
+ *
+ * DESCRIPTION:
+ *
+ * With the sample-rate setting, decide whether an allocation skips
+ * the fence-posts, blanking, and memory table.  The next allocation to
+ * be fully checked is a random 1 to 2N - 1 allocations away so on
+ * average 1 in N are checked but a program cannot fall into step with
+ * the sampling.
+ *
+ * RETURNS:
+ *
+ * 1 if the allocation should skip the checks else 0.
+ *
+ * ARGUMENTS:
+ *
+ * count_p <-> Pointer to the count of allocations until the next
+ * sample.
+ */
+static	int	sample_skip(unsigned long *count_p)
+{
+  if (_dmalloc_sample_rate <= 1) {
+    return 0;
+  }
+  if (*count_p > 0) {
+    (*count_p)--;
+    return 1;
+  }
+  *count_p = _dmalloc_rand() % (2 * _dmalloc_sample_rate - 1);
+  return 0;
+}
+
+#if PROTECT_ALLOWED
+
+/*
+ * static int guard_site
+ *
+ * DESCRIPTION:
+ *
+ * Decide whether the guard setting picks out an allocation to be put
+ * up against a guard page because of where it was made or its size.
+ *
+ * RETURNS:
+ *
+ * 1 if the allocation should be guarded else 0.
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * size -> Number of bytes to allocate.
+ */
+static	int	guard_site(const char *file, const unsigned int line,
+			   const unsigned long size)
+{
+  if (_dmalloc_guard_max > 0
+      && size >= _dmalloc_guard_min
+      && size <= _dmalloc_guard_max) {
+    return 1;
+  }
+  
+  if (_dmalloc_guard_file != NULL
+      && file != DMALLOC_DEFAULT_FILE
+      && line != DMALLOC_DEFAULT_LINE
+      && strcmp(_dmalloc_guard_file, file) == 0
+      && (_dmalloc_guard_line == 0
+	  || (unsigned int)_dmalloc_guard_line == line)) {
+    return 1;
+  }
+  
+  return 0;
+}
+
+#endif /* PROTECT_ALLOWED */
+
+/*
+ * static void *plain_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Allocate a chunk of memory when none of the per-pointer debug
+ * flags are enabled.  This is the rest of _dmalloc_chunk_malloc
+ * without the fence-post, blanking, timing, and transaction work.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * size -> Number of bytes to allocate.
+ *
+ * func_id -> Calling function-id as defined in dmalloc.h.
+ *
+ * light_b -> Set to 1 if the allocation was not picked by the
+ * sample-rate.
+ */
+static	void	*plain_alloc(const char *file, const unsigned int line,
+			     const unsigned long size, const int func_id,
+			     const int light_b)
+{
+  skip_alloc_t	*slot_p;
+  
+  /* get some space for our memory */
+  slot_p = get_memory(size);
+  if (slot_p == NULL) {
+    /* errno set in get_slot */
+    return MALLOC_ERROR;
+  }
+  if (light_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT);
+  }
+  slot_p->sa_user_size = size;
+  
+  /* initialize the bblocks */
+  alloc_cur_given += slot_p->sa_total_size;
+  alloc_max_given = MAX(alloc_max_given, alloc_cur_given);
+  
+  /* without fence-posts the user pointer is the start of the slot */
+  if ((func_id == DMALLOC_FUNC_CALLOC || func_id == DMALLOC_FUNC_RECALLOC)
+      && size > 0
+      && (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ZERO))) {
+    memset(slot_p->sa_mem, 0, size);
+  }
+  BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_ZERO);
+  
+  slot_p->sa_file = file;
+  slot_p->sa_line = line;
+  slot_p->sa_use_iter = _dmalloc_iter_c;
+#if LOG_PNT_SEEN_COUNT
+  slot_p->sa_seen_c++;
+#endif
+#if LOG_PNT_ITERATION
+  slot_p->sa_iteration = _dmalloc_iter_c;
+#endif
+#if LOG_PNT_THREAD_ID
+  slot_p->sa_thread_id = THREAD_GET_ID();
+#endif
+  
+#if MEMORY_TABLE_TOP_LOG
+  if (! light_b) {
+    _dmalloc_table_insert(&mem_table_alloc, file, line, size);
+  }
+#endif
+  
+  /* monitor current allocation level */
+  alloc_current += size;
+  alloc_maximum = MAX(alloc_maximum, alloc_current);
+  _dmalloc_alloc_total += size;
+  alloc_one_max = MAX(alloc_one_max, size);
+  
+  /* monitor pointer usage */
+  alloc_cur_pnts++;
+  alloc_max_pnts = MAX(alloc_max_pnts, alloc_cur_pnts);
+  alloc_tot_pnts++;
+  
+  return slot_p->sa_mem;
+}
+
+/************************** low-level user functions *************************/
+
+/*
+ * void *_dmalloc_chunk_malloc
+ *
+ * DESCRIPTION:
+ *
+ * Allocate a chunk of memory.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * size -> Number of bytes to allocate.
+ *
+ * func_id -> Calling function-id as defined in dmalloc.h.
+ *
+ * alignment -> If greater than 0 then try to align the returned
+ * block.
+ */
+void	*_dmalloc_chunk_malloc(const char *file, const unsigned int line,
+			       const unsigned long size, const int func_id,
+			       const unsigned int alignment)
+{
+  unsigned long	needed_size;
+  unsigned int	align_off = 0, block_n;
+  int		valloc_b = 0, memalign_b = 0, fence_b = 0, light_b, guard_b;
+  char		where_buf[MAX_FILE_LENGTH + 64], disp_buf[64];
+  skip_alloc_t	*slot_p;
+  pnt_info_t	pnt_info;
+  const char	*trans_log;
+  
+  /* counts calls to malloc */
+  if (func_id == DMALLOC_FUNC_CALLOC) {
+    func_calloc_c++;
+  }
+  else if (alignment == BLOCK_SIZE) {
+    func_valloc_c++;
+    valloc_b = 1;
+  }
+  else if (alignment > 0) {
+    func_memalign_c++;
+    memalign_b = 1;
+  }
+  else if (func_id == DMALLOC_FUNC_NEW) {
+    func_new_c++;
+  }
+  else if (func_id != DMALLOC_FUNC_REALLOC
+	   && func_id != DMALLOC_FUNC_RECALLOC) {
+    func_malloc_c++;
+  }
+  
+#if ALLOW_ALLOC_ZERO_SIZE == 0
+  if (size == 0) {
+    dmalloc_errno = ERROR_BAD_SIZE;
+    log_error_info(file, line, NULL, NULL, "bad zero byte allocation request",
+		   "malloc");
+    return MALLOC_ERROR;
+  }
+#endif
+  
+#if LARGEST_ALLOCATION
+  /* have we exceeded the upper bounds */
+  if (size > LARGEST_ALLOCATION) {
+    dmalloc_errno = ERROR_TOO_BIG;
+    log_error_info(file, line, NULL, NULL, "allocation too big", "malloc");
+    return MALLOC_ERROR;
+  }
+#endif
+  
+  needed_size = size;
+  light_b = sample_skip(&sample_c);
+#if PROTECT_ALLOWED
+  guard_b = ((BIT_IS_SET(_dmalloc_flags, DEBUG_GUARD_PAGES) && (! light_b))
+	     || guard_site(file, line, size));
+#else
+  guard_b = 0;
+#endif
+  
+  /* the flags were checked when they were changed */
+  if (plain_b && alignment == 0 && (! guard_b)) {
+    return plain_alloc(file, line, size, func_id, light_b);
+  }
+  
+  /* adjust the size */
+  if (guard_b) {
+    /*
+     * Guarded allocations get whole blocks with an extra no-access
+     * block on top.  The user pointer is pushed up against it, as far
+     * as the alignment allows, so an overrun faults right away.  The
+     * guard page takes the place of the fence-posts.
+     */
+    needed_size = MAX(alignment, ALLOCATION_ALIGNMENT);
+    needed_size = (size + needed_size - 1) / needed_size * needed_size;
+    block_n = (needed_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (block_n == 0) {
+      block_n = 1;
+    }
+    align_off = block_n * BLOCK_SIZE - needed_size;
+    needed_size = (block_n + 1) * BLOCK_SIZE;
+  }
+  else if (BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_FENCE) && (! light_b)) {
+    needed_size += FENCE_OVERHEAD_SIZE;
+    fence_b = 1;
+    
+    /*
+     * If the user is requesting a page-aligned block of data then we
+     * will need another block below the allocation just for the fence
+     * information.  Ugh.
+     */
+    if (valloc_b) {
+      needed_size += BLOCK_SIZE;
+    }
+    /*
+     * Otherwise the bottom fence-post goes at the top of enough space
+     * that the user pointer lands on the alignment.  Divided-block
+     * chunks and whole blocks are aligned on their own size so the
+     * allocation needs to be at least as large as the alignment.
+     */
+    else if (memalign_b && alignment > FENCE_BOTTOM_SIZE) {
+      align_off = (FENCE_BOTTOM_SIZE + alignment - 1) / alignment * alignment;
+      needed_size += align_off - FENCE_BOTTOM_SIZE;
+    }
+  }
+  else if (memalign_b && needed_size < alignment) {
+    needed_size = alignment;
+  }
+  else if (valloc_b && needed_size <= BLOCK_SIZE / 2) {
+    /*
+     * If we are valloc-ing, make sure that we get a blocksized chunk
+     * because they are always block aligned.  We know here that fence
+     * posting is not on otherwise it would have been set above.
+     */
+    needed_size = BLOCK_SIZE;
+  }
+  
+  /* get some space for our memory */
+  slot_p = get_memory(needed_size);
+  if (slot_p == NULL) {
+    /* errno set in get_slot */
+    return MALLOC_ERROR;
+  }
+  if (fence_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE);
+  }
+  if (valloc_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC);
+  }
+  if (guard_b) {
+    /* if we cannot protect the top block the allocation goes without */
+    if (_dmalloc_protect_set_no_access((char *)slot_p->sa_mem +
+				       slot_p->sa_total_size - BLOCK_SIZE,
+				       1)) {
+      BIT_SET(slot_p->sa_flags, ALLOC_FLAG_GUARD);
+      slot_p->sa_align_off = align_off;
+    }
+  }
+  else if (align_off > 0) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_ALIGNED);
+    slot_p->sa_align_off = align_off;
+  }
+  if (light_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT);
+  }
+  slot_p->sa_user_size = size;
+  
+  /* initialize the bblocks */
+  alloc_cur_given += slot_p->sa_total_size;
+  alloc_max_given = MAX(alloc_max_given, alloc_cur_given);
+  
+  get_pnt_info(slot_p, &pnt_info);
+  
+  /* clear the allocation */
+  clear_alloc(slot_p, &pnt_info, 0 /* no old-size */, func_id);
+  
+  slot_p->sa_file = file;
+  slot_p->sa_line = line;
+  slot_p->sa_use_iter = _dmalloc_iter_c;
+#if LOG_PNT_SEEN_COUNT
+  slot_p->sa_seen_c++;
+#endif
+#if LOG_PNT_ITERATION
+  slot_p->sa_iteration = _dmalloc_iter_c;
+#endif
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ELAPSED_TIME)
+      || BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_CURRENT_TIME)) {
+#if LOG_PNT_TIMEVAL
+    GET_TIMEVAL(slot_p->sa_timeval);
+#else
+#if LOG_PNT_TIME
+    slot_p->sa_time = time(NULL);
+#endif
+#endif
+  }
+  
+#if LOG_PNT_THREAD_ID
+  slot_p->sa_thread_id = THREAD_GET_ID();
+#endif
   
-  /*
-   * first, run through all of the admin structures and check for
-   * validity
-   */
-  for (level_c = 0; level_c < MAX_SKIP_LEVEL; level_c++) {
-    unsigned int	*magic3_p, magic3;
-    
-    /* run through the blocks and test them */
-    for (block_p = entry_blocks[level_c];
-	 block_p != NULL;
-	 block_p = block_p->eb_next_p) {
-      
-      /* better be in the heap */
-      if (! IS_IN_HEAP(block_p)) {
-	dmalloc_errno = ERROR_ADMIN_LIST;
-	dmalloc_error("_dmalloc_chunk_heap_check");
-	return 0;
-      }
-      
-      /* get the magic3 at the end of the block */
-      magic3_p = (unsigned int *)((char *)block_p + BLOCK_SIZE -
-				  sizeof(*magic3_p));
-      memcpy(&magic3, magic3_p, sizeof(magic3));
-      
-      /* check magics */
-      if (block_p->eb_magic1 != ENTRY_BLOCK_MAGIC1
-	  || block_p->eb_magic2 != ENTRY_BLOCK_MAGIC2
-	  || magic3 != ENTRY_BLOCK_MAGIC3) {
-	dmalloc_errno = ERROR_ADMIN_LIST;
-	dmalloc_error("_dmalloc_chunk_heap_check");
-	return 0;
-      }
-      
-      /* check for a valid level */
-      if (block_p->eb_level_n != level_c) {
-	dmalloc_errno = ERROR_ADMIN_LIST;
-	dmalloc_error("_dmalloc_chunk_heap_check");
-	return 0;
-      }
-      
-      /* now we look up the block and make sure it exists and is valid */
-      slot_p = find_address(block_p, 0 /* used list */, 1 /* exact */,
-			    skip_update);
-      if (slot_p == NULL) {
-	dmalloc_errno = ERROR_ADMIN_LIST;
-	dmalloc_error("_dmalloc_chunk_heap_check");
-	return 0;
-      }
-      if ((! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ADMIN))
-	  || slot_p->sa_mem != block_p
-	  || slot_p->sa_total_size != BLOCK_SIZE
-	  || slot_p->sa_level_n != level_c) {
-	dmalloc_errno = ERROR_ADMIN_LIST;
-	dmalloc_error("_dmalloc_chunk_heap_check");
-	return 0;
-      }
-      
-      /*
-       * NOTE: we could now check each of the entries in the block to
-       * make sure that they are valid and on the used or free list
-       */
+  /* do we need to print transaction info? */
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+    switch (func_id) {
+    case DMALLOC_FUNC_CALLOC:
+      trans_log = "calloc";
+      break;
+    case DMALLOC_FUNC_MEMALIGN:
+      trans_log = "memalign";
+      break;
+    case DMALLOC_FUNC_VALLOC:
+      trans_log = "valloc";
+      break;
+    default:
+      trans_log = "alloc";
+      break;
     }
+    dmalloc_message("*** %s: at '%s' for %ld bytes, got '%s'",
+		    trans_log,
+		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					    file, line),
+		    size, display_pnt(pnt_info.pi_user_start, slot_p, disp_buf,
+				      sizeof(disp_buf)));
   }
   
-  /*
-   * Now run through the used pointers and check each one.
-   */
-  for (slot_p = skip_address_list->sa_next_p[0];
-       ;
-       slot_p = slot_p->sa_next_p[0]) {
-    skip_alloc_t	*block_slot_p;
+#if MEMORY_TABLE_TOP_LOG
+  if (! light_b) {
+    _dmalloc_table_insert(&mem_table_alloc, file, line, size);
+  }
+#endif
+  
+  /* monitor current allocation level */
+  alloc_current += size;
+  alloc_maximum = MAX(alloc_maximum, alloc_current);
+  _dmalloc_alloc_total += size;
+  alloc_one_max = MAX(alloc_one_max, size);
+  
+  /* monitor pointer usage */
+  alloc_cur_pnts++;
+  alloc_max_pnts = MAX(alloc_max_pnts, alloc_cur_pnts);
+  alloc_tot_pnts++;
+  
+  return pnt_info.pi_user_start;
+}
+
+/*
+ * int _dmalloc_chunk_free
+ *
+ * DESCRIPTION:
+ *
+ * Free a user pointer from the heap.
+ *
+ * RETURNS:
+ *
+ * Success - FREE_NOERROR
+ *
+ * Failure - FREE_ERROR
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * user_pnt -> Pointer we are freeing.
+ *
+ * func_id -> Function ID
+ */
+int	_dmalloc_chunk_free(const char *file, const unsigned int line,
+			    void *user_pnt, const int func_id)
+{
+  char		where_buf[MAX_FILE_LENGTH + 64];
+  char		where_buf2[MAX_FILE_LENGTH + 64], disp_buf[64];
+  skip_alloc_t	*slot_p;
+  int		divided_b, light_b, guard_b;
+  
+  /* counts calls to free */
+  if (func_id == DMALLOC_FUNC_DELETE) {
+    func_delete_c++;
+  }
+  else if (func_id == DMALLOC_FUNC_REALLOC
+	   || func_id == DMALLOC_FUNC_RECALLOC) {
+    /* ignore these because they will alredy be accounted for in realloc */
+  }
+  else {
+    func_free_c++;
+  }
+  
+  if (user_pnt == NULL) {
+    
+#if ALLOW_FREE_NULL_MESSAGE
+    /* does the user want a specific message? */
+    dmalloc_message("WARNING: tried to free(0) from '%s'",
+		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					    file, line));
+#endif
     
     /*
-     * switch to the free list in the middle after we've checked the
-     * used pointer slots
+     * NOTE: we have here both a default in the settings.h file and a
+     * runtime token in case people want to turn it on or off at
+     * runtime.
      */
-    if (slot_p == NULL) {
-      checking_list_c++;
-      if (checking_list_c == 1) {
-	slot_p = skip_free_list->sa_next_p[0];
-      }
-#if FREED_POINTER_DELAY
-      else if (checking_list_c == 2) {
-	slot_p = free_wait_list_head;
-      }
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_ERROR_FREE_NULL)) {
+      dmalloc_errno = ERROR_IS_NULL;
+      log_error_info(file, line, user_pnt, NULL, "invalid 0L pointer", "free");
+      return FREE_ERROR;
+    }
+    
+#if ALLOW_FREE_NULL == 0
+    dmalloc_errno = ERROR_IS_NULL;
+#endif
+    return FREE_ERROR;
+  }
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  cache_reclaim(user_pnt);
 #endif
+  
+  /* try to find the address with loose match */
+  slot_p = find_user_slot(user_pnt, 0 /* not exact pointer */);
+  if (slot_p == NULL) {
+    skip_alloc_t	*del_p;
+    slab_block_t	*slab_p;
+    pnt_info_t		info;
+    
+    /* the slots on the wait list are still in the page map */
+    del_p = page_map_get(user_pnt);
+    if (del_p != NULL
+	&& BIT_IS_SET(del_p->sa_flags, ALLOC_FLAG_WAIT)
+	&& (char *)del_p->sa_mem <= (char *)user_pnt
+	&& (char *)del_p->sa_mem + del_p->sa_total_size > (char *)user_pnt) {
+      get_pnt_info(del_p, &info);
+      if (info.pi_user_start == user_pnt) {
+	dmalloc_errno = ERROR_ALREADY_FREE;
+      }
       else {
-	/* we are done */
-	break;
+	dmalloc_errno = ERROR_NOT_FOUND;
       }
-      if (slot_p == NULL) {
-	break;
+    }
+    else if ((slab_p = find_slab(user_pnt)) != NULL) {
+      /* freed chunks stay in their divided-block */
+      del_p = SLAB_CHUNK(slab_p, user_pnt);
+      get_pnt_info(del_p, &info);
+      if (del_p->sa_use_iter > 0 && info.pi_user_start == user_pnt) {
+	dmalloc_errno = ERROR_ALREADY_FREE;
+      }
+      else {
+	dmalloc_errno = ERROR_NOT_FOUND;
       }
     }
-    
-    /* better be in the heap */
-    if (! IS_IN_HEAP(slot_p)) {
+    /* not in the used list so check the free list */
+    else if (find_address(user_pnt, 1 /* free list */,
+			  0 /* not exact pointer */, skip_update) == NULL) {
+      dmalloc_errno = ERROR_NOT_FOUND;
+    }
+    else {
+      dmalloc_errno = ERROR_ALREADY_FREE;
+    }
+    log_error_info(file, line, user_pnt, NULL, "finding address in heap",
+		   "free");
+    return FREE_ERROR;
+  }
+  
+  if (! check_used_slot(slot_p, user_pnt, 1 /* exact pnt */, 0 /* no strlen */,
+			0 /* no min-size */, 1 /* check blank */)) {
+    /* error set in check slot */
+    log_error_info(file, line, user_pnt, slot_p, "checking pointer admin",
+		   "free");
+    return FREE_ERROR;
+  }
+  
+  /* the guard page goes back to the heap with the rest of the slot */
+  guard_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_GUARD);
+  if (guard_b
+      && (! _dmalloc_protect_set_read_write((char *)slot_p->sa_mem +
+					    slot_p->sa_total_size - BLOCK_SIZE,
+					    1))) {
+    dmalloc_errno = ERROR_ALLOC_FAILED;
+    dmalloc_error("_dmalloc_chunk_free");
+    return FREE_ERROR;
+  }
+  
+  /*
+   * Divided-block chunks are not on the used list themselves.  The
+   * others need the links to them from the used list.  Their page map
+   * entries are kept while they are on the wait list so double frees
+   * can be looked up.  With never-reuse we clear them at the ends so
+   * the slot is never merged with its neighbors.
+   */
+  divided_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED);
+  light_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT);
+  if (! divided_b) {
+    if (find_address(slot_p->sa_mem, 0 /* used list */, 1 /* exact */,
+		     skip_update) != slot_p) {
+      /* sanity check */
       dmalloc_errno = ERROR_ADDRESS_LIST;
-      dmalloc_error("_dmalloc_chunk_heap_check");
-      return 0;
+      dmalloc_error("_dmalloc_chunk_free");
+      return FREE_ERROR;
     }
-    
+    if (! remove_slot(slot_p, skip_update)) {
+      /* error set and dumped in remove_slot */
+      return FREE_ERROR;
+    }
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)) {
+      page_map_set(slot_p, NULL);
+    }
+  }
+  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE)) {
     /*
-     * now we look up the slot pointer itself and make sure it exists
-     * in a valid block
+     * We need to preserve the fence-post flag because we may need to
+     * properly check for previously freed pointers in the future.
      */
-    block_slot_p = find_address(slot_p, 0 /* used list */,
-				0 /* not exact pointer */, skip_update);
-    if (block_slot_p == NULL) {
-      dmalloc_errno = ERROR_ADMIN_LIST;
-      dmalloc_error("_dmalloc_chunk_heap_check");
-      return 0;
+    if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_ALIGNED)) {
+      slot_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_FENCE |
+	ALLOC_FLAG_ALIGNED;
     }
+    else {
+      slot_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_FENCE;
+    }
+  }
+  else if (guard_b) {
+    /* same for the guard flag, the guard page itself is gone */
+    slot_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_GUARD;
+  }
+  else {
+    slot_p->sa_flags = ALLOC_FLAG_FREE;
+  }
+  if (divided_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED);
+  }
+  if (light_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT);
+  }
+  
+  alloc_cur_pnts--;
+  
+  slot_p->sa_use_iter = _dmalloc_iter_c;
+#if LOG_PNT_SEEN_COUNT
+  slot_p->sa_seen_c++;
+#endif
+  
+  /* the per-pointer debugging is skipped if the flags have none */
+  if (! plain_b) {
     
-    /* point at the block */
-    block_p = block_slot_p->sa_mem;
-    
-    /* check block magic */
-    if (block_p->eb_magic1 != ENTRY_BLOCK_MAGIC1) {
-      dmalloc_errno = ERROR_ADDRESS_LIST;
-      dmalloc_error("_dmalloc_chunk_heap_check");
-      return 0;
+    /* do we need to print transaction info? */
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+      dmalloc_message("*** free: at '%s' pnt '%s': size %u, alloced at '%s'",
+		      _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					      file, line),
+		      display_pnt(user_pnt, slot_p, disp_buf,
+				  sizeof(disp_buf)),
+		      slot_p->sa_user_size,
+		      _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
+					      slot_p->sa_file,
+					      slot_p->sa_line));
     }
     
-    /* make sure the slot level matches */
-    if (slot_p->sa_level_n != block_p->eb_level_n) {
-      dmalloc_errno = ERROR_ADDRESS_LIST;
-      dmalloc_error("_dmalloc_chunk_heap_check");
-      return 0;
+    /* clear the memory */
+    if ((BIT_IS_SET(_dmalloc_flags, DEBUG_FREE_BLANK)
+	 || BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK))
+	&& (! light_b)) {
+      memset(slot_p->sa_mem, FREE_BLANK_CHAR, slot_p->sa_total_size);
+      /* set our slot blank flag */
+      BIT_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
     }
     
-    /* now check the allocation */
-    if (checking_list_c == 0) {
-      ret = check_used_slot(slot_p, NULL /* no user pnt */,
-			    0 /* loose pnt checking */, 0 /* no strlen */,
-			    0 /* no min-size */);
-      if (! ret) {
-	/* error set in check_slot */
-	log_error_info(NULL, 0, NULL, slot_p, "checking user pointer",
-		       "_dmalloc_chunk_heap_check");
-	/* not a critical error */
-	final = 0;
-      }
+    /*
+     * Make the whole blocks no-access until they are used again so
+     * any use of the freed pointer faults right away.  With
+     * never-reuse they stay that way.
+     */
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_PROTECT_FREE)
+	&& (! divided_b) && (! light_b)
+	&& _dmalloc_protect_set_no_access(slot_p->sa_mem,
+					  slot_p->sa_total_size / BLOCK_SIZE)) {
+      BIT_SET(slot_p->sa_flags, ALLOC_FLAG_PROTECTED);
+      free_protect_bytes += slot_p->sa_total_size;
     }
-    else {
-      ret = check_free_slot(slot_p);
-      if (! ret) {
-	/* error set in check_slot */
-	log_error_info(NULL, 0, NULL, slot_p, "checking free pointer",
-		       "_dmalloc_chunk_heap_check");
-	/* not a critical error */
-	final = 0;
-      }
+  }
+  
+#if MEMORY_TABLE_TOP_LOG
+  if (! light_b) {
+    _dmalloc_table_delete(&mem_table_alloc, slot_p->sa_file, slot_p->sa_line,
+			  slot_p->sa_user_size);
+  }
+#endif
+  
+  /* update the file/line -- must be after _dmalloc_table_delete */
+  slot_p->sa_file = file;
+  slot_p->sa_line = line;
+  
+  /* monitor current allocation level */
+  alloc_current -= slot_p->sa_user_size;
+  alloc_cur_given -= slot_p->sa_total_size;
+  free_space_bytes += slot_p->sa_total_size;
+  
+  /*
+   * Once the pointer is off of the wait list, insert_free_run combines
+   * it with any free neighbors above and below to help with
+   * fragmentation.  The merged run keeps the lower slot so the seen
+   * counter stays with its address.
+   *
+   * NOTE: the merged run's reuse-iter count will be moved ahead to the
+   * latest of the pieces.
+   */
+  
+  if (plain_b || (! BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE))) {
+    if (! wait_slot(slot_p)) {
+      /* error dumped in wait_slot */
+      return FREE_ERROR;
     }
+    /* give back the memory which has been sitting free for a while */
+    release_idle_memory();
   }
   
-  return final;
+  return FREE_NOERROR;
 }
 
 /*
- * int _dmalloc_chunk_pnt_check
+ * void *_dmalloc_chunk_realloc
  *
  * DESCRIPTION:
  *
- * Run extensive tests on a pointer.
+ * Re-allocate a chunk of memory either shrinking or expanding it.
  *
  * RETURNS:
  *
- * Success - 1 if the pointer is okay
+ * Success - Valid pointer.
  *
- * Failure - 0 if not
+ * Failure - NULL
  *
  * ARGUMENTS:
  *
- * func -> Function string which is checking the pointer.
+ * file -> File-name or return-address location of the allocation.
  *
- * user_pnt -> Pointer we are checking.
+ * line -> Line-number location of the allocation.
  *
- * exact_b -> Set to 1 to find the pointer specifically.  Otherwise we
- * can find the pointer inside of an allocation.
+ * old_user_pnt -> Old user pointer that we are reallocating.
  *
- * strlen_b -> Make sure that pnt can hold at least a strlen + 1
- * bytes.  If 0 then ignore.
+ * new_size -> New-size to change the pointer.
  *
- * min_size -> Make sure that pnt can hold at least that many bytes.
- * If 0 then ignore.
+ * func_id -> Calling function-id as defined in dmalloc.h.
  */
-int	_dmalloc_chunk_pnt_check(const char *func, const void *user_pnt,
-				 const int exact_b, const int strlen_b,
-				 const int min_size)
+void	*_dmalloc_chunk_realloc(const char *file, const unsigned int line,
+				void *old_user_pnt,
+				const unsigned long new_size,
+				const int func_id)
 {
+  const char	*old_file;
   skip_alloc_t	*slot_p;
+  pnt_info_t	pnt_info;
+  void		*new_user_pnt;
+  unsigned int	old_size, old_line;
   
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
-    if (func == NULL) {
-      dmalloc_message("checking pointer '%#lx'", (unsigned long)user_pnt);
-    }
-    else {
-      dmalloc_message("checking func '%s' pointer '%#lx'",
-		      func, (unsigned long)user_pnt);
-    }
+  /* counts calls to realloc */
+  if (func_id == DMALLOC_FUNC_RECALLOC) {
+    func_recalloc_c++;
+  }
+  else {
+    func_realloc_c++;
   }
   
-  /* try to find the address */
-  slot_p = find_address(user_pnt, 0 /* used list */, 0 /* not exact pointer */,
-			skip_update);
+#if ALLOW_ALLOC_ZERO_SIZE == 0
+  if (new_size == 0) {
+    dmalloc_errno = ERROR_BAD_SIZE;
+    log_error_info(file, line, NULL, NULL, "bad zero byte allocation request",
+		   "realloc");
+    return REALLOC_ERROR;
+  }
+#endif
+  
+#if LARGEST_ALLOCATION
+  /* have we exceeded the upper bounds, growing in place skips malloc */
+  if (new_size > LARGEST_ALLOCATION) {
+    dmalloc_errno = ERROR_TOO_BIG;
+    log_error_info(file, line, NULL, NULL, "allocation too big", "realloc");
+    return REALLOC_ERROR;
+  }
+#endif
+  
+  /* by now malloc.c should have taken care of the realloc(NULL) case */
+  if (old_user_pnt == NULL) {
+    dmalloc_errno = ERROR_IS_NULL;
+    log_error_info(file, line, old_user_pnt, NULL, "invalid pointer",
+		   "realloc");
+    return REALLOC_ERROR;
+  }
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  cache_reclaim(old_user_pnt);
+#endif
+  
+  /* find the old pointer with loose checking for fence post stuff */
+  slot_p = find_user_slot(old_user_pnt, 0 /* not exact pointer */);
   if (slot_p == NULL) {
-    if (exact_b) {
-      dmalloc_errno = ERROR_NOT_FOUND;
-      log_error_info(NULL, 0, user_pnt, NULL, "pointer-check", func);
-      return 0;
+    dmalloc_errno = ERROR_NOT_FOUND;
+    log_error_info(file, line, old_user_pnt, NULL, "finding address in heap",
+		   "realloc");
+    return 0;
+  }
+  
+  /* get info about the pointer */
+  get_pnt_info(slot_p, &pnt_info);
+  old_file = slot_p->sa_file;
+  old_line = slot_p->sa_line;
+  old_size = slot_p->sa_user_size;
+  
+  /* see if we can grow the whole-block allocations without copying */
+  if ((char *)pnt_info.pi_user_start + new_size >
+      (char *)pnt_info.pi_upper_bounds
+      && (! BIT_IS_SET(_dmalloc_flags, DEBUG_REALLOC_COPY))
+      && (! BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE))
+      && (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_DIVIDED))
+      && (! pnt_info.pi_guard_b)
+      && grow_slot(slot_p, (char *)pnt_info.pi_user_start + new_size -
+		   (char *)pnt_info.pi_upper_bounds)) {
+    get_pnt_info(slot_p, &pnt_info);
+  }
+  
+  /*
+   * If we are not realloc copying and the size is the same.  Guarded
+   * allocations are always moved so they end at their guard page.
+   */
+  if ((char *)pnt_info.pi_user_start + new_size >
+      (char *)pnt_info.pi_upper_bounds
+      || BIT_IS_SET(_dmalloc_flags, DEBUG_REALLOC_COPY)
+      || BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)
+      || pnt_info.pi_guard_b) {
+    int	min_size;
+    
+    /* allocate space for new chunk */
+    new_user_pnt = _dmalloc_chunk_malloc(file, line, new_size, func_id,
+				    0 /* no align */);
+    if (new_user_pnt == MALLOC_ERROR) {
+      return REALLOC_ERROR;
     }
-    else {
-      return 1;
+    
+    /*
+     * NOTE: _chunk_malloc() already took care of the fence stuff and
+     * zeroing of memory.
+     */
+    
+    /* copy stuff into new section of memory */
+    min_size = MIN(new_size, old_size);
+    if (min_size > 0) {
+      memcpy(new_user_pnt, pnt_info.pi_user_start, min_size);
+    }
+    
+    /* free old pointer */
+    if (_dmalloc_chunk_free(file, line, old_user_pnt,
+			    func_id) != FREE_NOERROR) {
+      return REALLOC_ERROR;
     }
   }
+  else {
+    /* new pointer is the same as the old one */
+    new_user_pnt = pnt_info.pi_user_start;
+    
+    /*
+     * monitor current allocation level
+     *
+     * NOTE: we do this here since the malloc/free used above take care
+     * on if in that section
+     */
+    alloc_current += new_size - old_size;
+    alloc_maximum = MAX(alloc_maximum, alloc_current);
+    _dmalloc_alloc_total += new_size;
+    alloc_one_max = MAX(alloc_one_max, new_size);
+    
+    /* monitor pointer usage */
+    alloc_tot_pnts++;
+    
+    /* change the slot information */
+    slot_p->sa_user_size = new_size;
+    get_pnt_info(slot_p, &pnt_info);
+    
+    clear_alloc(slot_p, &pnt_info, old_size, func_id);
+    
+    slot_p->sa_use_iter = _dmalloc_iter_c;
+#if LOG_PNT_SEEN_COUNT
+    /* we see in inbound and outbound so we need to increment by 2 */
+    slot_p->sa_seen_c += 2;
+#endif
+    
+#if MEMORY_TABLE_TOP_LOG
+    if (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT)) {
+      _dmalloc_table_delete(&mem_table_alloc, slot_p->sa_file,
+			    slot_p->sa_line, old_size);
+      _dmalloc_table_insert(&mem_table_alloc, file, line, new_size);
+    }
+#endif
   
-  /* now make sure that the user slot is valid */
-  if (! check_used_slot(slot_p, user_pnt, exact_b, strlen_b, min_size)) {
-    /* dmalloc_error set in check_used_slot */
-    log_error_info(NULL, 0, user_pnt, slot_p, "pointer-check", func);
-    return 0;
+    /*
+     * finally, we update the file/line info -- must be after
+     * _dmalloc_table functions
+     */
+    slot_p->sa_file = file;
+    slot_p->sa_line = line;
   }
   
-  return 1;
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
+    const char	*trans_log;
+    char	where_buf[MAX_FILE_LENGTH + 64];
+    char	where_buf2[MAX_FILE_LENGTH + 64];
+    
+    if (func_id == DMALLOC_FUNC_RECALLOC) {
+      trans_log = "recalloc";
+    }
+    else {
+      trans_log = "realloc";
+    }
+    dmalloc_message("*** %s: at '%s' from '%#lx' (%u bytes) file '%s' to '%#lx' (%lu bytes)",
+		    trans_log,
+		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
+					    file, line),
+		    (unsigned long)old_user_pnt, old_size,
+		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
+					    old_file, old_line),
+		    (unsigned long)new_user_pnt, new_size);
+  }
+  
+  return new_user_pnt;
 }
 
-/************************** low-level user functions *************************/
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+
+/* these flags need the library to see every transaction */
+#define CACHE_BYPASS_FLAGS	\
+	(DEBUG_CHECK_HEAP | DEBUG_LOG_TRANS | DEBUG_NEVER_REUSE | \
+	 DEBUG_GUARD_PAGES)
 
 /*
- * void *_dmalloc_chunk_malloc
+ * void *_dmalloc_chunk_cache_malloc
  *
  * DESCRIPTION:
  *
- * Allocate a chunk of memory.
+ * Allocate a chunk of memory out of the current thread's cache
+ * without the library lock.  The pointer gets the same fence-posts,
+ * blanking, and file/line information as from _dmalloc_chunk_malloc.
  *
  * RETURNS:
  *
  * Success - Valid pointer.
  *
- * Failure - NULL
+ * Failure - NULL if the allocation needs to be done by
+ * _dmalloc_chunk_malloc.
  *
  * ARGUMENTS:
  *
@@ -2334,102 +6438,80 @@ int	_dmalloc_chunk_pnt_check(const char *func, const void *user_pnt,
  * size -> Number of bytes to allocate.
  *
  * func_id -> Calling function-id as defined in dmalloc.h.
- *
- * alignment -> If greater than 0 then try to align the returned
- * block.
  */
-void	*_dmalloc_chunk_malloc(const char *file, const unsigned int line,
-			       const unsigned long size, const int func_id,
-			       const unsigned int alignment)
+void	*_dmalloc_chunk_cache_malloc(const char *file, const unsigned int line,
+				     const unsigned long size,
+				     const int func_id)
 {
-  unsigned long	needed_size;
-  int		valloc_b = 0, memalign_b = 0, fence_b = 0;
-  char		where_buf[MAX_FILE_LENGTH + 64], disp_buf[64];
-  skip_alloc_t	*slot_p;
-  pnt_info_t	pnt_info;
-  const char	*trans_log;
-  
-  /* counts calls to malloc */
-  if (func_id == DMALLOC_FUNC_CALLOC) {
-    func_calloc_c++;
-  }
-  else if (alignment == BLOCK_SIZE) {
-    func_valloc_c++;
-    valloc_b = 1;
-  }
-  else if (alignment > 0) {
-    func_memalign_c++;
-    memalign_b = 1;
-  }
-  else if (func_id == DMALLOC_FUNC_NEW) {
-    func_new_c++;
-  }
-  else if (func_id != DMALLOC_FUNC_REALLOC
-	   && func_id != DMALLOC_FUNC_RECALLOC) {
-    func_malloc_c++;
+  thread_cache_t	*cache_p;
+  skip_alloc_t		*slot_p;
+  pnt_info_t		pnt_info;
+  unsigned long		needed_size, iter_c;
+  int			bit_c, fence_b, light_b;
+  
+  if (BIT_IS_SET(_dmalloc_flags, CACHE_BYPASS_FLAGS)
+      || func_id == DMALLOC_FUNC_REALLOC || func_id == DMALLOC_FUNC_RECALLOC
+      || func_id == DMALLOC_FUNC_MEMALIGN || func_id == DMALLOC_FUNC_VALLOC) {
+    return NULL;
   }
-  
-#if ALLOW_ALLOC_ZERO_SIZE == 0
-  if (size == 0) {
-    dmalloc_errno = ERROR_BAD_SIZE;
-    log_error_info(file, line, NULL, NULL, "bad zero byte allocation request",
-		   "malloc");
-    return MALLOC_ERROR;
+#if ALLOW_ALLOC_ZERO_SIZE == 0
+  if (size == 0) {
+    return NULL;
   }
 #endif
-  
-#if LARGEST_ALLOCATION
-  /* have we exceeded the upper bounds */
-  if (size > LARGEST_ALLOCATION) {
-    dmalloc_errno = ERROR_TOO_BIG;
-    log_error_info(file, line, NULL, NULL, "allocation too big", "malloc");
-    return MALLOC_ERROR;
+#if PROTECT_ALLOWED
+  if (guard_site(file, line, size)) {
+    return NULL;
   }
 #endif
   
-  needed_size = size;
+  cache_p = cache_current();
+  if (cache_p == NULL) {
+    return NULL;
+  }
   
-  /* adjust the size */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_FENCE)) {
+  needed_size = size;
+  light_b = sample_skip(&cache_p->tc_sample_c);
+  fence_b = (BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_FENCE) && (! light_b));
+  if (fence_b) {
     needed_size += FENCE_OVERHEAD_SIZE;
-    fence_b = 1;
-    
-    /*
-     * If the user is requesting a page-aligned block of data then we
-     * will need another block below the allocation just for the fence
-     * information.  Ugh.
-     */
-    if (valloc_b) {
-      needed_size += BLOCK_SIZE;
-    }
   }
-  else if (valloc_b && needed_size <= BLOCK_SIZE / 2) {
-    /*
-     * If we are valloc-ing, make sure that we get a blocksized chunk
-     * because they are always block aligned.  We know here that fence
-     * posting is not on otherwise it would have been set above.
-     */
-    needed_size = BLOCK_SIZE;
+  if (needed_size > BLOCK_SIZE / 2) {
+    return NULL;
   }
+  bit_c = cache_size_bit(needed_size);
   
-  /* get some space for our memory */
-  slot_p = get_memory(needed_size);
-  if (slot_p == NULL) {
-    /* errno set in get_slot */
-    return MALLOC_ERROR;
+  CACHE_LOCK(cache_p);
+  
+  if (cache_p->tc_free_n[bit_c] == 0
+      || cache_p->tc_pnt_n >= THREAD_CACHE_PNT_MAX) {
+    CACHE_UNLOCK(cache_p);
+    return NULL;
+  }
+  
+  /* take the chunk that was freed the longest time ago */
+  slot_p = cache_p->tc_free[bit_c][cache_p->tc_free_start[bit_c]];
+#if FREED_POINTER_DELAY
+  if (slot_p->sa_use_iter + FREED_POINTER_DELAY > _dmalloc_iter_c) {
+    CACHE_UNLOCK(cache_p);
+    return NULL;
   }
+#endif
+  cache_p->tc_free_start[bit_c] =
+    (cache_p->tc_free_start[bit_c] + 1) % THREAD_CACHE_SIZE;
+  cache_p->tc_free_n[bit_c]--;
+  
+  iter_c = ITER_INCREMENT();
+  
+  slot_p->sa_flags = ALLOC_FLAG_USER | ALLOC_FLAG_DIVIDED | ALLOC_FLAG_CACHED;
   if (fence_b) {
     BIT_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE);
   }
-  if (valloc_b) {
-    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_VALLOC);
+  if (light_b) {
+    BIT_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT);
   }
   slot_p->sa_user_size = size;
   
-  /* initialize the bblocks */
-  alloc_cur_given += slot_p->sa_total_size;
-  alloc_max_given = MAX(alloc_max_given, alloc_cur_given);
-  
   get_pnt_info(slot_p, &pnt_info);
   
   /* clear the allocation */
@@ -2437,12 +6519,12 @@ void	*_dmalloc_chunk_malloc(const char *file, const unsigned int line,
   
   slot_p->sa_file = file;
   slot_p->sa_line = line;
-  slot_p->sa_use_iter = _dmalloc_iter_c;
+  slot_p->sa_use_iter = iter_c;
 #if LOG_PNT_SEEN_COUNT
   slot_p->sa_seen_c++;
 #endif
 #if LOG_PNT_ITERATION
-  slot_p->sa_iteration = _dmalloc_iter_c;
+  slot_p->sa_iteration = iter_c;
 #endif
   if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ELAPSED_TIME)
       || BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_CURRENT_TIME)) {
@@ -2459,60 +6541,57 @@ void	*_dmalloc_chunk_malloc(const char *file, const unsigned int line,
   slot_p->sa_thread_id = THREAD_GET_ID();
 #endif
   
-  /* do we need to print transaction info? */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
-    switch (func_id) {
-    case DMALLOC_FUNC_CALLOC:
-      trans_log = "calloc";
-      break;
-    case DMALLOC_FUNC_MEMALIGN:
-      trans_log = "memalign";
-      break;
-    case DMALLOC_FUNC_VALLOC:
-      trans_log = "valloc";
-      break;
-    default:
-      trans_log = "alloc";
-      break;
-    }
-    dmalloc_message("*** %s: at '%s' for %ld bytes, got '%s'",
-		    trans_log,
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					    file, line),
-		    size, display_pnt(pnt_info.pi_user_start, slot_p, disp_buf,
-				      sizeof(disp_buf)));
-  }
+  cache_insert_pnt(cache_p, slot_p);
   
-#if MEMORY_TABLE_TOP_LOG
-  _dmalloc_table_insert(&mem_table_alloc, file, line, size);
-#endif
+  /* counts calls to malloc */
+  if (func_id == DMALLOC_FUNC_CALLOC) {
+    cache_p->tc_calloc_c++;
+  }
+  else if (func_id == DMALLOC_FUNC_NEW) {
+    cache_p->tc_new_c++;
+  }
+  else {
+    cache_p->tc_malloc_c++;
+  }
   
   /* monitor current allocation level */
-  alloc_current += size;
-  alloc_maximum = MAX(alloc_maximum, alloc_current);
-  _dmalloc_alloc_total += size;
-  alloc_one_max = MAX(alloc_one_max, size);
+  cache_p->tc_alloc_current += size;
+  cache_p->tc_alloc_peak = MAX(cache_p->tc_alloc_peak,
+			       cache_p->tc_alloc_current);
+  cache_p->tc_cur_given += slot_p->sa_total_size;
+  cache_p->tc_given_peak = MAX(cache_p->tc_given_peak,
+			       cache_p->tc_cur_given);
+  cache_p->tc_alloc_total += size;
+  cache_p->tc_one_max = MAX(cache_p->tc_one_max, size);
   
   /* monitor pointer usage */
-  alloc_cur_pnts++;
-  alloc_max_pnts = MAX(alloc_max_pnts, alloc_cur_pnts);
-  alloc_tot_pnts++;
+  cache_p->tc_cur_pnts++;
+  cache_p->tc_pnts_peak = MAX(cache_p->tc_pnts_peak, cache_p->tc_cur_pnts);
+  cache_p->tc_tot_pnts++;
+  
+  CACHE_UNLOCK(cache_p);
   
   return pnt_info.pi_user_start;
 }
 
 /*
- * int _dmalloc_chunk_free
+ * int _dmalloc_chunk_cache_free
  *
  * DESCRIPTION:
  *
- * Free a user pointer from the heap.
+ * Free a user pointer that was handed out of a thread cache back
+ * into the cache without the library lock.  Pointers freed by another
+ * thread go back into the cache of the thread that allocated them so
+ * their counts stay with that cache.  The pointer is checked the same
+ * as in _dmalloc_chunk_free.
  *
  * RETURNS:
  *
- * Success - FREE_NOERROR
+ * Success - 1
  *
- * Failure - FREE_ERROR
+ * Failure - 0 if the pointer needs to be freed by
+ * _dmalloc_chunk_free.  Any problems with the pointer are reported
+ * from there.
  *
  * ARGUMENTS:
  *
@@ -2524,369 +6603,299 @@ void	*_dmalloc_chunk_malloc(const char *file, const unsigned int line,
  *
  * func_id -> Function ID
  */
-int	_dmalloc_chunk_free(const char *file, const unsigned int line,
-			    void *user_pnt, const int func_id)
+int	_dmalloc_chunk_cache_free(const char *file, const unsigned int line,
+				  void *user_pnt, const int func_id)
 {
-  char		where_buf[MAX_FILE_LENGTH + 64];
-  char		where_buf2[MAX_FILE_LENGTH + 64], disp_buf[64];
-  skip_alloc_t	*slot_p, *update_p;
-  
-  /* counts calls to free */
-  if (func_id == DMALLOC_FUNC_DELETE) {
-    func_delete_c++;
-  }
-  else if (func_id == DMALLOC_FUNC_REALLOC
-	   || func_id == DMALLOC_FUNC_RECALLOC) {
-    /* ignore these because they will alredy be accounted for in realloc */
+  thread_cache_t	*cache_p;
+  skip_alloc_t		*slot_p;
+  int			pnt_c, bit_c, free_c;
+  
+  /* the quarantine needs to see the frees in order */
+  if (user_pnt == NULL
+      || BIT_IS_SET(_dmalloc_flags, CACHE_BYPASS_FLAGS)
+      || QUARANTINE_SET()
+      || func_id == DMALLOC_FUNC_REALLOC || func_id == DMALLOC_FUNC_RECALLOC) {
+    return 0;
   }
-  else {
-    func_free_c++;
+  
+  if (thread_caches == NULL) {
+    return 0;
   }
   
-  if (user_pnt == NULL) {
-    
-#if ALLOW_FREE_NULL_MESSAGE
-    /* does the user want a specific message? */
-    dmalloc_message("WARNING: tried to free(0) from '%s'",
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					    file, line));
-#endif
-    
-    /*
-     * NOTE: we have here both a default in the settings.h file and a
-     * runtime token in case people want to turn it on or off at
-     * runtime.
-     */
-    if (BIT_IS_SET(_dmalloc_flags, DEBUG_ERROR_FREE_NULL)) {
-      dmalloc_errno = ERROR_IS_NULL;
-      log_error_info(file, line, user_pnt, NULL, "invalid 0L pointer", "free");
-      return FREE_ERROR;
+  pnt_c = -1;
+  cache_p = cache_current();
+  if (cache_p != NULL) {
+    CACHE_LOCK(cache_p);
+    pnt_c = cache_find_pnt(cache_p, user_pnt);
+    if (pnt_c < 0) {
+      CACHE_UNLOCK(cache_p);
     }
-    
-#if ALLOW_FREE_NULL == 0
-    dmalloc_errno = ERROR_IS_NULL;
-#endif
-    return FREE_ERROR;
   }
-  
-  update_p = skip_update;
-  
-  /* try to find the address with loose match */
-  slot_p = find_address(user_pnt, 0 /* used list */, 0 /* not exact pointer */,
-			skip_update);
-  if (slot_p == NULL) {
-#if FREED_POINTER_DELAY
-    skip_alloc_t	*del_p;
-    
-    /* search the delay list */
-    for (del_p = free_wait_list_head;
-	 del_p != NULL;
-	 del_p = del_p->sa_next_p[0]) {
-      if (del_p->sa_mem <= user_pnt
-	  && (char *)del_p->sa_mem + del_p->sa_total_size > (char *)user_pnt) {
-	pnt_info_t	info;
-	get_pnt_info(del_p, &info);
-	if (info.pi_user_start == user_pnt) {
-	  dmalloc_errno = ERROR_ALREADY_FREE;
-	}
-	else {
-	  dmalloc_errno = ERROR_NOT_FOUND;
-	}
-	break;
-      }
+  if (pnt_c < 0) {
+    /* only search the other caches if one of them may have handed it out */
+    if (cache_handed[CACHE_HANDED_HASH(user_pnt)] == 0) {
+      return 0;
     }
-    if (del_p == NULL) {
-#endif
-      /* not in the used list so check the free list */
-      if (find_address(user_pnt, 1 /* free list */, 0 /* not exact pointer */,
-		       skip_update) == NULL) {
-	dmalloc_errno = ERROR_NOT_FOUND;
-      }
-      else {
-	dmalloc_errno = ERROR_ALREADY_FREE;
-      }
-#if FREED_POINTER_DELAY
+    /* see if another thread handed it out */
+    cache_p = cache_owner(user_pnt, cache_p, &pnt_c);
+    if (cache_p == NULL) {
+      return 0;
     }
-#endif
-    log_error_info(file, line, user_pnt, NULL, "finding address in heap",
-		   "free");
-    return FREE_ERROR;
   }
+  slot_p = cache_p->tc_pnts[pnt_c];
   
-  if (! check_used_slot(slot_p, user_pnt, 1 /* exact pnt */, 0 /* no strlen */,
-			0 /* no min-size */)) {
-    /* error set in check slot */
-    log_error_info(file, line, user_pnt, slot_p, "checking pointer admin",
-		   "free");
-    return FREE_ERROR;
+  bit_c = cache_size_bit(slot_p->sa_total_size);
+  if (cache_p->tc_free_n[bit_c] >= THREAD_CACHE_SIZE
+      || (! check_used_slot(slot_p, user_pnt, 1 /* exact pnt */,
+			    0 /* no strlen */, 0 /* no min-size */,
+			    1 /* check blank */))) {
+    CACHE_UNLOCK(cache_p);
+    return 0;
   }
   
-  if (! remove_slot(slot_p, update_p)) {
-    /* error set and dumped in remove_slot */
-    return FREE_ERROR;
-  }
-  if (BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FENCE)) {
-    /*
-     * We need to preserve the fence-post flag because we may need to
-     * properly check for previously freed pointers in the future.
-     */
-    slot_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_FENCE;
-  }
-  else {
-    slot_p->sa_flags = ALLOC_FLAG_FREE;
-  }
+  cache_remove_pnt(cache_p, pnt_c);
   
-  alloc_cur_pnts--;
+  /* preserve the fence-post and sampling flags like _dmalloc_chunk_free */
+  slot_p->sa_flags &= ALLOC_FLAG_FENCE | ALLOC_FLAG_LIGHT;
+  BIT_SET(slot_p->sa_flags,
+	  ALLOC_FLAG_FREE | ALLOC_FLAG_DIVIDED | ALLOC_FLAG_CACHED);
   
-  slot_p->sa_use_iter = _dmalloc_iter_c;
+  slot_p->sa_use_iter = ITER_INCREMENT();
 #if LOG_PNT_SEEN_COUNT
   slot_p->sa_seen_c++;
 #endif
-  
-  /* do we need to print transaction info? */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
-    dmalloc_message("*** free: at '%s' pnt '%s': size %u, alloced at '%s'",
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf), file,
-					    line),
-		    display_pnt(user_pnt, slot_p, disp_buf, sizeof(disp_buf)),
-		    slot_p->sa_user_size,
-		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
-					    slot_p->sa_file, slot_p->sa_line));
-  }
-  
-#if MEMORY_TABLE_TOP_LOG
-  _dmalloc_table_delete(&mem_table_alloc, slot_p->sa_file, slot_p->sa_line,
-			slot_p->sa_user_size);
-#endif
-  
-  /* update the file/line -- must be after _dmalloc_table_delete */
   slot_p->sa_file = file;
   slot_p->sa_line = line;
   
+  /* counts calls to free */
+  if (func_id == DMALLOC_FUNC_DELETE) {
+    cache_p->tc_delete_c++;
+  }
+  else {
+    cache_p->tc_free_c++;
+  }
+  
   /* monitor current allocation level */
-  alloc_current -= slot_p->sa_user_size;
-  alloc_cur_given -= slot_p->sa_total_size;
-  free_space_bytes += slot_p->sa_total_size;
+  cache_p->tc_alloc_current -= slot_p->sa_user_size;
+  cache_p->tc_cur_given -= slot_p->sa_total_size;
+  cache_p->tc_cur_pnts--;
   
   /* clear the memory */
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_FREE_BLANK)
-      || BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK)) {
+  if ((BIT_IS_SET(_dmalloc_flags, DEBUG_FREE_BLANK)
+       || BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK))
+      && (! BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_LIGHT))) {
     memset(slot_p->sa_mem, FREE_BLANK_CHAR, slot_p->sa_total_size);
-    /* set our slot blank flag */
     BIT_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
   }
   
-  /*
-   * The question is should we combine multiple free chunks together
-   * into one.  This would help we with fragmentation but it would
-   * screwup the seen counter.
-   *
-   * Check above and below the free bblock looking for neighbors that
-   * are free so we can add them together and put them in a different
-   * free slot.
-   *
-   * NOTE: all of these block's reuse-iter count will be moved ahead
-   * because we are encorporating in this newly freed block.
-   */
+  /* put it on the end of the ring */
+  free_c = (cache_p->tc_free_start[bit_c] + cache_p->tc_free_n[bit_c]) %
+    THREAD_CACHE_SIZE;
+  cache_p->tc_free[bit_c][free_c] = slot_p;
+  cache_p->tc_free_n[bit_c]++;
   
-  if (! BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)) {
-#if FREED_POINTER_DELAY
-    slot_p->sa_next_p[0] = NULL;
-    if (free_wait_list_head == NULL) {
-      free_wait_list_head = slot_p;
+  CACHE_UNLOCK(cache_p);
+  
+  return 1;
+}
+
+/*
+ * void _dmalloc_chunk_cache_fill
+ *
+ * DESCRIPTION:
+ *
+ * Make sure that the current thread has a cache with chunks for an
+ * allocation of a certain size.  This should be called with the
+ * library lock held when _dmalloc_chunk_cache_malloc fails.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes that were requested.
+ *
+ * destroy_func -> Function that the threads library calls with the
+ * thread's cache when the thread exits.
+ */
+void	_dmalloc_chunk_cache_fill(const unsigned long size,
+				  void (*destroy_func)(void *))
+{
+  thread_cache_t	*cache_p;
+  skip_alloc_t		*slot_p;
+  unsigned long		needed_size;
+  unsigned int		pnt_c, free_c;
+  int			bit_c, fill_c;
+  
+  if (BIT_IS_SET(_dmalloc_flags, CACHE_BYPASS_FLAGS)) {
+    return;
+  }
+  
+  needed_size = size;
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_FENCE)) {
+    needed_size += FENCE_OVERHEAD_SIZE;
+  }
+  if (needed_size > BLOCK_SIZE / 2) {
+    return;
+  }
+  
+  if (! cache_key_b) {
+    if (pthread_key_create(&cache_key, destroy_func) != 0) {
+      return;
     }
-    else {
-      free_wait_list_tail->sa_next_p[0] = slot_p;
+    cache_key_b = 1;
+  }
+  
+  cache_p = cache_current();
+  if (cache_p == NULL) {
+    cache_p = cache_create();
+    if (cache_p == NULL) {
+      return;
+    }
+  }
+  bit_c = cache_size_bit(needed_size);
+  
+  CACHE_LOCK(cache_p);
+  
+  /* if the thread is holding on to too many pointers, take them back */
+  if (cache_p->tc_pnt_n >= THREAD_CACHE_PNT_MAX) {
+    for (pnt_c = 0; pnt_c < THREAD_CACHE_PNTS; pnt_c++) {
+      slot_p = cache_p->tc_pnts[pnt_c];
+      if (slot_p != NULL) {
+	cache_drop_pnt(cache_p, pnt_c);
+	cache_adopt(cache_p, slot_p);
+      }
+    }
+    cache_p->tc_pnt_n = 0;
+  }
+  
+  /*
+   * Add chunks to the ring if it is empty or if its oldest chunk is
+   * still waiting out the FREED_POINTER_DELAY.
+   */
+  if (cache_p->tc_free_n[bit_c] > 0) {
+#if FREED_POINTER_DELAY
+    slot_p = cache_p->tc_free[bit_c][cache_p->tc_free_start[bit_c]];
+    if (slot_p->sa_use_iter + FREED_POINTER_DELAY <= _dmalloc_iter_c) {
+      CACHE_UNLOCK(cache_p);
+      return;
     }
-    free_wait_list_tail = slot_p;
 #else
-    /* put slot on free list */
-    if (! insert_slot(slot_p, 1 /* free list */)) {
-      /* error dumped in insert_slot */
-      return FREE_ERROR;
-    }
+    CACHE_UNLOCK(cache_p);
+    return;
 #endif
   }
   
-  return FREE_NOERROR;
+  for (fill_c = 0;
+       fill_c < (THREAD_CACHE_SIZE + 1) / 2
+	 && cache_p->tc_free_n[bit_c] < THREAD_CACHE_SIZE;
+       fill_c++) {
+    slot_p = get_divided_memory(bit_sizes[bit_c]);
+    if (slot_p == NULL) {
+      /* error code set in get_divided_memory */
+      break;
+    }
+    
+    /* the chunk is still free space but it belongs to the cache now */
+    slot_p->sa_flags = ALLOC_FLAG_FREE | ALLOC_FLAG_DIVIDED | ALLOC_FLAG_CACHED;
+    free_space_bytes += slot_p->sa_total_size;
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_FREE_BLANK)
+	|| BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_BLANK)) {
+      memset(slot_p->sa_mem, FREE_BLANK_CHAR, slot_p->sa_total_size);
+      BIT_SET(slot_p->sa_flags, ALLOC_FLAG_BLANK);
+    }
+    
+    free_c = (cache_p->tc_free_start[bit_c] + cache_p->tc_free_n[bit_c]) %
+      THREAD_CACHE_SIZE;
+    cache_p->tc_free[bit_c][free_c] = slot_p;
+    cache_p->tc_free_n[bit_c]++;
+  }
+  
+  CACHE_UNLOCK(cache_p);
 }
 
 /*
- * void *_dmalloc_chunk_realloc
+ * void _dmalloc_chunk_cache_spill
  *
  * DESCRIPTION:
  *
- * Re-allocate a chunk of memory either shrinking or expanding it.
+ * Give the older half of the freed chunks in the current thread's
+ * full cache rings back to the library so that it can cache more of
+ * its frees.  This should be called with the library lock held when
+ * _dmalloc_chunk_cache_free fails.
  *
  * RETURNS:
  *
- * Success - Valid pointer.
- *
- * Failure - NULL
+ * None.
  *
  * ARGUMENTS:
  *
- * file -> File-name or return-address location of the allocation.
- *
- * line -> Line-number location of the allocation.
- *
- * old_user_pnt -> Old user pointer that we are reallocating.
- *
- * new_size -> New-size to change the pointer.
- *
- * func_id -> Calling function-id as defined in dmalloc.h.
+ * None.
  */
-void	*_dmalloc_chunk_realloc(const char *file, const unsigned int line,
-				void *old_user_pnt,
-				const unsigned long new_size,
-				const int func_id)
+void	_dmalloc_chunk_cache_spill(void)
 {
-  const char	*old_file;
-  skip_alloc_t	*slot_p;
-  pnt_info_t	pnt_info;
-  void		*new_user_pnt;
-  unsigned int	old_size, old_line;
-  
-  /* counts calls to realloc */
-  if (func_id == DMALLOC_FUNC_RECALLOC) {
-    func_recalloc_c++;
-  }
-  else {
-    func_realloc_c++;
-  }
-  
-#if ALLOW_ALLOC_ZERO_SIZE == 0
-  if (new_size == 0) {
-    dmalloc_errno = ERROR_BAD_SIZE;
-    log_error_info(file, line, NULL, NULL, "bad zero byte allocation request",
-		   "realloc");
-    return REALLOC_ERROR;
-  }
-#endif
-  
-  /* by now malloc.c should have taken care of the realloc(NULL) case */
-  if (old_user_pnt == NULL) {
-    dmalloc_errno = ERROR_IS_NULL;
-    log_error_info(file, line, old_user_pnt, NULL, "invalid pointer",
-		   "realloc");
-    return REALLOC_ERROR;
-  }
+  thread_cache_t	*cache_p;
+  skip_alloc_t		*slot_p;
+  int			bit_c, spill_c;
   
-  /* find the old pointer with loose checking for fence post stuff */
-  slot_p = find_address(old_user_pnt, 0 /* used list */,
-			0 /* not exact pointer */, skip_update);
-  if (slot_p == NULL) {
-    dmalloc_errno = ERROR_NOT_FOUND;
-    log_error_info(file, line, old_user_pnt, NULL, "finding address in heap",
-		   "realloc");
-    return 0;
+  cache_p = cache_current();
+  if (cache_p == NULL) {
+    return;
   }
   
-  /* get info about the pointer */
-  get_pnt_info(slot_p, &pnt_info);
-  old_file = slot_p->sa_file;
-  old_line = slot_p->sa_line;
-  old_size = slot_p->sa_user_size;
+  CACHE_LOCK(cache_p);
   
-  /* if we are not realloc copying and the size is the same */
-  if ((char *)pnt_info.pi_user_start + new_size >
-      (char *)pnt_info.pi_upper_bounds
-      || BIT_IS_SET(_dmalloc_flags, DEBUG_REALLOC_COPY)
-      || BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)) {
-    int	min_size;
-    
-    /* allocate space for new chunk */
-    new_user_pnt = _dmalloc_chunk_malloc(file, line, new_size, func_id,
-				    0 /* no align */);
-    if (new_user_pnt == MALLOC_ERROR) {
-      return REALLOC_ERROR;
-    }
-    
-    /*
-     * NOTE: _chunk_malloc() already took care of the fence stuff and
-     * zeroing of memory.
-     */
-    
-    /* copy stuff into new section of memory */
-    min_size = MIN(new_size, old_size);
-    if (min_size > 0) {
-      memcpy(new_user_pnt, pnt_info.pi_user_start, min_size);
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    if (cache_p->tc_free_n[bit_c] < THREAD_CACHE_SIZE) {
+      continue;
     }
-    
-    /* free old pointer */
-    if (_dmalloc_chunk_free(file, line, old_user_pnt,
-			    func_id) != FREE_NOERROR) {
-      return REALLOC_ERROR;
+    for (spill_c = 0; spill_c < (THREAD_CACHE_SIZE + 1) / 2; spill_c++) {
+      slot_p = cache_p->tc_free[bit_c][cache_p->tc_free_start[bit_c]];
+      cache_p->tc_free_start[bit_c] =
+	(cache_p->tc_free_start[bit_c] + 1) % THREAD_CACHE_SIZE;
+      cache_p->tc_free_n[bit_c]--;
+      
+      BIT_CLEAR(slot_p->sa_flags, ALLOC_FLAG_CACHED);
+      if (! BIT_IS_SET(_dmalloc_flags, DEBUG_NEVER_REUSE)) {
+	/* error dumped in wait_slot */
+	(void)wait_slot(slot_p);
+      }
     }
   }
-  else {
-    /* new pointer is the same as the old one */
-    new_user_pnt = pnt_info.pi_user_start;
-    
-    /*
-     * monitor current allocation level
-     *
-     * NOTE: we do this here since the malloc/free used above take care
-     * on if in that section
-     */
-    alloc_current += new_size - old_size;
-    alloc_maximum = MAX(alloc_maximum, alloc_current);
-    _dmalloc_alloc_total += new_size;
-    alloc_one_max = MAX(alloc_one_max, new_size);
-    
-    /* monitor pointer usage */
-    alloc_tot_pnts++;
-    
-    /* change the slot information */
-    slot_p->sa_user_size = new_size;
-    get_pnt_info(slot_p, &pnt_info);
-    
-    clear_alloc(slot_p, &pnt_info, old_size, func_id);
-    
-    slot_p->sa_use_iter = _dmalloc_iter_c;
-#if LOG_PNT_SEEN_COUNT
-    /* we see in inbound and outbound so we need to increment by 2 */
-    slot_p->sa_seen_c += 2;
-#endif
-    
-#if MEMORY_TABLE_TOP_LOG
-    _dmalloc_table_delete(&mem_table_alloc, slot_p->sa_file, slot_p->sa_line,
-			  old_size);
-    _dmalloc_table_insert(&mem_table_alloc, file, line, new_size);
-#endif
-  
-    /*
-     * finally, we update the file/line info -- must be after
-     * _dmalloc_table functions
-     */
-    slot_p->sa_file = file;
-    slot_p->sa_line = line;
-  }
   
-  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_TRANS)) {
-    const char	*trans_log;
-    char	where_buf[MAX_FILE_LENGTH + 64];
-    char	where_buf2[MAX_FILE_LENGTH + 64];
-    
-    if (func_id == DMALLOC_FUNC_RECALLOC) {
-      trans_log = "recalloc";
-    }
-    else {
-      trans_log = "realloc";
-    }
-    dmalloc_message("*** %s: at '%s' from '%#lx' (%u bytes) file '%s' to '%#lx' (%lu bytes)",
-		    trans_log,
-		    _dmalloc_chunk_desc_pnt(where_buf, sizeof(where_buf),
-					    file, line),
-		    (unsigned long)old_user_pnt, old_size,
-		    _dmalloc_chunk_desc_pnt(where_buf2, sizeof(where_buf2),
-					    old_file, old_line),
-		    (unsigned long)new_user_pnt, new_size);
-  }
+  CACHE_UNLOCK(cache_p);
+}
+
+/*
+ * void _dmalloc_chunk_cache_release
+ *
+ * DESCRIPTION:
+ *
+ * Give a thread's cache back to the library when the thread exits.
+ * This should be called with the library lock held.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Pointer to the thread's cache.
+ */
+void	_dmalloc_chunk_cache_release(void *cache_p)
+{
+  thread_cache_t	*tc_p = (thread_cache_t *)cache_p;
   
-  return new_user_pnt;
+  CACHE_LOCK(tc_p);
+  /* error dumped in cache_flush */
+  (void)cache_flush(tc_p);
+  tc_p->tc_used_b = 0;
+  CACHE_UNLOCK(tc_p);
 }
 
+#endif /* LOCK_THREADS && THREAD_CACHE_SIZE > 0 */
+
 /***************************** diagnostic routines ***************************/
 
 /*
@@ -2906,7 +6915,13 @@ void	*_dmalloc_chunk_realloc(const char *file, const unsigned int line,
  */
 void	_dmalloc_chunk_log_stats(void)
 {
-  unsigned long	overhead, user_space, tot_space;
+  unsigned long	overhead, user_space, tot_space, chunk_c, used_c;
+  slab_block_t	*slab_p;
+  int		bit_c;
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  (void)cache_flush_all();
+#endif
   
   dmalloc_message("Dumping Chunk Statistics:");
   
@@ -2932,8 +6947,34 @@ void	_dmalloc_chunk_log_stats(void)
 		  (tot_space < 100 ? 0 : overhead / (tot_space / 100)));
   dmalloc_message("   total blocks: %ld blocks, %ld bytes",
 		  user_block_c + admin_block_c, tot_space);
+  dmalloc_message("heap reserved: %lu bytes, committed %lu bytes (%lu%%)",
+		  _dmalloc_heap_reserved, _dmalloc_heap_committed,
+		  (_dmalloc_heap_reserved < 100 ? 0 :
+		   _dmalloc_heap_committed / (_dmalloc_heap_reserved / 100)));
+  
+  /* divided-blocks of each of the sizes */
+  for (bit_c = 0; bit_c < BASIC_BLOCK; bit_c++) {
+    if (slab_block_c[bit_c] == 0 && slab_reclaim_c[bit_c] == 0) {
+      continue;
+    }
+    chunk_c = 0;
+    used_c = 0;
+    for (slab_p = slab_blocks[bit_c];
+	 slab_p != NULL;
+	 slab_p = slab_p->sb_next_p) {
+      chunk_c += slab_p->sb_chunk_n;
+      used_c += slab_p->sb_chunk_n - slab_p->sb_avail_n;
+    }
+    dmalloc_message("divided %d byte chunks: %lu blocks, %lu of %lu chunks used, %lu blocks reclaimed",
+		    bit_sizes[bit_c], slab_block_c[bit_c], used_c, chunk_c,
+		    slab_reclaim_c[bit_c]);
+  }
   
   dmalloc_message("heap checked %ld", heap_check_c);
+  if (_dmalloc_sample_rate > 1) {
+    dmalloc_message("sampling: fully checking 1 in %lu allocations",
+		    _dmalloc_sample_rate);
+  }
   
   /* log user allocation information */
   dmalloc_message("alloc calls: malloc %lu, calloc %lu, realloc %lu, free %lu",
@@ -2957,11 +6998,17 @@ void	_dmalloc_chunk_log_stats(void)
 		  (alloc_max_given == 0 ? 0 :
 		   ((alloc_max_given - alloc_maximum) * 100) /
 		   alloc_max_given));
+  dmalloc_message("free memory released to the system: %lu bytes",
+		  free_release_bytes);
+  dmalloc_message("free memory waiting to be reused: %lu bytes (%lu pnts), %lu bytes no-access",
+		  free_wait_bytes, free_wait_pnts, free_protect_bytes);
   
 #if MEMORY_TABLE_TOP_LOG
   dmalloc_message("top %d allocations:", MEMORY_TABLE_TOP_LOG);
+  /* the table only holds the sampled allocations */
   _dmalloc_table_log_info(&mem_table_alloc, MEMORY_TABLE_TOP_LOG,
-			  1 /* have in-use column */);
+			  1 /* have in-use column */,
+			  (_dmalloc_sample_rate > 1 ? _dmalloc_sample_rate : 1));
 #endif
 }
 
@@ -2998,8 +7045,9 @@ void	_dmalloc_chunk_log_changed(const unsigned long mark,
   int		known_b, freed_b, used_b;
   char		out[DUMP_SPACE * 4], *which_str;
   char		where_buf[MAX_FILE_LENGTH + 64], disp_buf[64];
-  int		unknown_size_c = 0, unknown_block_c = 0, out_len;
-  int		size_c = 0, block_c = 0, checking_list_c = 0;
+  int		unknown_size_c = 0, unknown_block_c = 0, out_len, dump_size;
+  int		size_c = 0, block_c = 0;
+  heap_walk_t	walk;
   
   if (log_not_freed_b && log_freed_b) {
     which_str = "Not-Freed and Freed";
@@ -3014,6 +7062,10 @@ void	_dmalloc_chunk_log_changed(const unsigned long mark,
     return;
   }
   
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  (void)cache_flush_all();
+#endif
+  
   if (mark == 0) {
     dmalloc_message("Dumping %s Pointers Changed Since Start:", which_str);
   }
@@ -3023,36 +7075,15 @@ void	_dmalloc_chunk_log_changed(const unsigned long mark,
   }
   
   /* clear out our memory table so we can fill it with pointer info */
-  _dmalloc_table_init(&mem_table_changed, mem_table_changed_entries,
-		      sizeof(mem_table_changed_entries) /
-		      sizeof(*mem_table_changed_entries));
+  _dmalloc_table_clear(&mem_table_changed);
   
   /* run through the blocks */
-  for (slot_p = skip_address_list->sa_next_p[0];
-       ;
-       slot_p = slot_p->sa_next_p[0]) {
+  memset(&walk, 0, sizeof(walk));
+  while (1) {
     
-    /*
-     * switch to the free list in the middle after we've checked the
-     * used pointer slots
-     */
+    slot_p = heap_walk_next(&walk);
     if (slot_p == NULL) {
-      checking_list_c++;
-      if (checking_list_c == 1) {
-	slot_p = skip_free_list->sa_next_p[0];
-      }
-#if FREED_POINTER_DELAY
-      else if (checking_list_c == 2) {
-	slot_p = free_wait_list_head;
-      }
-#endif
-      else {
-	/* we are done */
-	break;
-      }
-      if (slot_p == NULL) {
-	break;
-      }
+      break;
     }
     
     freed_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FREE);
@@ -3100,7 +7131,13 @@ void	_dmalloc_chunk_log_changed(const unsigned long mark,
 	
 	if ((! freed_b)
 	    && BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_NONFREE_SPACE)) {
-	  out_len = expand_chars((char *)pnt_info.pi_user_start, DUMP_SPACE,
+	  dump_size = DUMP_SPACE;
+	  /* stop short of the guard page of a guarded allocation */
+	  if (pnt_info.pi_guard_b) {
+	    dump_size = MIN((char *)pnt_info.pi_alloc_bounds -
+			    (char *)pnt_info.pi_user_start, DUMP_SPACE);
+	  }
+	  out_len = expand_chars((char *)pnt_info.pi_user_start, dump_size,
 				 out, sizeof(out));
 	  dmalloc_message("  dump of '%#lx': '%.*s'",
 			  (unsigned long)pnt_info.pi_user_start, out_len, out);
@@ -3113,7 +7150,7 @@ void	_dmalloc_chunk_log_changed(const unsigned long mark,
   
   /* dump the summary from the table table */
   _dmalloc_table_log_info(&mem_table_changed, 0 /* log all entries */,
-			  0 /* no in-use column */);
+			  0 /* no in-use column */, 1 /* not sampled */);
   
   /* copy out size of pointers */
   if (block_c > 0) {
@@ -3158,35 +7195,20 @@ unsigned long	_dmalloc_chunk_count_changed(const unsigned long mark,
 {
   skip_alloc_t	*slot_p;
   int		freed_b, used_b;
-  int		checking_list_c = 0;
+  heap_walk_t	walk;
   unsigned int	mem_count = 0;
   
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  (void)cache_flush_all();
+#endif
+  
   /* run through the blocks */
-  for (slot_p = skip_address_list->sa_next_p[0];
-       ;
-       slot_p = slot_p->sa_next_p[0]) {
+  memset(&walk, 0, sizeof(walk));
+  while (1) {
     
-    /*
-     * switch to the free list in the middle after we've checked the
-     * used pointer slots
-     */
+    slot_p = heap_walk_next(&walk);
     if (slot_p == NULL) {
-      checking_list_c++;
-      if (checking_list_c == 1) {
-	slot_p = skip_free_list->sa_next_p[0];
-      }
-#if FREED_POINTER_DELAY
-      else if (checking_list_c == 2) {
-	slot_p = free_wait_list_head;
-      }
-#endif
-      else {
-	/* we are done */
-	break;
-      }
-      if (slot_p == NULL) {
-	break;
-      }
+      break;
     }
     
     freed_b = BIT_IS_SET(slot_p->sa_flags, ALLOC_FLAG_FREE);
@@ -3220,7 +7242,9 @@ unsigned long	_dmalloc_chunk_count_changed(const unsigned long mark,
  *
  * DESCRIPTION:
  *
- * Return a number of statistics about the current heap.
+ * Return a number of statistics about the current heap.  This does
+ * not need the library lock so it may be called while other threads
+ * are allocating.
  *
  * RETURNS:
  *
@@ -3269,13 +7293,55 @@ void	_dmalloc_chunk_get_stats(void **heap_low_p, void **heap_high_p,
 				 unsigned long *max_pnt_np,
 				 unsigned long *max_one_p)
 {
+  unsigned long	current, cur_pnts, free_space, one_max;
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  unsigned long	total;
+  
+  /* add in what the caches have not flushed without stopping them */
+  cache_stats(&current, &cur_pnts, &free_space, &one_max, &total);
+#else
+  current = alloc_current;
+  cur_pnts = alloc_cur_pnts;
+  free_space = free_space_bytes;
+  one_max = alloc_one_max;
+#endif
+  
   SET_POINTER(heap_low_p, _dmalloc_heap_low);
   SET_POINTER(heap_high_p, _dmalloc_heap_high);
   SET_POINTER(total_space_p, (user_block_c + admin_block_c) * BLOCK_SIZE);
-  SET_POINTER(user_space_p, alloc_current + free_space_bytes);
-  SET_POINTER(current_allocated_p, alloc_current);
-  SET_POINTER(current_pnt_np, alloc_cur_pnts);
-  SET_POINTER(max_allocated_p, alloc_maximum);
-  SET_POINTER(max_pnt_np, alloc_max_pnts);
-  SET_POINTER(max_one_p, alloc_one_max);
+  SET_POINTER(user_space_p, current + free_space);
+  SET_POINTER(current_allocated_p, current);
+  SET_POINTER(current_pnt_np, cur_pnts);
+  /* the caches' peaks are only added in when they are flushed */
+  SET_POINTER(max_allocated_p, MAX(alloc_maximum, current));
+  SET_POINTER(max_pnt_np, MAX(alloc_max_pnts, cur_pnts));
+  SET_POINTER(max_one_p, one_max);
+}
+
+/*
+ * unsigned long _dmalloc_chunk_memory_allocated
+ *
+ * DESCRIPTION:
+ *
+ * Return the total number of bytes allocated by the program so far
+ * including what the thread caches have handed out.
+ *
+ * RETURNS:
+ *
+ * Total number of bytes allocated by the program so far.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+unsigned long	_dmalloc_chunk_memory_allocated(void)
+{
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  unsigned long	current, cur_pnts, free_space, one_max, total;
+  
+  cache_stats(&current, &cur_pnts, &free_space, &one_max, &total);
+  return total;
+#else
+  return _dmalloc_alloc_total;
+#endif
 }
@@ -28,6 +28,36 @@
 extern
 unsigned long		_dmalloc_memory_limit;
 
+/* fully check only 1 in this many allocations, 0 or 1 to check all */
+extern
+unsigned long		_dmalloc_sample_rate;
+
+/* bytes and pointers of freed memory to hold on to before reusing it */
+extern
+unsigned long		_dmalloc_quarantine_size;
+extern
+unsigned long		_dmalloc_quarantine_count;
+
+/* check only this many blocks of the heap per transaction, 0 for all */
+extern
+unsigned long		_dmalloc_check_budget;
+
+/* split the full heap check between this many threads */
+extern
+unsigned long		_dmalloc_check_threads;
+
+/* put a guard page after allocations from this file and line */
+extern
+char			*_dmalloc_guard_file;
+extern
+int			_dmalloc_guard_line;
+
+/* put a guard page after allocations of this range of sizes */
+extern
+unsigned long		_dmalloc_guard_min;
+extern
+unsigned long		_dmalloc_guard_max;
+
 /* total number of bytes that the heap has allocated */
 extern
 unsigned long		_dmalloc_alloc_total;
@@ -52,6 +82,26 @@ unsigned long		_dmalloc_alloc_total;
 extern
 int	_dmalloc_chunk_startup(void);
 
+/*
+ * void _dmalloc_chunk_flags_changed
+ *
+ * DESCRIPTION:
+ *
+ * Look at the debug flags after they have been changed to see if the
+ * allocation routines can take their short path which only tracks
+ * the pointers.  This should be called with the library lock held.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+extern
+void	_dmalloc_chunk_flags_changed(void);
+
 /*
  * char *_dmalloc_chunk_desc_pnt
  *
@@ -79,6 +129,30 @@ extern
 char	*_dmalloc_chunk_desc_pnt(char *buf, const int buf_size,
 				 const char *file, const unsigned int line);
 
+/*
+ * void *_dmalloc_chunk_admin_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Get zeroed administrative space straight from the heap for the
+ * library's own tables so it never comes out of the user's
+ * allocations.  It is accounted for on the used list and is never
+ * given back.
+ *
+ * RETURNS:
+ *
+ * Success - Block aligned pointer to the space.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes that we need.  It is rounded up to the
+ * block-size.
+ */
+extern
+void	*_dmalloc_chunk_admin_alloc(const unsigned int size);
+
 /*
  * int _dmalloc_chunk_read_info
  *
@@ -134,6 +208,28 @@ int	_dmalloc_chunk_read_info(const void *user_pnt, const char *where,
 				 unsigned long *used_p, int *valloc_bp,
 				 int *fence_bp);
 
+#if LOCK_THREADS
+/*
+ * void _dmalloc_chunk_check_start
+ *
+ * DESCRIPTION:
+ *
+ * Start the threads that help with the heap check if the
+ * check-threads setting asks for more of them.  This must be called
+ * without the library lock.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+extern
+void	_dmalloc_chunk_check_start(void);
+#endif /* LOCK_THREADS */
+
 /*
  * int _dmalloc_chunk_heap_check
  *
@@ -154,6 +250,31 @@ int	_dmalloc_chunk_read_info(const void *user_pnt, const char *where,
 extern
 int	_dmalloc_chunk_heap_check(void);
 
+/*
+ * int _dmalloc_chunk_heap_step
+ *
+ * DESCRIPTION:
+ *
+ * Run the tests of _dmalloc_chunk_heap_check on the next part of the
+ * heap, picking up where the last call left off, so that the work of
+ * each call is limited by the check-budget setting.  Each admin block
+ * and each block of memory in a slot counts as one against the
+ * budget.  When we get to the end of the heap, the next call starts
+ * over at the beginning.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the part of the heap is okay
+ *
+ * Failure - 0 if a problem was detected
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+extern
+int	_dmalloc_chunk_heap_step(void);
+
 /*
  * int _dmalloc_chunk_pnt_check
  *
@@ -276,6 +397,135 @@ void	*_dmalloc_chunk_realloc(const char *file, const unsigned int line,
 				const unsigned long new_size,
 				const int func_id);
 
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+
+/*
+ * void *_dmalloc_chunk_cache_malloc
+ *
+ * DESCRIPTION:
+ *
+ * Allocate a chunk of memory out of the current thread's cache
+ * without the library lock.  The pointer gets the same fence-posts,
+ * blanking, and file/line information as from _dmalloc_chunk_malloc.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - NULL if the allocation needs to be done by
+ * _dmalloc_chunk_malloc.
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * size -> Number of bytes to allocate.
+ *
+ * func_id -> Calling function-id as defined in dmalloc.h.
+ */
+extern
+void	*_dmalloc_chunk_cache_malloc(const char *file, const unsigned int line,
+				     const unsigned long size,
+				     const int func_id);
+
+/*
+ * int _dmalloc_chunk_cache_free
+ *
+ * DESCRIPTION:
+ *
+ * Free a user pointer that was handed out of the current thread's
+ * cache back into the cache without the library lock.  The pointer
+ * is checked the same as in _dmalloc_chunk_free.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0 if the pointer needs to be freed by
+ * _dmalloc_chunk_free.  Any problems with the pointer are reported
+ * from there.
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address location of the allocation.
+ *
+ * line -> Line-number location of the allocation.
+ *
+ * user_pnt -> Pointer we are freeing.
+ *
+ * func_id -> Function ID
+ */
+extern
+int	_dmalloc_chunk_cache_free(const char *file, const unsigned int line,
+				  void *user_pnt, const int func_id);
+
+/*
+ * void _dmalloc_chunk_cache_fill
+ *
+ * DESCRIPTION:
+ *
+ * Make sure that the current thread has a cache with chunks for an
+ * allocation of a certain size.  This should be called with the
+ * library lock held when _dmalloc_chunk_cache_malloc fails.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes that were requested.
+ *
+ * destroy_func -> Function that the threads library calls with the
+ * thread's cache when the thread exits.
+ */
+extern
+void	_dmalloc_chunk_cache_fill(const unsigned long size,
+				  void (*destroy_func)(void *));
+
+/*
+ * void _dmalloc_chunk_cache_spill
+ *
+ * DESCRIPTION:
+ *
+ * Give the older half of the freed chunks in the current thread's
+ * full cache rings back to the library so that it can cache more of
+ * its frees.  This should be called with the library lock held when
+ * _dmalloc_chunk_cache_free fails.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+extern
+void	_dmalloc_chunk_cache_spill(void);
+
+/*
+ * void _dmalloc_chunk_cache_release
+ *
+ * DESCRIPTION:
+ *
+ * Give a thread's cache back to the library when the thread exits.
+ * This should be called with the library lock held.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * cache_p -> Pointer to the thread's cache.
+ */
+extern
+void	_dmalloc_chunk_cache_release(void *cache_p);
+#endif /* LOCK_THREADS && THREAD_CACHE_SIZE > 0 */
+
 /*
  * void _dmalloc_chunk_log_stats
  *
@@ -354,7 +604,9 @@ unsigned long	_dmalloc_chunk_count_changed(const unsigned long mark,
  *
  * DESCRIPTION:
  *
- * Return a number of statistics about the current heap.
+ * Return a number of statistics about the current heap.  This does
+ * not need the library lock so it may be called while other threads
+ * are allocating.
  *
  * RETURNS:
  *
@@ -404,6 +656,25 @@ void	_dmalloc_chunk_get_stats(void **heap_low_p, void **heap_high_p,
 				 unsigned long *max_pnt_np,
 				 unsigned long *max_one_p);
 
+/*
+ * unsigned long _dmalloc_chunk_memory_allocated
+ *
+ * DESCRIPTION:
+ *
+ * Return the total number of bytes allocated by the program so far
+ * including what the thread caches have handed out.
+ *
+ * RETURNS:
+ *
+ * Total number of bytes allocated by the program so far.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+extern
+unsigned long	_dmalloc_chunk_memory_allocated(void);
+
 /*<<<<<<<<<<   This is end of the auto-generated output from fillproto. */
 
 #endif /* ! __CHUNK_H__ */
@@ -26,7 +26,7 @@
 #include "dmalloc_loc.h"			/* for DMALLOC_SIZE */
 
 /* for thread-id types -- see conf.h */
-#if LOG_THREAD_ID
+#if LOG_THREAD_ID || LOCK_THREADS
 #ifdef THREAD_INCLUDE
 #include THREAD_INCLUDE
 #endif
@@ -45,6 +45,31 @@
 # endif
 #endif
 
+/* for madvise -- see settings.h FREE_RELEASE_DELAY */
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/*
+ * Free memory that we give back to the system reads back as zeros on
+ * systems with MADV_DONTNEED and either zeros or its old contents
+ * with MADV_FREE.
+ */
+#if FREE_RELEASE_DELAY > 0 && defined(MADV_DONTNEED)
+#define FREE_RELEASE_OKAY	1
+#define FREE_RELEASE_ADVICE	MADV_DONTNEED
+#define FREE_RELEASE_ZEROS	1
+#else
+#if FREE_RELEASE_DELAY > 0 && defined(MADV_FREE)
+#define FREE_RELEASE_OKAY	1
+#define FREE_RELEASE_ADVICE	MADV_FREE
+#define FREE_RELEASE_ZEROS	0
+#else
+#define FREE_RELEASE_OKAY	0
+#define FREE_RELEASE_ZEROS	0
+#endif
+#endif
+
 /* log-bad-space info */
 #define SPECIAL_CHARS		"\"\"''\\\\n\nr\rt\tb\bf\fa\007"
 
@@ -74,6 +99,17 @@
 #define ALLOC_FLAG_BLANK	BIT_FLAG(4)	/* slot has been blanked */
 #define ALLOC_FLAG_FENCE	BIT_FLAG(5)	/* slot is fence posted */
 #define ALLOC_FLAG_VALLOC	BIT_FLAG(6)	/* slot is block aligned */
+#define ALLOC_FLAG_SLAB		BIT_FLAG(7)	/* slot covers a divided-block */
+#define ALLOC_FLAG_DIVIDED	BIT_FLAG(8)	/* slot is a divided-block chunk */
+#define ALLOC_FLAG_CACHED	BIT_FLAG(9)	/* slot is in a thread's cache */
+#define ALLOC_FLAG_RELEASED	BIT_FLAG(10)	/* free pages given to system */
+#define ALLOC_FLAG_MAPPED	BIT_FLAG(11)	/* slot has its own mapping */
+#define ALLOC_FLAG_ALIGNED	BIT_FLAG(12)	/* slot has memalign offset */
+#define ALLOC_FLAG_LIGHT	BIT_FLAG(13)	/* slot skipped by sampling */
+#define ALLOC_FLAG_GUARD	BIT_FLAG(14)	/* slot ends in a guard page */
+#define ALLOC_FLAG_PROTECTED	BIT_FLAG(15)	/* freed pages are no-access */
+#define ALLOC_FLAG_WAIT		BIT_FLAG(16)	/* slot is on the wait list */
+#define ALLOC_FLAG_ZERO		BIT_FLAG(17)	/* slot's memory is all zeros */
 
 /*
  * Below defines an allocation structure either on the free or used
@@ -83,11 +119,11 @@
  */
 typedef struct skip_alloc_st {
   
-  unsigned char		sa_flags;	/* what it is */
-  
   /* some small data types up front to save on space */
-  unsigned char		sa_level_n;	/* how tall our node is */
+  unsigned int		sa_flags:24;	/* what it is */
+  unsigned int		sa_level_n:8;	/* how tall our node is */
   unsigned short	sa_line;	/* line where it was allocated */
+  unsigned short	sa_align_off;	/* memalign offset of user pnt */
   
   unsigned int		sa_user_size;	/* size requested by user (wo fence) */
   unsigned int		sa_total_size;	/* total size of the block */
@@ -158,6 +194,171 @@ typedef struct entry_block_st {
    */
 } entry_block_t;
 
+/* divided-block magic numbers */
+#define SLAB_BLOCK_MAGIC1	0x5AB51111	/* for the sb_magic1 field */
+#define SLAB_BLOCK_MAGIC2	0x5AB52222	/* for the sb_magic2 field */
+
+/* number of chunks tracked by each word of the available bitmap */
+#define SLAB_MAP_BITS		(sizeof(unsigned long) * 8)
+
+/*
+ * The following structure is written at the front of the
+ * administrative block(s) which track a divided-block.  Instead of
+ * having a skip-list slot for each chunk, the whole divided-block is
+ * on the used list with the sb_slot entry.  The chunks are tracked
+ * with a bitmap of the available chunks and an array of level 0
+ * slots which follow the structure.
+ */
+typedef struct slab_block_st {
+  /*
+   * Our slot on the used list.  It must be first so we can go from
+   * the slot to the block.  The next pointers array makes sure that
+   * we have enough space for the slot's forward pointers.
+   */
+  skip_alloc_t		sb_slot;
+  skip_alloc_t		*sb_slot_next[MAX_SKIP_LEVEL];
+  
+  unsigned int		sb_magic1;	/* magic number */
+  unsigned int		sb_bit_c;	/* index of our size in bit_sizes */
+  unsigned int		sb_chunk_size;	/* size of each of the chunks */
+  unsigned int		sb_chunk_n;	/* number of chunks in the block */
+  unsigned int		sb_avail_n;	/* number of chunks available */
+  unsigned int		sb_admin_size;	/* size of our admin allocation */
+  unsigned long		*sb_avail_map;	/* bitmap of the available chunks */
+  skip_alloc_t		*sb_chunks;	/* slots for each of the chunks */
+  struct slab_block_st	*sb_next_p;	/* next block of the same size */
+  struct slab_block_st	*sb_prev_p;	/* previous block of the size */
+  struct slab_block_st	*sb_avail_next_p; /* next with available chunks */
+  struct slab_block_st	*sb_avail_prev_p; /* previous with available */
+  unsigned int		sb_magic2;	/* magic number */
+  
+  /*
+   * the available bitmap and then the chunk slots are after this
+   * structure in the admin block(s)
+   */
+} slab_block_t;
+
+/* get the slot of the chunk in a divided-block which holds an address */
+#define SLAB_CHUNK(slab_p, addr)					\
+	((slab_p)->sb_chunks +						\
+	 ((char *)(addr) - (char *)(slab_p)->sb_slot.sa_mem) /		\
+	 (slab_p)->sb_chunk_size)
+
+/* the lists visited by a heap walk in the hw_list_c field */
+#define HEAP_WALK_USED		0	/* the used address list */
+#define HEAP_WALK_FREE		1	/* the free size list */
+#define HEAP_WALK_WAIT		2	/* the freed pointer wait list */
+
+/*
+ * The following structure holds our place when we are walking all of
+ * the used and free slots in the heap.  It should be zeroed before the
+ * walk is started.
+ */
+typedef struct {
+  int		hw_list_c;		/* which list we are walking */
+  skip_alloc_t	*hw_slot_p;		/* current slot on the list */
+  slab_block_t	*hw_slab_p;		/* divided-block we are walking */
+  unsigned int	hw_chunk_c;		/* next chunk in the divided-block */
+  void		*hw_mem;		/* memory of the current slot */
+  unsigned int	hw_size;		/* size of the current slot */
+} heap_walk_t;
+
+/* most parts that the full heap check is split into */
+#define CHECK_RANGE_MAX		32
+/* least blanked memory to scan in each of the parts */
+#define CHECK_RANGE_MIN_SIZE	(16 * BLOCK_SIZE)
+
+/*
+ * One of the parts of the heap that are scanned at the same time by
+ * the check-threads.  The part starts after the place of the walk.
+ */
+typedef struct {
+  heap_walk_t	cr_walk;		/* walk just before the part */
+  unsigned long	cr_slot_n;		/* number of slots in the part */
+  unsigned long	cr_bad_c;		/* first slot that failed or slot_n */
+} check_range_t;
+
+/*
+ * The page map is a radix tree indexed by block number which points
+ * from the first and last blocks of each run on the free list to the
+ * run's slot so we can find free neighbors without a search.  Each of
+ * the three levels of the tree uses PAGE_MAP_BITS of the block number.
+ */
+#define PAGE_MAP_BITS		12
+#define PAGE_MAP_SIZE		(1 << PAGE_MAP_BITS)
+#define PAGE_MAP_MASK		(PAGE_MAP_SIZE - 1)
+
+/* largest run of free blocks that we build by merging neighbors */
+#define FREE_RUN_MAX		((unsigned int)-1 / 2)
+
+/* flags that need more than the file/line tracking of each pointer */
+#define POINTER_DEBUG_FLAGS	\
+	(DEBUG_CHECK_FENCE | DEBUG_GUARD_PAGES | DEBUG_CHECK_BLANK | \
+	 DEBUG_ALLOC_BLANK | DEBUG_FREE_BLANK | DEBUG_PROTECT_FREE | \
+	 DEBUG_NEVER_REUSE | DEBUG_LOG_TRANS | DEBUG_LOG_ELAPSED_TIME | \
+	 DEBUG_LOG_CURRENT_TIME)
+
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+
+/* thread cache magic numbers */
+#define THREAD_CACHE_MAGIC1	0x7CAC1111	/* for the tc_magic1 field */
+#define THREAD_CACHE_MAGIC2	0x7CAC2222	/* for the tc_magic2 field */
+
+/* we stop handing out pointers when our table is half full */
+#define THREAD_CACHE_PNT_MAX	(THREAD_CACHE_PNTS / 2)
+
+/* buckets counting the pointers that all of the caches have handed out */
+#define CACHE_HANDED_BUCKETS	(THREAD_CACHE_PNTS * 8)
+
+/*
+ * The following structure holds a thread's cache of divided-block
+ * chunks.  The chunks that the thread has freed wait in a ring for
+ * each chunk size so they can be handed out again without locking the
+ * library.  The pointers that were handed out of the cache are kept
+ * in a hash table so they can be freed back into the cache by any
+ * thread without the library lock.  All of the chunks in a cache are
+ * marked with ALLOC_FLAG_CACHED and they are only changed while
+ * holding the tc_mutex.  The library's counts are adjusted when the
+ * cache is flushed.
+ */
+typedef struct thread_cache_st {
+  unsigned int		tc_magic1;	/* magic number */
+  int			tc_used_b;	/* cache belongs to a thread */
+  THREAD_MUTEX_T	tc_mutex;	/* lock on the cache */
+  
+  /* rings of the freed chunks for each of the sizes in bit_sizes */
+  skip_alloc_t		*tc_free[BASIC_BLOCK][THREAD_CACHE_SIZE];
+  unsigned int		tc_free_start[BASIC_BLOCK];
+  unsigned int		tc_free_n[BASIC_BLOCK];
+  
+  /* hash table of the chunks handed out by the cache */
+  skip_alloc_t		*tc_pnts[THREAD_CACHE_PNTS];
+  unsigned int		tc_pnt_n;
+  
+  unsigned long		tc_sample_c;	/* allocations until next sample */
+  
+  /* changes to the library counts since the last flush */
+  long			tc_alloc_current; /* change in memory usage */
+  long			tc_alloc_peak;	/* peak change in memory usage */
+  long			tc_cur_given;	/* change in memory given */
+  long			tc_given_peak;	/* peak change in memory given */
+  long			tc_cur_pnts;	/* change in pointers */
+  long			tc_pnts_peak;	/* peak change in pointers */
+  unsigned long		tc_alloc_total;	/* bytes allocated */
+  unsigned long		tc_one_max;	/* maximum at once */
+  unsigned long		tc_tot_pnts;	/* pointers allocated */
+  unsigned long		tc_malloc_c;	/* count the mallocs */
+  unsigned long		tc_calloc_c;	/* count the callocs */
+  unsigned long		tc_new_c;	/* count the news */
+  unsigned long		tc_free_c;	/* count the frees */
+  unsigned long		tc_delete_c;	/* count the deletes */
+  
+  struct thread_cache_st *tc_next_p;	/* next cache in the list */
+  unsigned int		tc_magic2;	/* magic number */
+} thread_cache_t;
+
+#endif /* LOCK_THREADS && THREAD_CACHE_SIZE > 0 */
+
 /*
  * The following structure is used to figure out a number of bits of
  * information about a user allocation.
@@ -166,6 +367,7 @@ typedef struct {
   int		pi_fence_b;		/* fence-posts are on for pointer */
   int		pi_valloc_b;		/* pointer is valloc-aligned */
   int		pi_blanked_b;		/* pointer was blanked */
+  int		pi_guard_b;		/* pointer ends at a guard page */
   void		*pi_alloc_start;	/* pnt to start of allocation */
   void		*pi_fence_bottom;	/* pnt to the bottom fence area */
   void		*pi_user_start;		/* pnt to start of user allocation */
@@ -173,6 +375,7 @@ typedef struct {
   void		*pi_fence_top;		/* pnt to the top fence area */
   void		*pi_upper_bounds;	/* pnt to highest available user area*/
   void		*pi_alloc_bounds;	/* pnt past end of total allocation */
+					/* (below the guard page if any) */
 } pnt_info_t;
 
 #endif /* ! __CHUNK_LOC_H__ */
@@ -48,7 +48,7 @@
 /* checking */
 #define DEBUG_CHECK_FENCE	BIT_FLAG(10)	/* check fence-post errors  */
 #define DEBUG_CHECK_HEAP	BIT_FLAG(11)	/* examine heap adm structs */
-/* 12 available - 20030608 */
+#define DEBUG_GUARD_PAGES	BIT_FLAG(12)	/* guard page after allocs */
 #define DEBUG_CHECK_BLANK	BIT_FLAG(13)	/* check blank sections */
 #define DEBUG_CHECK_FUNCS	BIT_FLAG(14)	/* check functions */
 #define DEBUG_CHECK_SHUTDOWN	BIT_FLAG(15)	/* check pointers on shutdown*/
@@ -61,7 +61,7 @@
 #define DEBUG_FREE_BLANK	BIT_FLAG(21)	/* write over free'd memory */
 #define DEBUG_ERROR_ABORT	BIT_FLAG(22)	/* abort on error else exit */
 #define DEBUG_ALLOC_BLANK	BIT_FLAG(23)	/* write over to-be-alloced */
-/* 24 available - 20030508 */
+#define DEBUG_PROTECT_FREE	BIT_FLAG(24)	/* no-access freed memory */
 #define DEBUG_PRINT_MESSAGES	BIT_FLAG(25)	/* write messages to STDERR */
 #define DEBUG_CATCH_NULL	BIT_FLAG(26)	/* quit before return null */
 #define DEBUG_NEVER_REUSE	BIT_FLAG(27)	/* never reuse memory */
@@ -107,6 +107,8 @@ __attribute__ ((unused))
     "check mem overwritten by alloc-blank, free-blank" },
   { "check-funcs",	DEBUG_CHECK_FUNCS,	"check functions" },
   { "check-shutdown",	DEBUG_CHECK_SHUTDOWN,	"check heap on shutdown" },
+  { "guard-pages",	DEBUG_GUARD_PAGES,
+    "end allocations at a no-access page" },
   
   { "catch-signals",	DEBUG_CATCH_SIGNALS,
     "shutdown program on SIGHUP, SIGINT, SIGTERM" },
@@ -119,6 +121,8 @@ __attribute__ ((unused))
   { "print-messages",	DEBUG_PRINT_MESSAGES,	"write messages to stderr" },
   { "catch-null",	DEBUG_CATCH_NULL,      "abort if no memory available"},
   { "never-reuse",	DEBUG_NEVER_REUSE,	"never re-use freed memory" },
+  { "protect-free",	DEBUG_PROTECT_FREE,
+    "make freed memory no-access until reused" },
   { "error-dump",	DEBUG_ERROR_DUMP,
     "dump core on error, then continue" },
   { "error-free-null",	DEBUG_ERROR_FREE_NULL,
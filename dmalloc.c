@@ -118,6 +118,7 @@ static	char	*address = NULL;		/* for ADDRESS */
 static	int	clear_b = 0;			/* clear variables */
 static	int	debug = 0;			/* for DEBUG */
 static	int	errno_to_print = 0;		/* to print the error string */
+static	char	*guard_arg = NULL;		/* for GUARD setting */
 static	int	help_b = 0;			/* print help message */
 static	char	*inpath = NULL;			/* for config-file path */
 static	unsigned long interval = 0;		/* for setting INTERVAL */
@@ -129,8 +130,15 @@ static	char	*logpath = NULL;		/* for LOGFILE setting */
 static	int	long_tokens_b = 0;		/* long-tok output */
 static	argv_array_t	minus;			/* tokens to remove */
 static	unsigned long limit_arg = 0;		/* memory limit */
+static	unsigned long reserve_arg = 0;		/* heap reservation size */
+static	unsigned long sample_arg = 0;		/* sample rate */
 static	int	make_changes_b = 1;		/* make no changes to env */
 static	argv_array_t	plus;			/* tokens to add */
+static	unsigned long quarantine_arg = 0;	/* freed bytes held */
+static	unsigned long quarantine_count_arg = 0;	/* freed pointers held */
+static	unsigned long budget_arg = 0;		/* heap check budget */
+static	unsigned long verify_arg = 0;		/* verify thread period */
+static	unsigned long check_threads_arg = 0;	/* heap check threads */
 static	int	remove_auto_b = 0;		/* auto-remove settings */
 static	char	*start_file = NULL;		/* for START settings */
 static	unsigned long start_iter = 0;		/* for START settings */
@@ -156,6 +164,10 @@ static	argv_t	args[] = {
   
   { 'a',	"address",	ARGV_CHAR_P,	&address,
     "address:#",		"stop when malloc sees address" },
+  { '\0',	"check-budget",	ARGV_U_LONG,	&budget_arg,
+    "number",			"blocks of heap checked per call" },
+  { '\0',	"check-threads", ARGV_U_LONG,	&check_threads_arg,
+    "number",			"threads to split heap check" },
   { 'c',	"clear",	ARGV_BOOL_INT,	&clear_b,
     NULL,			"clear all variables not set" },
   { DEBUG_ARG,	"debug-mask",	ARGV_HEX,	&debug,
@@ -168,6 +180,8 @@ static	argv_t	args[] = {
     "path",			"config if not $HOME/.dmallocrc" },
   { 'h',	"help",		ARGV_BOOL_INT,	&help_b,
     NULL,			"print help message" },
+  { '\0',	"heap-reserve",	ARGV_U_SIZE,	&reserve_arg,
+    "size",			"size of heap address reservations" },
   { INTERVAL_ARG, "interval",	ARGV_U_LONG,	&interval,
     "value",			"check heap every number times" },
   { 'k',	"keep",		ARGV_BOOL_INT,	&keep_b,
@@ -183,11 +197,19 @@ static	argv_t	args[] = {
   { 'n',	"no-changes",	ARGV_BOOL_NEG,	&make_changes_b,
     NULL,			"make no changes to the env" },
   { THREAD_LOCK_ON_ARG, "lock-on", ARGV_INT,	&thread_lock_on,
-    "number",			"number of times to not lock" },
+    "number",			"obsolete, ignored by the library" },
   { 'p',	"plus",		ARGV_CHAR_P | ARGV_FLAG_ARRAY,	&plus,
     "token(s)",			"add tokens to current debug" },
+  { '\0',	"quarantine",	ARGV_U_SIZE,	&quarantine_arg,
+    "size",			"freed bytes held before reuse" },
+  { '\0',	"quarantine-count", ARGV_U_LONG, &quarantine_count_arg,
+    "number",			"freed pointers held before reuse" },
   { 'r',	"remove",	ARGV_BOOL_INT,	&remove_auto_b,
     NULL,			"remove other settings if tag" },
+  { '\0',	"sample-rate",	ARGV_U_LONG,	&sample_arg,
+    "number",			"fully check 1 in number allocs" },
+  { '\0',	"guard",	ARGV_CHAR_P,	&guard_arg,
+    "file:line|sN[-M]",		"guard page after these allocs" },
   
   { 's',	"start-file",	ARGV_CHAR_P,	&start_file,
     "file:line",		"check heap after this location" },
@@ -206,6 +228,8 @@ static	argv_t	args[] = {
     NULL,			"turn on verbose output" },
   { 'V',	"very-verbose",	ARGV_BOOL_INT,	&very_verbose_b,
     NULL,			"turn on very-verbose output" },
+  { '\0',	"verify-period", ARGV_U_LONG,	&verify_arg,
+    "msecs",			"ms between verify thread checks" },
   { '\0',	"version",	ARGV_BOOL_INT,	&version_b,
     NULL,			"display version string" },
   { ARGV_MAYBE,	NULL,		ARGV_CHAR_P,	&tag,
@@ -694,10 +718,12 @@ static	void	list_tags(void)
  */
 static	void	dump_current(void)
 {
-  char		*log_path, *loc_start_file, token[64];
+  char		*log_path, *loc_start_file, *guard_str, token[64];
   const char	*env_str;
   DMALLOC_PNT	addr;
-  unsigned long	inter, limit_val, loc_start_size, loc_start_iter;
+  unsigned long	inter, limit_val, reserve_val, sample_val, quarantine_val;
+  unsigned long	quarantine_count, budget_val, verify_val, check_threads;
+  unsigned long	loc_start_size, loc_start_iter;
   long		addr_count;
   int		lock_on, loc_start_line;
   unsigned int	flags;
@@ -710,7 +736,10 @@ static	void	dump_current(void)
   _dmalloc_environ_process(env_str, &addr, &addr_count, &flags,
 			   &inter, &lock_on, &log_path,
 			   &loc_start_file, &loc_start_line, &loc_start_iter,
-			   &loc_start_size, &limit_val);
+			   &loc_start_size, &limit_val, &reserve_val,
+			   &sample_val, &guard_str, &quarantine_val,
+			   &quarantine_count, &budget_val, &verify_val,
+			   &check_threads);
   
   if (flags == 0) {
     (void)fprintf(stderr, "Debug-Flags  not-set\n");
@@ -765,6 +794,62 @@ static	void	dump_current(void)
     (void)fprintf(stderr, "Mem-Limit    %lu\n", limit_val);
   }
   
+  if (reserve_val == 0) {
+    (void)fprintf(stderr, "Heap-Reserve not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Heap-Reserve %lu\n", reserve_val);
+  }
+  
+  if (sample_val == 0) {
+    (void)fprintf(stderr, "Sample-Rate  not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Sample-Rate  %lu\n", sample_val);
+  }
+  
+  if (guard_str == NULL) {
+    (void)fprintf(stderr, "Guard        not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Guard        '%s'\n", guard_str);
+  }
+  
+  if (quarantine_val == 0) {
+    (void)fprintf(stderr, "Quarantine   not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Quarantine   %lu\n", quarantine_val);
+  }
+  
+  if (quarantine_count == 0) {
+    (void)fprintf(stderr, "Quar-Count   not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Quar-Count   %lu\n", quarantine_count);
+  }
+  
+  if (budget_val == 0) {
+    (void)fprintf(stderr, "Check-Budget not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Check-Budget %lu\n", budget_val);
+  }
+  
+  if (verify_val == 0) {
+    (void)fprintf(stderr, "Verify-Per   not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Verify-Per   %lu\n", verify_val);
+  }
+  
+  if (check_threads == 0) {
+    (void)fprintf(stderr, "Check-Thrds  not-set\n");
+  }
+  else {
+    (void)fprintf(stderr, "Check-Thrds  %lu\n", check_threads);
+  }
+  
   if (loc_start_file != NULL) {
     (void)fprintf(stderr, "Start-File   '%s', line = %d\n",
 		  loc_start_file, loc_start_line);
@@ -862,11 +947,13 @@ int	main(int argc, char **argv)
 {
   char		buf[1024];
   int		set_b = 0;
-  char		*log_path, *loc_start_file;
+  char		*log_path, *loc_start_file, *guard_str;
   const char	*env_str;
   DMALLOC_PNT	addr;
-  unsigned long	inter, limit_val, loc_start_size, loc_start_iter;
-  unsigned long	addr_count;
+  unsigned long	inter, limit_val, reserve_val, sample_val, loc_start_size;
+  unsigned long	quarantine_val, quarantine_count, budget_val, verify_val;
+  unsigned long	check_threads;
+  unsigned long	loc_start_iter, addr_count;
   int		lock_on;
   int		loc_start_line;
   unsigned int	flags;
@@ -917,7 +1004,9 @@ int	main(int argc, char **argv)
   _dmalloc_environ_process(env_str, &addr, &addr_count, &flags, &inter,
 			   &lock_on, &log_path, &loc_start_file,
 			   &loc_start_line, &loc_start_iter, &loc_start_size,
-			   &limit_val);
+			   &limit_val, &reserve_val, &sample_val, &guard_str,
+			   &quarantine_val, &quarantine_count, &budget_val,
+			   &verify_val, &check_threads);
   
   /*
    * So, if a tag was specified on the command line then we set the
@@ -1033,6 +1122,49 @@ int	main(int argc, char **argv)
     set_b = 1;
   }
   
+  if (reserve_arg > 0) {
+    reserve_val = reserve_arg;
+    set_b = 1;
+  }
+  
+  if (sample_arg > 0) {
+    sample_val = sample_arg;
+    set_b = 1;
+  }
+  
+  if (quarantine_arg > 0) {
+    quarantine_val = quarantine_arg;
+    set_b = 1;
+  }
+  
+  if (quarantine_count_arg > 0) {
+    quarantine_count = quarantine_count_arg;
+    set_b = 1;
+  }
+  
+  if (budget_arg > 0) {
+    budget_val = budget_arg;
+    set_b = 1;
+  }
+  
+  if (verify_arg > 0) {
+    verify_val = verify_arg;
+    set_b = 1;
+  }
+  
+  if (check_threads_arg > 0) {
+    check_threads = check_threads_arg;
+    set_b = 1;
+  }
+  
+  if (guard_arg != NULL) {
+    guard_str = guard_arg;
+    set_b = 1;
+  }
+  else if (clear_b) {
+    guard_str = NULL;
+  }
+  
   if (errno_to_print > 0) {
     (void)fprintf(stderr, "%s: dmalloc_errno value '%d' = \n",
 		  argv_program, errno_to_print);
@@ -1076,7 +1208,9 @@ int	main(int argc, char **argv)
     _dmalloc_environ_set(buf, sizeof(buf), long_tokens_b, addr, addr_count,
 			 debug, inter, lock_on, log_path, loc_start_file,
 			 loc_start_line, loc_start_iter, loc_start_size,
-			 limit_val);
+			 limit_val, reserve_val, sample_val, guard_str,
+			 quarantine_val, quarantine_count, budget_val,
+			 verify_val, check_threads);
     set_variable(OPTIONS_ENVIRON, buf);
   }
   else if (errno_to_print == 0
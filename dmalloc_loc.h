@@ -92,6 +92,17 @@
           } \
         } while(0)
 
+/*
+ * Count a memory transaction in _dmalloc_iter_c.  The thread caches
+ * count their transactions without locking the library so then the
+ * increment needs to be atomic.
+ */
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+#define ITER_INCREMENT()	__sync_add_and_fetch(&_dmalloc_iter_c, 1)
+#else
+#define ITER_INCREMENT()	(++_dmalloc_iter_c)
+#endif
+
 /*
  * Global malloc defines
  */
@@ -24,6 +24,7 @@
  * should be script based.
  */
 
+#include <errno.h>				/* for EINVAL */
 #include <stdio.h>				/* for stdin */
 
 #if HAVE_STDLIB_H
@@ -1863,7 +1864,8 @@ static	int	check_special(void)
     unsigned int	old_flags = dmalloc_debug_current();
     unsigned char	ch_hold;
     
-    dmalloc_debug(old_flags | DEBUG_FREE_BLANK);
+    /* we write into the freed pointers so they cannot be no-access */
+    dmalloc_debug((old_flags | DEBUG_FREE_BLANK) & ~DEBUG_PROTECT_FREE);
     
     if (! silent_b) {
       (void)printf("  Overwriting free memory.\n");
@@ -1915,6 +1917,59 @@ static	int	check_special(void)
   
   /********************/
   
+  /*
+   * Make sure that overwritten freed memory is found at each of the
+   * offsets in and around the first and last words since the check
+   * compares a word at a time.  With never-reuse the freed memory is
+   * not checked.
+   */
+  if (! BIT_IS_SET(dmalloc_debug_current(), DEBUG_NEVER_REUSE)) {
+    int			where, amount = page_size;
+    int			errno_hold = dmalloc_errno;
+    unsigned int	old_flags = dmalloc_debug_current();
+    char		ch_hold;
+    
+    /* we write into the freed pointers so they cannot be no-access */
+    dmalloc_debug((old_flags | DEBUG_FREE_BLANK) & ~DEBUG_PROTECT_FREE);
+    
+    if (! silent_b) {
+      (void)printf("  Overwriting free memory at word edges.\n");
+    }
+    
+    pnt = malloc(amount);
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not allocate %d bytes.\n", amount);
+      }
+      return 0;
+    }
+    free(pnt);
+    
+    for (where = 0; where < amount; where++) {
+      /* skip the middle of the pointer */
+      if (where == (int)sizeof(long) * 6) {
+	where = amount - sizeof(long) * 6;
+      }
+      ch_hold = *((char *)pnt + where);
+      *((char *)pnt + where) = 'h';
+      dmalloc_errno = ERROR_NONE;
+      if (dmalloc_verify(NULL /* check all heap */) == DMALLOC_NOERROR
+	  || dmalloc_errno != ERROR_FREE_OVERWRITTEN) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: overwriting free memory at offset %d not detected: %s (err %d)\n",
+		       where, dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+	}
+	final = 0;
+      }
+      *((char *)pnt + where) = ch_hold;
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+  
   /*
    * Check to see if the space above an allocated pnt is detected.
    */
@@ -2498,6 +2553,137 @@ static	int	check_special(void)
     dmalloc_errno = errno_hold;
   }
   
+  /********************/
+  
+  /*
+   * Make sure that the heap check with a budget gets around to a
+   * problem after enough transactions.
+   */
+  {
+    unsigned int	old_flags = dmalloc_debug_current();
+    int			errno_hold = dmalloc_errno;
+    int			iter_c;
+    char		save_ch;
+    char		setup[128];
+    
+    if (! silent_b) {
+      (void)printf("  Checking heap check with a check-budget\n");
+    }
+    
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x,check-budget=16",
+		       DEBUG_CHECK_FENCE | DEBUG_CHECK_HEAP);
+    dmalloc_debug_setup(setup);
+    dmalloc_errno = ERROR_NONE;
+    
+    pnt = malloc(BUF_SIZE);
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", BUF_SIZE);
+      }
+      return 0;
+    }
+    
+    /* overwrite the high fence post */
+    save_ch = *((char *)pnt + BUF_SIZE);
+    *((char *)pnt + BUF_SIZE) = '\0';
+    
+    for (iter_c = 0; iter_c < 100000; iter_c++) {
+      free(malloc(BUF_SIZE));
+      if (dmalloc_errno != ERROR_NONE) {
+	break;
+      }
+    }
+    if (dmalloc_errno != ERROR_OVER_FENCE) {
+      if (! silent_b) {
+	(void)printf("   ERROR: heap check with a budget did not find the over fence-post error: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    /* restore the overwritten character otherwise we can't free the pointer */
+    *((char *)pnt + BUF_SIZE) = save_ch;
+    free(pnt);
+    
+    /* reset the debug flags and errno */
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x", old_flags);
+    dmalloc_debug_setup(setup);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+  
+  /*
+   * Make sure that the heap check still finds overwritten free memory
+   * when it is split between check-threads.  Without threads the parts
+   * are all checked by us.  With never-reuse the freed memory is not
+   * checked.
+   */
+  if (! BIT_IS_SET(dmalloc_debug_current(), DEBUG_NEVER_REUSE)) {
+    unsigned int	old_flags = dmalloc_debug_current();
+    int			errno_hold = dmalloc_errno;
+    int			pnt_c;
+    char		*pnts[16], ch_hold, *where_p;
+    char		setup[128];
+    
+    if (! silent_b) {
+      (void)printf("  Checking heap check split between check-threads\n");
+    }
+    
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x,check-threads=4",
+		       (old_flags | DEBUG_FREE_BLANK | DEBUG_CHECK_BLANK)
+		       & ~DEBUG_PROTECT_FREE);
+    dmalloc_debug_setup(setup);
+    dmalloc_errno = ERROR_NONE;
+    
+    for (pnt_c = 0; pnt_c < 16; pnt_c++) {
+      pnts[pnt_c] = malloc(page_size * 8);
+      if (pnts[pnt_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not malloc %d bytes.\n",
+		       page_size * 8);
+	}
+	return 0;
+      }
+    }
+    for (pnt_c = 0; pnt_c < 16; pnt_c++) {
+      free(pnts[pnt_c]);
+    }
+    
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: split heap check failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    /* overwrite the freed memory of a pointer near the end */
+    where_p = pnts[13] + page_size * 4;
+    ch_hold = *where_p;
+    *where_p = 'h';
+    
+    if (dmalloc_verify(NULL /* check all heap */) == DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: split heap check did not find overwritten free memory.\n");
+      }
+      final = 0;
+    }
+    else if (dmalloc_errno != ERROR_FREE_OVERWRITTEN) {
+      if (! silent_b) {
+	(void)printf("   ERROR: split heap check returned: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    *where_p = ch_hold;
+    
+    /* reset the debug flags and errno */
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x", old_flags);
+    dmalloc_debug_setup(setup);
+    dmalloc_errno = errno_hold;
+  }
+  
   /********************/
  
   /*
@@ -2759,136 +2945,682 @@ static	int	check_special(void)
 #endif
   
   /********************/
-
+  
   /*
-   * Test strndup.
+   * Make sure that the quarantine holds on to freed pointers for longer
+   * than the freed pointer delay and that they are found if they are
+   * freed again.  With never-reuse nothing goes into the quarantine.
    */
-  {
-    int		errno_hold = dmalloc_errno;
-    int		size = 5;
-    char	*str, *ret;
-    unsigned int old_flags = dmalloc_debug_current();
-  
+  if (! BIT_IS_SET(dmalloc_debug_current(), DEBUG_NEVER_REUSE)) {
+    int			errno_hold = dmalloc_errno;
+    unsigned int	old_flags = dmalloc_debug_current();
+    int			pnt_c, pnt_n = FREED_POINTER_DELAY * 5 + 10;
+    char		setup[128];
+    void		*pnt2;
+    
     if (! silent_b) {
-      (void)printf("  Checking strndup\n");
+      (void)printf("  Checking quarantine-count setting\n");
     }
     
-    dmalloc_debug(old_flags | DEBUG_CHECK_FUNCS);
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x,quarantine-count=%d",
+		       old_flags, pnt_n);
+    dmalloc_debug_setup(setup);
     
-    pnt = malloc(size);
+    pnt = malloc(page_size);
     if (pnt == NULL) {
       if (! silent_b) {
-	(void)printf("   ERROR: could not malloc %d bytes.\n", size);
+	(void)printf("   ERROR: could not malloc %d bytes.\n", page_size);
       }
       return 0;
     }
-    str = "1234";
-    memmove(pnt, str, size);
-    
-    dmalloc_errno = ERROR_NONE;
-    ret = strndup(pnt, size);
+    free(pnt);
     
-    if (dmalloc_errno != ERROR_NONE) {
-      if (! silent_b) {
-	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
-		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+    for (pnt_c = 0; pnt_c < pnt_n - 1; pnt_c++) {
+      pnt2 = malloc(page_size);
+      if (pnt2 == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not malloc %d bytes.\n", page_size);
+	}
+	return 0;
       }
-      final = 0;
-    } else if (strcmp(pnt, str) != 0) {
-      if (! silent_b) {
-	(void)printf("   ERROR: strndup should have copied string\n");
+      if (pnt2 == pnt) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: quarantined pointer was reused after %d frees.\n",
+		       pnt_c);
+	}
+	final = 0;
       }
-      final = 0;
+      free(pnt2);
     }
     
+    /* it is still in the quarantine so this should be caught */
     dmalloc_errno = ERROR_NONE;
-    ret = strndup(pnt, size + 1);
-    
-    if (dmalloc_errno != ERROR_NONE) {
+    if (dmalloc_free(__FILE__, __LINE__, pnt,
+		     DMALLOC_FUNC_FREE) == FREE_NOERROR
+	|| dmalloc_errno != ERROR_ALREADY_FREE) {
       if (! silent_b) {
-	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
+	(void)printf("   ERROR: double free from quarantine should get ERROR_ALREADY_FREE not: %s (err %d)\n",
 		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
       }
       final = 0;
-    } else if (strcmp(pnt, str) != 0) {
-      if (! silent_b) {
-	(void)printf("   ERROR: strndup should have copied string\n");
-      }
-      final = 0;
     }
     
-    str = "12345";
-    memmove(pnt, str, size);
+    (void)loc_snprintf(setup, sizeof(setup), "debug=%#x", old_flags);
+    dmalloc_debug_setup(setup);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+  
+  /*
+   * Make sure that the chunks of divided-blocks are handed out and
+   * taken back properly.
+   */
+  {
+    int		errno_hold = dmalloc_errno;
+    int		size = 24, pnt_c, pnt_n;
+    char	*pnts[BLOCK_SIZE / 8];
     
-    dmalloc_errno = ERROR_NONE;
-    strndup(pnt, size);
+    if (! silent_b) {
+      (void)printf("  Checking divided-block chunks\n");
+    }
     
-    if (dmalloc_errno != ERROR_NONE) {
+    /* enough pointers to fill more than one of the blocks */
+    pnt_n = sizeof(pnts) / sizeof(*pnts);
+    for (pnt_c = 0; pnt_c < pnt_n; pnt_c++) {
+      pnts[pnt_c] = malloc(size);
+      if (pnts[pnt_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not malloc %d bytes.\n", size);
+	}
+	return 0;
+      }
+      memset(pnts[pnt_c], pnt_c, size);
+    }
+    
+    /* free every other one and make sure the rest are untouched */
+    for (pnt_c = 0; pnt_c < pnt_n; pnt_c += 2) {
+      free(pnts[pnt_c]);
+    }
+    for (pnt_c = 1; pnt_c < pnt_n; pnt_c += 2) {
+      if (pnts[pnt_c][0] != (char)pnt_c || pnts[pnt_c][size - 1] != (char)pnt_c) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: chunk %d was overwritten.\n", pnt_c);
+	}
+	final = 0;
+	break;
+      }
+    }
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
       if (! silent_b) {
-	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
+	(void)printf("   ERROR: heap check after chunk frees failed: %s (err %d)\n",
 		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
       }
       final = 0;
-    } else if (strcmp(pnt, str) != 0) {
+    }
+    
+    /* the 2nd free of a chunk which can be used again should be caught */
+    for (pnt_c = 0; pnt_c < FREED_POINTER_DELAY + 1; pnt_c++) {
+      free(malloc(BLOCK_SIZE));
+    }
+    dmalloc_errno = ERROR_NONE;
+    if (dmalloc_free(__FILE__, __LINE__, pnts[0],
+		     DMALLOC_FUNC_FREE) == FREE_NOERROR) {
       if (! silent_b) {
-	(void)printf("   ERROR: strndup should have copied string\n");
+	(void)printf("   ERROR: 2nd free of chunk should have failed\n");
       }
       final = 0;
     }
-
-    dmalloc_errno = ERROR_NONE;
-    strndup(pnt, size + 1);
-    
-    if (dmalloc_errno != ERROR_WOULD_OVERWRITE) {
+    else if (dmalloc_errno != ERROR_ALREADY_FREE) {
       if (! silent_b) {
-	(void)printf("   ERROR: strndup should produce overwrite error not: %s (err %d)\n",
+	(void)printf("   ERROR: 2nd free of chunk should get ERROR_ALREADY_FREE not: %s (err %d)\n",
 		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
       }
       final = 0;
     }
     
-    dmalloc_debug(old_flags);
+    for (pnt_c = 1; pnt_c < pnt_n; pnt_c += 2) {
+      free(pnts[pnt_c]);
+    }
+    
     dmalloc_errno = errno_hold;
   }
   
   /********************/
   
-  /* check all of the arg check routines */
-  if (! check_arg_check()) {
-    final = 0;
-  }
-  
-  /********************/
-  
-  dmalloc_message("NOTE: ignore the errors from the above ----- to here.\n");
-  dmalloc_message("-------------------------------------------------------\n");
-  
-  /*
-   * The following errors whould not generate a dmalloc_errno nor any
-   * error messages
-   */
-  
-  /********************/
-  
   /*
-   * Make sure that realloc of NULL pointers either works or doesn't
-   * depending on the proper ALLOW_REALLOC_NULL setting.
+   * Make sure that neighboring free blocks are merged together once
+   * they are off of the free wait list.
    */
-  
   {
+    int			errno_hold = dmalloc_errno;
+    int			size = BLOCK_SIZE * 5, pnt_c, pnt_n, low_c, next_c;
+    int			row_c, row[3];
+    char		*pnts[8], *low_p = NULL, *new_p;
+    void		*reuse[64];
+    unsigned long	total_before, total_after;
+    unsigned int	old_flags = dmalloc_debug_current();
+    
     if (! silent_b) {
-      (void)printf("  Trying to realloc a 0L pointer.\n");
-    }
-    pnt = realloc(NULL, 10);
-#if ALLOW_REALLOC_NULL
-    if (pnt == NULL) {
-      if (! silent_b) {
-	(void)printf("   ERROR: re-allocation of 0L returned error.\n");
-      }
-      final = 0;
+      (void)printf("  Checking merging of free blocks\n");
     }
-    else {
-      free(pnt);
+    
+    /* we need the freed blocks to be reused and sized exactly */
+    dmalloc_debug(old_flags & ~(DEBUG_NEVER_REUSE | DEBUG_CHECK_FENCE));
+    
+    pnt_n = sizeof(pnts) / sizeof(*pnts);
+    for (pnt_c = 0; pnt_c < pnt_n; pnt_c++) {
+      pnts[pnt_c] = malloc(size);
+      if (pnts[pnt_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not malloc %d bytes.\n", size);
+	}
+	return 0;
+      }
+    }
+    
+    /*
+     * Look for four of them in a row in memory.  We free the middle two
+     * so the merged run is fenced in by the pointers we still hold.
+     */
+    for (low_c = 0; low_c < pnt_n && low_p == NULL; low_c++) {
+      row_c = low_c;
+      for (pnt_c = 0; pnt_c < 3; pnt_c++) {
+	for (next_c = 0; next_c < pnt_n; next_c++) {
+	  if (pnts[row_c] + size == pnts[next_c]) {
+	    break;
+	  }
+	}
+	if (next_c >= pnt_n) {
+	  break;
+	}
+	row[pnt_c] = next_c;
+	row_c = next_c;
+      }
+      if (pnt_c == 3) {
+	low_p = pnts[row[0]];
+	free(pnts[row[0]]);
+	free(pnts[row[1]]);
+	pnts[row[0]] = NULL;
+	pnts[row[1]] = NULL;
+      }
+    }
+    
+    /* the heap may not have given us neighbors in which case we skip */
+    if (low_p != NULL) {
+      /* push them off of the wait list without using whole blocks */
+      for (pnt_c = 0; pnt_c < FREED_POINTER_DELAY + 1; pnt_c++) {
+	free(malloc(10));
+      }
+      
+      /*
+       * Now the merged run should be handed out for the combined size
+       * before the heap has to grow.  An allocation may grow the heap
+       * by a block of admin slots but never by its own blocks.
+       */
+      for (pnt_c = 0; pnt_c < (int)(sizeof(reuse) / sizeof(*reuse));
+	   pnt_c++) {
+	dmalloc_get_stats(NULL, NULL, &total_before, NULL, NULL, NULL, NULL,
+			  NULL, NULL);
+	new_p = malloc(size * 2);
+	reuse[pnt_c] = new_p;
+	dmalloc_get_stats(NULL, NULL, &total_after, NULL, NULL, NULL, NULL,
+			  NULL, NULL);
+	if (new_p == low_p || new_p == NULL
+	    || total_after > total_before + BLOCK_SIZE) {
+	  pnt_c++;
+	  break;
+	}
+      }
+      if (new_p != low_p) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: neighboring free blocks were not merged.\n");
+	}
+	final = 0;
+      }
+      while (pnt_c > 0) {
+	pnt_c--;
+	free(reuse[pnt_c]);
+      }
+    }
+    
+    for (pnt_c = 0; pnt_c < pnt_n; pnt_c++) {
+      if (pnts[pnt_c] != NULL) {
+	free(pnts[pnt_c]);
+      }
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+  
+  /*
+   * Make sure that smaller allocations are cut out of a large free
+   * block instead of growing the heap.
+   */
+  {
+    int			errno_hold = dmalloc_errno;
+    int			size = BLOCK_SIZE * 4, pnt_c;
+    char		*big_p, *pnts[4];
+    unsigned long	total_before, total_after;
+    unsigned int	old_flags = dmalloc_debug_current();
+    
+    if (! silent_b) {
+      (void)printf("  Checking splitting of free blocks\n");
+    }
+    
+    /* we need the freed block to be reused and sized exactly */
+    dmalloc_debug(old_flags & ~(DEBUG_NEVER_REUSE | DEBUG_CHECK_FENCE));
+    
+    big_p = malloc(size * 4);
+    if (big_p == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", size * 4);
+      }
+      return 0;
+    }
+    free(big_p);
+    
+    /* push it off of the wait list without using whole blocks */
+    for (pnt_c = 0; pnt_c < FREED_POINTER_DELAY + 1; pnt_c++) {
+      free(malloc(10));
+    }
+    
+    /* a split may need a block of admin slots but never new user blocks */
+    for (pnt_c = 0; pnt_c < 4; pnt_c++) {
+      dmalloc_get_stats(NULL, NULL, &total_before, NULL, NULL, NULL, NULL,
+			NULL, NULL);
+      pnts[pnt_c] = malloc(size);
+      dmalloc_get_stats(NULL, NULL, &total_after, NULL, NULL, NULL, NULL,
+			NULL, NULL);
+      if (total_after > total_before + BLOCK_SIZE) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: heap grew from %lu to %lu bytes instead of splitting free blocks.\n",
+		       total_before, total_after);
+	}
+	final = 0;
+      }
+    }
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: heap check after splitting failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    for (pnt_c = 0; pnt_c < 4; pnt_c++) {
+      free(pnts[pnt_c]);
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+
+  /*
+   * Make sure that empty divided-blocks go back on the free list.
+   */
+  {
+    int		errno_hold = dmalloc_errno;
+    int		size = BLOCK_SIZE / 8, pnt_c, found_b = 0;
+    char	*block_p;
+    void	*pnts[32], *big_pnts[1024];
+    unsigned int old_flags = dmalloc_debug_current();
+    
+    if (! silent_b) {
+      (void)printf("  Checking reclaiming of empty divided-blocks\n");
+    }
+    
+    /* we need the chunks to be reused and sized exactly */
+    dmalloc_debug(old_flags & ~(DEBUG_NEVER_REUSE | DEBUG_CHECK_FENCE));
+    
+    for (pnt_c = 0; pnt_c < 32; pnt_c++) {
+      pnts[pnt_c] = malloc(size);
+      if (pnts[pnt_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not malloc %d bytes.\n", size);
+	}
+	return 0;
+      }
+    }
+    /* all of the chunks in this block are ours */
+    block_p = (char *)pnts[15] - ((unsigned long)pnts[15] % BLOCK_SIZE);
+    
+    /* free one from the last block first so it is available */
+    free(pnts[31]);
+    for (pnt_c = 0; pnt_c < 31; pnt_c++) {
+      free(pnts[pnt_c]);
+    }
+    /* this flushes any thread caches */
+    (void)dmalloc_verify(NULL /* check all heap */);
+    
+    /* push them off of the wait list */
+    for (pnt_c = 0; pnt_c < FREED_POINTER_DELAY + 1; pnt_c++) {
+      free(malloc(10));
+    }
+    
+    /*
+     * The block should now be handed out to a whole-block allocation
+     * although the random tests may have left many single free blocks
+     * which best-fit will hand out first.
+     */
+    for (pnt_c = 0; pnt_c < 1024; pnt_c++) {
+      big_pnts[pnt_c] = malloc(BLOCK_SIZE);
+      if (big_pnts[pnt_c] == block_p) {
+	found_b = 1;
+	pnt_c++;
+	break;
+      }
+    }
+    if (! found_b) {
+      if (! silent_b) {
+	(void)printf("   ERROR: empty divided-block %#lx was not reused.\n",
+		     (unsigned long)block_p);
+      }
+      final = 0;
+    }
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: heap check after reclaiming failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    while (pnt_c > 0) {
+      pnt_c--;
+      free(big_pnts[pnt_c]);
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+
+  /*
+   * Make sure that pointers into the middle of multi-block
+   * allocations are found in the page map but are not freed.
+   */
+  {
+    int		errno_hold = dmalloc_errno;
+    int		size = BLOCK_SIZE * 3;
+    char	*inside_p;
+    
+    if (! silent_b) {
+      (void)printf("  Checking pointers inside of blocks\n");
+    }
+    
+    pnt = malloc(size);
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", size);
+      }
+      return 0;
+    }
+    inside_p = (char *)pnt + BLOCK_SIZE * 2;
+    
+    dmalloc_errno = ERROR_NONE;
+    if (dmalloc_verify_pnt(__FILE__, __LINE__, "test", inside_p,
+			   0 /* not exact */, 10) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: check of pointer inside of block failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    dmalloc_errno = ERROR_NONE;
+    if (dmalloc_free(__FILE__, __LINE__, inside_p,
+		     DMALLOC_FUNC_FREE) == FREE_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: free of pointer inside of block should have failed\n");
+      }
+      final = 0;
+    }
+    else if (dmalloc_errno != ERROR_NOT_START_BLOCK) {
+      if (! silent_b) {
+	(void)printf("   ERROR: free inside of block should get ERROR_NOT_START_BLOCK not: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    dmalloc_errno = ERROR_NONE;
+    if (dmalloc_free(__FILE__, __LINE__, pnt,
+		     DMALLOC_FUNC_FREE) != FREE_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: free of block failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    dmalloc_errno = ERROR_NONE;
+    if (dmalloc_verify_pnt(__FILE__, __LINE__, "test", inside_p,
+			   1 /* exact */, 0) == DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: check of pointer inside of freed block should have failed\n");
+      }
+      final = 0;
+    }
+    
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+
+  /*
+   * Make sure that realloc grows whole-block allocations into the
+   * free blocks above them without moving them.
+   */
+  {
+    int		errno_hold = dmalloc_errno;
+    int		size = BLOCK_SIZE * 2, pnt_c, adjacent_b;
+    char	*next_p, *new_p;
+    unsigned int old_flags = dmalloc_debug_current();
+    
+    if (! silent_b) {
+      (void)printf("  Checking realloc growing in place\n");
+    }
+    
+    /* we need the blocks to be reused and sized exactly */
+    dmalloc_debug(old_flags & ~(DEBUG_NEVER_REUSE | DEBUG_REALLOC_COPY |
+				DEBUG_CHECK_FENCE));
+    
+    pnt = malloc(size);
+    next_p = malloc(size * 2);
+    if (pnt == NULL || next_p == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", size);
+      }
+      return 0;
+    }
+    adjacent_b = (next_p == (char *)pnt + size);
+    for (pnt_c = 0; pnt_c < size; pnt_c++) {
+      ((char *)pnt)[pnt_c] = (char)pnt_c;
+    }
+    free(next_p);
+    
+    /* push it off of the wait list */
+    for (pnt_c = 0; pnt_c < FREED_POINTER_DELAY + 1; pnt_c++) {
+      free(malloc(10));
+    }
+    
+    new_p = realloc(pnt, size * 3);
+    if (new_p == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not realloc %d bytes.\n", size * 3);
+      }
+      return 0;
+    }
+    if (adjacent_b && new_p != pnt) {
+      if (! silent_b) {
+	(void)printf("   ERROR: realloc moved %#lx to %#lx instead of growing.\n",
+		     (unsigned long)pnt, (unsigned long)new_p);
+      }
+      final = 0;
+    }
+    for (pnt_c = 0; pnt_c < size; pnt_c++) {
+      if (new_p[pnt_c] != (char)pnt_c) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: realloc lost byte %d of the pointer.\n",
+		       pnt_c);
+	}
+	final = 0;
+	break;
+      }
+    }
+    /* the new space should be usable */
+    memset(new_p + size, 'x', size * 2);
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: heap check after growing failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    free(new_p);
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+
+  /*
+   * Test strndup.
+   */
+  {
+    int		errno_hold = dmalloc_errno;
+    int		size = 5;
+    char	*str, *ret;
+    unsigned int old_flags = dmalloc_debug_current();
+  
+    if (! silent_b) {
+      (void)printf("  Checking strndup\n");
+    }
+    
+    dmalloc_debug(old_flags | DEBUG_CHECK_FUNCS);
+    
+    pnt = malloc(size);
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", size);
+      }
+      return 0;
+    }
+    str = "1234";
+    memmove(pnt, str, size);
+    
+    dmalloc_errno = ERROR_NONE;
+    ret = strndup(pnt, size);
+    
+    if (dmalloc_errno != ERROR_NONE) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    } else if (strcmp(pnt, str) != 0) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup should have copied string\n");
+      }
+      final = 0;
+    }
+    
+    dmalloc_errno = ERROR_NONE;
+    ret = strndup(pnt, size + 1);
+    
+    if (dmalloc_errno != ERROR_NONE) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    } else if (strcmp(pnt, str) != 0) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup should have copied string\n");
+      }
+      final = 0;
+    }
+    
+    str = "12345";
+    memmove(pnt, str, size);
+    
+    dmalloc_errno = ERROR_NONE;
+    strndup(pnt, size);
+    
+    if (dmalloc_errno != ERROR_NONE) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup shouldn't produce error: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    } else if (memcmp(pnt, str, size) != 0) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup should have copied string\n");
+      }
+      final = 0;
+    }
+
+    dmalloc_errno = ERROR_NONE;
+    strndup(pnt, size + 1);
+    
+    if (dmalloc_errno != ERROR_WOULD_OVERWRITE) {
+      if (! silent_b) {
+	(void)printf("   ERROR: strndup should produce overwrite error not: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = errno_hold;
+  }
+  
+  /********************/
+  
+  /* check all of the arg check routines */
+  if (! check_arg_check()) {
+    final = 0;
+  }
+  
+  /********************/
+  
+  dmalloc_message("NOTE: ignore the errors from the above ----- to here.\n");
+  dmalloc_message("-------------------------------------------------------\n");
+  
+  /*
+   * The following errors whould not generate a dmalloc_errno nor any
+   * error messages
+   */
+  
+  /********************/
+  
+  /*
+   * Make sure that realloc of NULL pointers either works or doesn't
+   * depending on the proper ALLOW_REALLOC_NULL setting.
+   */
+  
+  {
+    if (! silent_b) {
+      (void)printf("  Trying to realloc a 0L pointer.\n");
+    }
+    pnt = realloc(NULL, 10);
+#if ALLOW_REALLOC_NULL
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: re-allocation of 0L returned error.\n");
+      }
+      final = 0;
+    }
+    else {
+      free(pnt);
     }
 #else
     if (pnt == NULL) {
@@ -2977,6 +3709,115 @@ static	int	check_special(void)
   
   /********************/
   
+  /*
+   * Make sure that memalign returns aligned memory for alignments
+   * less than a page with and without fence posts.
+   */
+  
+  {
+    int			iter_c, amount, alignment, fence_c;
+    unsigned int	old_flags = dmalloc_debug_current();
+    
+    if (! silent_b) {
+      (void)printf("  Testing memalign()\n");
+    }
+    
+    for (fence_c = 0; fence_c < 2; fence_c++) {
+      if (fence_c == 0) {
+	dmalloc_debug(old_flags & ~DEBUG_CHECK_FENCE);
+      }
+      else {
+	dmalloc_debug(old_flags | DEBUG_CHECK_FENCE);
+      }
+      
+      for (iter_c = 0; iter_c < 20; iter_c++) {
+	alignment = 16 << (_dmalloc_rand() % 8);
+	if (alignment >= page_size) {
+	  alignment = page_size / 2;
+	}
+	do {
+	  amount = _dmalloc_rand() % (alignment * 3);
+	} while (amount == 0);
+	pnt = memalign(alignment, amount);
+	if (pnt == NULL) {
+	  if (! silent_b) {
+	    (void)printf("   ERROR: could not memalign %d bytes.\n", amount);
+	  }
+	  final = 0;
+	  continue;
+	}
+	if ((unsigned long)pnt % alignment != 0) {
+	  if (! silent_b) {
+	    (void)printf("   ERROR: memalign got %lx which is not %d aligned.\n",
+			 (unsigned long)pnt, alignment);
+	  }
+	  final = 0;
+	}
+	memset(pnt, 'x', amount);
+	if (dmalloc_verify_pnt(__FILE__, __LINE__, "test", pnt,
+			       1 /* exact */, amount) != DMALLOC_NOERROR) {
+	  if (! silent_b) {
+	    (void)printf("   ERROR: check of memalign pointer failed: %s (err %d)\n",
+			 dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+	  }
+	  final = 0;
+	}
+	free(pnt);
+      }
+    }
+    
+    /* posix_memalign should reject alignments that are not a power of 2 */
+    if (posix_memalign(&pnt, sizeof(void *) * 3, 10) != EINVAL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: posix_memalign did not reject bad alignment.\n");
+      }
+      final = 0;
+    }
+    /* nor hand back less than a larger alignment than we can do */
+    if (posix_memalign(&pnt, BLOCK_SIZE * 2, 10) != EINVAL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: posix_memalign did not reject %d alignment.\n",
+		     BLOCK_SIZE * 2);
+      }
+      final = 0;
+    }
+    errno = 0;
+    if (aligned_alloc(sizeof(void *) * 3, 10) != NULL || errno != EINVAL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: aligned_alloc did not reject bad alignment.\n");
+      }
+      final = 0;
+    }
+    errno = 0;
+    if (aligned_alloc(BLOCK_SIZE * 2, 10) != NULL || errno != EINVAL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: aligned_alloc did not reject %d alignment.\n",
+		     BLOCK_SIZE * 2);
+      }
+      final = 0;
+    }
+    if (posix_memalign(&pnt, 64, 10) != 0) {
+      if (! silent_b) {
+	(void)printf("   ERROR: posix_memalign of 64 byte alignment failed.\n");
+      }
+      final = 0;
+    }
+    else {
+      if ((unsigned long)pnt % 64 != 0) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: posix_memalign got %lx which is not 64 aligned.\n",
+		       (unsigned long)pnt);
+	}
+	final = 0;
+      }
+      free(pnt);
+    }
+    
+    dmalloc_debug(old_flags);
+  }
+  
+  /********************/
+  
   /*
    * Make sure that the blanking flags actually blank all of the
    * allocated pointer space.
@@ -3112,6 +3953,102 @@ static	int	check_special(void)
   
   /********************/
   
+  /*
+   * Make sure that with only the pointer tracking enabled the pointers
+   * are still recorded and that fence-posts are used with the very
+   * next allocation once they are turned on.
+   */
+  
+  {
+    unsigned int	old_flags, plain_flags, loc_line, ex_line;
+    DMALLOC_SIZE	ex_user_size;
+    char		*ex_file, save_ch;
+    int			byte_c;
+    
+    if (! silent_b) {
+      (void)printf("  Checking tracking with no pointer debugging\n");
+    }
+    
+    old_flags = dmalloc_debug_current();
+    plain_flags = old_flags & ~(DEBUG_CHECK_FENCE | DEBUG_GUARD_PAGES
+				| DEBUG_CHECK_BLANK | DEBUG_ALLOC_BLANK
+				| DEBUG_FREE_BLANK | DEBUG_PROTECT_FREE
+				| DEBUG_NEVER_REUSE | DEBUG_LOG_TRANS
+				| DEBUG_LOG_ELAPSED_TIME
+				| DEBUG_LOG_CURRENT_TIME);
+    dmalloc_debug(plain_flags);
+    
+    pnt = calloc(BLOCK_SIZE / 4, 1); loc_line = __LINE__;
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not calloc %d bytes.\n", BLOCK_SIZE / 4);
+      }
+      final = 0;
+    }
+    else {
+      for (byte_c = 0; byte_c < BLOCK_SIZE / 4; byte_c++) {
+	if (((char *)pnt)[byte_c] != '\0') {
+	  if (! silent_b) {
+	    (void)printf("   ERROR: calloc memory not zeroed at %d.\n", byte_c);
+	  }
+	  final = 0;
+	  break;
+	}
+      }
+      if (dmalloc_examine(pnt, &ex_user_size, NULL /* no total-size */,
+			  &ex_file, &ex_line, NULL /* no return address */,
+			  NULL /* no mark */, NULL /* no seen */)
+	  != DMALLOC_NOERROR
+	  || ex_user_size != BLOCK_SIZE / 4
+	  || ex_file == NULL
+	  || strcmp(ex_file, __FILE__) != 0
+	  || ex_line != loc_line) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: tracked pointer info invalid.\n");
+	}
+	final = 0;
+      }
+      if (dmalloc_free(__FILE__, __LINE__, pnt,
+		       DMALLOC_FUNC_FREE) != FREE_NOERROR) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: free of tracked pointer failed: %s (err %d)\n",
+		       dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+	}
+	final = 0;
+      }
+    }
+    
+    /* the next allocation should have fence-posts */
+    dmalloc_debug(plain_flags | DEBUG_CHECK_FENCE);
+    
+    pnt = malloc(BLOCK_SIZE / 4);
+    if (pnt == NULL) {
+      if (! silent_b) {
+	(void)printf("   ERROR: could not malloc %d bytes.\n", BLOCK_SIZE / 4);
+      }
+      final = 0;
+    }
+    else {
+      save_ch = *((char *)pnt + BLOCK_SIZE / 4);
+      *((char *)pnt + BLOCK_SIZE / 4) = '\0';
+      if (dmalloc_free(__FILE__, __LINE__, pnt,
+		       DMALLOC_FUNC_FREE) != FREE_ERROR
+	  || dmalloc_errno != ERROR_OVER_FENCE) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: fence-post overwrite not seen after flags changed.\n");
+	}
+	final = 0;
+      }
+      *((char *)pnt + BLOCK_SIZE / 4) = save_ch;
+      free(pnt);
+    }
+    
+    dmalloc_debug(old_flags);
+    dmalloc_errno = ERROR_NONE;
+  }
+  
+  /********************/
+  
   /*
    * Make sure realloc copy works right.
    */
@@ -3175,6 +4112,142 @@ static	int	check_special(void)
 
   /********************/
   
+#if PROTECT_ALLOWED
+  /*
+   * Make sure that guarded allocations end right at their guard page
+   * and stay that way when they are reallocated.
+   */
+  {
+    char		*new_pnt;
+    unsigned int	amount, old_flags;
+    unsigned long	end;
+    int			iter_c;
+    
+    if (! silent_b) {
+      (void)printf("  Checking guard-pages token\n");
+    }
+    
+    old_flags = dmalloc_debug_current();
+    dmalloc_debug(old_flags | DEBUG_GUARD_PAGES);
+    
+    for (iter_c = 0; iter_c < 20; iter_c++) {
+      amount = _dmalloc_rand() % (page_size * 3) + 1;
+      new_pnt = malloc(amount);
+      if (new_pnt == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not allocate %d bytes.\n", amount);
+	}
+	final = 0;
+	continue;
+      }
+      
+      /* every other one gets moved to a new size */
+      if (iter_c % 2 == 1) {
+	amount = _dmalloc_rand() % (page_size * 3) + 1;
+	new_pnt = realloc(new_pnt, amount);
+	if (new_pnt == NULL) {
+	  if (! silent_b) {
+	    (void)printf("   ERROR: could not reallocate %d bytes.\n",
+			 amount);
+	  }
+	  final = 0;
+	  continue;
+	}
+      }
+      
+      /* the allocation is only rounded up to the normal alignment */
+      end = (unsigned long)new_pnt + (amount + ALLOCATION_ALIGNMENT - 1) /
+	ALLOCATION_ALIGNMENT * ALLOCATION_ALIGNMENT;
+      if (end % page_size != 0) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: guarded pointer %lx does not end at a page.\n",
+		       (unsigned long)new_pnt);
+	}
+	final = 0;
+      }
+      
+      /* we should be able to write all of it */
+      memset(new_pnt, 0, amount);
+      
+      if (dmalloc_free(__FILE__, __LINE__, new_pnt,
+		       DMALLOC_FUNC_FREE) != FREE_NOERROR) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: free bad pointer produced: %s (err %d)\n",
+		       dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+	}
+	final = 0;
+      }
+    }
+    
+    dmalloc_debug(old_flags);
+  }
+#endif
+  
+  /********************/
+  
+#if PROTECT_ALLOWED
+  /*
+   * Make sure that the heap can still be checked with freed memory
+   * made no-access and that the memory can be used again afterwards.
+   */
+  {
+    char		*pnts[20];
+    unsigned int	amount, old_flags;
+    int			iter_c;
+    
+    if (! silent_b) {
+      (void)printf("  Checking protect-free token\n");
+    }
+    
+    old_flags = dmalloc_debug_current();
+    dmalloc_debug(old_flags | DEBUG_PROTECT_FREE | DEBUG_FREE_BLANK
+		  | DEBUG_CHECK_BLANK);
+    
+    for (iter_c = 0; iter_c < 20; iter_c++) {
+      amount = page_size * (_dmalloc_rand() % 3 + 2);
+      pnts[iter_c] = malloc(amount);
+      if (pnts[iter_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not allocate %d bytes.\n", amount);
+	}
+	final = 0;
+      }
+    }
+    for (iter_c = 0; iter_c < 20; iter_c++) {
+      free(pnts[iter_c]);
+    }
+    
+    if (dmalloc_verify(NULL /* check all heap */) != DMALLOC_NOERROR) {
+      if (! silent_b) {
+	(void)printf("   ERROR: verify with protected memory failed: %s (err %d)\n",
+		     dmalloc_strerror(dmalloc_errno), dmalloc_errno);
+      }
+      final = 0;
+    }
+    
+    /* push the freed pointers through the wait list and write to them */
+    for (iter_c = 0; iter_c < 20; iter_c++) {
+      amount = page_size * (_dmalloc_rand() % 3 + 2);
+      pnts[iter_c] = malloc(amount);
+      if (pnts[iter_c] == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not allocate %d bytes.\n", amount);
+	}
+	final = 0;
+	continue;
+      }
+      memset(pnts[iter_c], 0, amount);
+    }
+    for (iter_c = 0; iter_c < 20; iter_c++) {
+      free(pnts[iter_c]);
+    }
+    
+    dmalloc_debug(old_flags);
+  }
+#endif
+  
+  /********************/
+  
   /*
    * Make sure that the dmalloc function checking allows external
    * pointers.
@@ -3284,6 +4357,50 @@ static	int	check_special(void)
   
   /********************/
   
+  /*
+   * Make sure that calloc clears blocks that have been used before
+   * and does not just trust them to be zeros like new ones.
+   */
+  {
+    unsigned char	*ucp, *bounds_p;
+    int			iter_c, size = page_size * 4;
+    
+    if (! silent_b) {
+      (void)printf("  Checking calloc of used blocks\n");
+    }
+    
+    /* go around enough times for the freed blocks to be used again */
+    for (iter_c = 0; iter_c < 50; iter_c++) {
+      pnt = calloc(size, 1);
+      if (pnt == NULL) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: could not calloc %d bytes.\n", size);
+	}
+	final = 0;
+	break;
+      }
+      bounds_p = (unsigned char *)pnt + size;
+      for (ucp = pnt; ucp < bounds_p; ucp++) {
+	if (*ucp != '\0') {
+	  break;
+	}
+      }
+      if (ucp < bounds_p) {
+	if (! silent_b) {
+	  (void)printf("   ERROR: calloc byte %ld was not zeroed on pass %d.\n",
+		       (long)(ucp - (unsigned char *)pnt), iter_c);
+	}
+	final = 0;
+	free(pnt);
+	break;
+      }
+      memset(pnt, 0xff, size);
+      free(pnt);
+    }
+  }
+  
+  /********************/
+  
   /*
    * Verify that the check-funcs work with check-fence.  Thanks to
    * John Hetherington for reporting this.
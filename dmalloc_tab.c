@@ -36,118 +36,24 @@
 #include "conf.h"
 #include "chunk.h"
 #include "compat.h"
+#include "debug_tok.h"
 #include "dmalloc.h"
 #include "dmalloc_loc.h"
+#include "error.h"
 
 #include "dmalloc_tab.h"
 #include "dmalloc_tab_loc.h"
 
-/*
- * static unsigned int hash
- *
- * DESCRIPTION:
- *
- * Hash a variable-length key into a 32-bit value.  Every bit of the
- * key affects every bit of the return value.  Every 1-bit and 2-bit
- * delta achieves avalanche.  About (6 * len + 35) instructions.  The
- * best hash table sizes are powers of 2.  There is no need to use mod
- * (sooo slow!).  If you need less than 32 bits, use a bitmask.  For
- * example, if you need only 10 bits, do h = (h & hashmask(10)); In
- * which case, the hash table should have hashsize(10) elements.
- *
- * By Bob Jenkins, 1996.  You may use this code any way you wish,
- * private, educational, or commercial.  It's free.  See
- * http://ourworld.compuserve.com/homepages/bob_jenkins/evahash.htm
- * Use for hash table lookup, or anything where one collision in 2^^32
- * is acceptable.  Do NOT use for cryptographic purposes.
- *
- * RETURNS:
- *
- * Returns a 32-bit hash value.
- *
- * ARGUMENTS:
- *
- * key -> Key (the unaligned variable-length array of bytes) that we
- * are hashing.
- *
- * length -> Length of the key in bytes.
- *
- * init_val -> Initialization value of the hash if you need to hash a
- * number of strings together.  For instance, if you are hashing N
- * strings (unsigned char **)keys, do it like this:
- *
- * for (i=0, h=0; i<N; ++i) h = hash( keys[i], len[i], h);
- */
-static	unsigned int	hash(const unsigned char *key,
-			     const unsigned int length,
-			     const unsigned int init_val)
-{
-  const unsigned char	*key_p = key;
-  unsigned int		a, b, c, len;
-  
-  /* set up the internal state */
-  a = 0x9e3779b9;	/* the golden ratio; an arbitrary value */
-  b = 0x9e3779b9;
-  c = init_val;		/* the previous hash value */
-  
-  /* handle most of the key */
-  for (len = length; len >= 12; len -= 12) {
-    a += (key_p[0]
-	  + ((unsigned int)key_p[1] << 8)
-	  + ((unsigned int)key_p[2] << 16)
-	  + ((unsigned int)key_p[3] << 24));
-    b += (key_p[4]
-	  + ((unsigned int)key_p[5] << 8)
-	  + ((unsigned int)key_p[6] << 16)
-	  + ((unsigned int)key_p[7] << 24));
-    c += (key_p[8]
-	  + ((unsigned int)key_p[9] << 8)
-	  + ((unsigned int)key_p[10] << 16)
-	  + ((unsigned int)key_p[11] << 24));
-    HASH_MIX(a,b,c);
-    key_p += 12;
-  }
-  
-  c += length;
-  
-  /* all the case statements fall through to the next */
-  switch(len) {
-  case 11:
-    c += ((unsigned int)key_p[10] << 24);
-  case 10:
-    c += ((unsigned int)key_p[9] << 16);
-  case 9:
-    c += ((unsigned int)key_p[8] << 8);
-    /* the first byte of c is reserved for the length */
-  case 8:
-    b += ((unsigned int)key_p[7] << 24);
-  case 7:
-    b += ((unsigned int)key_p[6] << 16);
-  case 6:
-    b += ((unsigned int)key_p[5] << 8);
-  case 5:
-    b += key_p[4];
-  case 4:
-    a += ((unsigned int)key_p[3] << 24);
-  case 3:
-    a += ((unsigned int)key_p[2] << 16);
-  case 2:
-    a += ((unsigned int)key_p[1] << 8);
-  case 1:
-    a += key_p[0];
-    /* case 0: nothing left to add */
-  }
-  HASH_MIX(a, b, c);
-  
-  return c;
-}
-
 /*
  * static unsigned int which_bucket
  *
  * DESCRIPTION:
  *
- * Determine the bucket with our file/line and hash function.
+ * Determine the bucket with our file/line and hash function.  The
+ * file is either a return-address or a file-name string which the
+ * compiler hands us at the same address every time so we hash the
+ * pointer and not the characters.  Matching file-names at different
+ * addresses are merged when the table is logged.
  *
  * RETURNS:
  *
@@ -164,24 +70,16 @@ static	unsigned int	hash(const unsigned char *key,
 static	unsigned int	which_bucket(const int entry_n, const char *file,
 				     const unsigned int line)
 {
-  unsigned int	bucket;
+  unsigned long	addr = (unsigned long)file;
+  unsigned int	a, b, c;
   
-  if (line == 0) {
-    if (file == NULL) {
-      bucket = 0;
-    }
-    else {
-      /* we hash on the address in file -- should be a return-address */
-      bucket = hash((unsigned char *)&file, sizeof(char *), 0);
-    }
-  }
-  else {
-    bucket = hash((unsigned char *)file, strlen(file), 0);
-    bucket = hash((unsigned char *)&line, sizeof(line), bucket);
-  }
+  a = 0x9e3779b9 + (unsigned int)addr;	/* the golden ratio */
+  /* the high bits of 64-bit pointers in two steps to stay portable */
+  b = 0x9e3779b9 + (unsigned int)((addr >> 16) >> 16);
+  c = line;
+  HASH_MIX(a, b, c);
   
-  bucket %= entry_n;
-  return bucket;
+  return c % entry_n;
 }
 
 /*
@@ -207,16 +105,16 @@ static	int	entry_cmp(const void *entry1_p, const void *entry2_p)
   unsigned long		size1, size2;
   const mem_entry_t	*tab1_p = entry1_p, *tab2_p = entry2_p;
   
-  /* if the entry is blank then force the size to be 0 */
-  if (tab1_p->me_file == NULL) {
+  /* if the entry is blank or merged into another then force the size to be 0 */
+  if (tab1_p->me_file == NULL || tab1_p->me_merge_p != NULL) {
     size1 = 0;
   }
   else {
     size1 = tab1_p->me_total_size;
   }
   
-  /* if the entry is blank then force the size to be 0 */
-  if (tab2_p->me_file == NULL) {
+  /* if the entry is blank or merged into another then force the size to be 0 */
+  if (tab2_p->me_file == NULL || tab2_p->me_merge_p != NULL) {
     size2 = 0;
   }
   else {
@@ -235,6 +133,63 @@ static	int	entry_cmp(const void *entry1_p, const void *entry2_p)
   }
 }
 
+/*
+ * static int entry_name_cmp
+ *
+ * DESCRIPTION:
+ *
+ * Compare two entries in the memory table by their file-name and
+ * line-number so entries from the same place are next to each other
+ * after a sort.  Entries with return-addresses are ordered by address
+ * ahead of the others and the blank entries go at the end.
+ *
+ * RETURNS:
+ *
+ * -1, 0, or 1 depending if entry1_p is less-than, equal, or
+ * greater-than entry2_p.
+ *
+ * ARGUMENTS:
+ *
+ * entry1_p -> Pointer to the 1st entry.
+ *
+ * entry2_p -> Pointer to the 2nd entry.
+ */
+static	int	entry_name_cmp(const void *entry1_p, const void *entry2_p)
+{
+  const mem_entry_t	*tab1_p = entry1_p, *tab2_p = entry2_p;
+  int			ret;
+  
+  if (tab1_p->me_file == NULL || tab2_p->me_file == NULL) {
+    if (tab1_p->me_file == tab2_p->me_file) {
+      return 0;
+    }
+    return (tab1_p->me_file == NULL ? 1 : -1);
+  }
+  
+  if (tab1_p->me_line == 0 || tab2_p->me_line == 0) {
+    if (tab1_p->me_line != 0) {
+      return 1;
+    }
+    if (tab2_p->me_line != 0) {
+      return -1;
+    }
+    if (tab1_p->me_file == tab2_p->me_file) {
+      return 0;
+    }
+    return ((unsigned long)tab1_p->me_file < (unsigned long)tab2_p->me_file
+	    ? -1 : 1);
+  }
+  
+  ret = strcmp(tab1_p->me_file, tab2_p->me_file);
+  if (ret != 0) {
+    return (ret < 0 ? -1 : 1);
+  }
+  if (tab1_p->me_line == tab2_p->me_line) {
+    return 0;
+  }
+  return (tab1_p->me_line < tab2_p->me_line ? -1 : 1);
+}
+
 /*
  * static void swap_bytes
  *
@@ -289,10 +244,12 @@ static	void	swap_bytes(unsigned char *item1_p, unsigned char *item2_p,
  * holder_p <-> Location of hold area we can store an entry.
  *
  * ele_size -> Size of the each element in the list.
+ *
+ * compare -> Function which compares two of the elements.
  */
 static	void	insert_sort(unsigned char *first_p, unsigned char *last_p,
 			    unsigned char *holder_p,
-			    const unsigned int ele_size)
+			    const unsigned int ele_size, compare_t compare)
 {
   unsigned char	*inner_p, *outer_p;
   
@@ -300,7 +257,7 @@ static	void	insert_sort(unsigned char *first_p, unsigned char *last_p,
     
     /* look for the place to insert the entry */
     for (inner_p = outer_p - ele_size;
-	 inner_p >= first_p && entry_cmp(outer_p, inner_p) < 0;
+	 inner_p >= first_p && compare(outer_p, inner_p) < 0;
 	 inner_p -= ele_size) {
     }
     inner_p += ele_size;
@@ -339,9 +296,11 @@ static	void	insert_sort(unsigned char *first_p, unsigned char *last_p,
  * last_p -> Last entry in the list that we are splitting.
  *
  * ele_size -> Size of the each element in the list.
+ *
+ * compare -> Function which compares two of the elements.
  */
 static	void	split(unsigned char *first_p, unsigned char *last_p,
-		      const unsigned int ele_size)
+		      const unsigned int ele_size, compare_t compare)
 {
   unsigned char	*left_p, *right_p, *pivot_p, *left_last_p, *right_first_p;
   unsigned char	*firsts[MAX_QSORT_SPLITS], *lasts[MAX_QSORT_SPLITS];
@@ -363,12 +322,12 @@ static	void	split(unsigned char *first_p, unsigned char *last_p,
      * Find which of the left, middle, and right elements is the
      * median (Knuth vol3 p123).
      */
-    if (entry_cmp(first_p, pivot_p) > 0) {
+    if (compare(first_p, pivot_p) > 0) {
       swap_bytes(first_p, pivot_p, ele_size);
     }
-    if (entry_cmp(pivot_p, last_p) > 0) {
+    if (compare(pivot_p, last_p) > 0) {
       swap_bytes(pivot_p, last_p, ele_size);
-      if (entry_cmp(first_p, pivot_p) > 0) {
+      if (compare(first_p, pivot_p) > 0) {
 	swap_bytes(first_p, pivot_p, ele_size);
       }
     }
@@ -382,11 +341,11 @@ static	void	split(unsigned char *first_p, unsigned char *last_p,
     do {
       
       /* shift the left side up until we reach the pivot value */
-      while (entry_cmp(left_p, &pivot) < 0) {
+      while (compare(left_p, &pivot) < 0) {
 	left_p += ele_size;
       }
       /* shift the right side down until we reach the pivot value */
-      while (entry_cmp(&pivot, right_p) < 0) {
+      while (compare(&pivot, right_p) < 0) {
 	right_p -= ele_size;
       }
       
@@ -419,13 +378,15 @@ static	void	split(unsigned char *first_p, unsigned char *last_p,
     if (size1 < min_qsort_size) {
       
       /* use the pivot as our temporary space */
-      insert_sort(first_p, left_last_p, (unsigned char *)&pivot, ele_size);
+      insert_sort(first_p, left_last_p, (unsigned char *)&pivot, ele_size,
+		  compare);
       
       /* is the 2nd part small as well? */
       if (size2 < min_qsort_size) {
 	
 	/* use the pivot as our temporary space */
-	insert_sort(right_first_p, last_p, (unsigned char *)&pivot, ele_size);
+	insert_sort(right_first_p, last_p, (unsigned char *)&pivot, ele_size,
+		    compare);
 	
 	/* pop a partition off our stack */
 	if (split_c == 0) {
@@ -445,7 +406,8 @@ static	void	split(unsigned char *first_p, unsigned char *last_p,
     else if (size2 < min_qsort_size) {
       
       /* use the pivot as our temporary space */
-      insert_sort(right_first_p, last_p, (unsigned char *)&pivot, ele_size);
+      insert_sort(right_first_p, last_p, (unsigned char *)&pivot, ele_size,
+		  compare);
       
       /* we can just handle the left side immediately */
       /* first_p = first_p */
@@ -500,18 +462,25 @@ static	void	split(unsigned char *first_p, unsigned char *last_p,
  * in_use_column_b -> Display the in-use numbers in a column.
  *
  * source -> Source description string.
+ *
+ * scale -> Multiply the numbers by this to estimate them from a
+ * sample.  Set to 1 to display them as they are.
  */
 static	void	log_entry(const mem_entry_t *entry_p,
-			  const int in_use_column_b, const char *source)
+			  const int in_use_column_b, const char *source,
+			  const unsigned long scale)
 {
   if (in_use_column_b) {
     dmalloc_message("%11lu %6lu %11lu %6lu  %s\n",
-		    entry_p->me_total_size, entry_p->me_total_c,
-		    entry_p->me_in_use_size, entry_p->me_in_use_c, source);
+		    entry_p->me_total_size * scale,
+		    entry_p->me_total_c * scale,
+		    entry_p->me_in_use_size * scale,
+		    entry_p->me_in_use_c * scale, source);
   }
   else {
     dmalloc_message("%11lu %6lu  %s\n",
-		     entry_p->me_total_size, entry_p->me_total_c, source);
+		    entry_p->me_total_size * scale,
+		    entry_p->me_total_c * scale, source);
   }
 }
 
@@ -541,6 +510,75 @@ static	void	add_entry(mem_entry_t *total_p, const mem_entry_t *entry_p)
   total_p->me_in_use_c += entry_p->me_in_use_c;
 }
 
+/*
+ * static void sub_entry
+ *
+ * DESCRIPTION:
+ *
+ * Take a memory entry back out of the one that it was added into.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * total_p <-> Pointer to the memory table entry it was added into.
+ *
+ * entry_p -> Pointer to the memory table entry we are taking out.
+ */
+static	void	sub_entry(mem_entry_t *total_p, const mem_entry_t *entry_p)
+{
+  total_p->me_total_size -= entry_p->me_total_size;
+  total_p->me_total_c -= entry_p->me_total_c;
+  total_p->me_in_use_size -= entry_p->me_in_use_size;
+  total_p->me_in_use_c -= entry_p->me_in_use_c;
+}
+
+/*
+ * static void merge_entries
+ *
+ * DESCRIPTION:
+ *
+ * The same file-name can be at different addresses if it is used in
+ * more than one object.  Sort the entries by name and add the ones
+ * with the same file-name and line-number into the first of them so
+ * they are logged together.  The others point at where the first one
+ * belongs so they can be taken back out of it once we are done.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * mem_table <-> Memory table whose entries we are merging.
+ */
+static	void	merge_entries(mem_table_t *mem_table)
+{
+  mem_entry_t	*entry_p, *first_p = NULL;
+  
+  split((unsigned char *)mem_table->mt_entries,
+	(unsigned char *)(mem_table->mt_bounds_p - 1),
+	sizeof(*mem_table->mt_entries), entry_name_cmp);
+  
+  for (entry_p = mem_table->mt_entries;
+       entry_p < mem_table->mt_bounds_p && entry_p->me_file != NULL;
+       entry_p++) {
+    /* return-addresses are only ever at one address */
+    if (entry_p->me_line == 0) {
+      continue;
+    }
+    if (first_p != NULL && entry_name_cmp(first_p, entry_p) == 0) {
+      add_entry(first_p, entry_p);
+      entry_p->me_merge_p = first_p->me_entry_pos_p;
+    }
+    else {
+      first_p = entry_p;
+    }
+  }
+}
+
 /*
  * void _dmalloc_table_init
  *
@@ -574,11 +612,12 @@ void	_dmalloc_table_init(mem_table_t *mem_table, mem_entry_t *mem_entries,
 }
 
 /*
- * static mem_entry_t *table_find
+ * void _dmalloc_table_clear
  *
  * DESCRIPTION:
  *
- * Find an extry in the table.
+ * Clear out the allocation information in our table but keep the
+ * entries that it has grown into.
  *
  * RETURNS:
  *
@@ -587,6 +626,36 @@ void	_dmalloc_table_init(mem_table_t *mem_table, mem_entry_t *mem_entries,
  * ARGUMENTS:
  *
  * mem_table -> Memory table we are working on.
+ */
+void	_dmalloc_table_clear(mem_table_t *mem_table)
+{
+  memset(mem_table->mt_entries, 0,
+	 sizeof(*mem_table->mt_entries) * mem_table->mt_entry_n);
+  memset(&mem_table->mt_other_pointers, 0,
+	 sizeof(mem_table->mt_other_pointers));
+  mem_table->mt_in_use_c = 0;
+}
+
+/*
+ * static mem_entry_t *table_find
+ *
+ * DESCRIPTION:
+ *
+ * Find an extry in the table.  We only look at TABLE_PROBE_MAX
+ * entries from the bucket so the table has to be grown if a new
+ * file/line does not find a blank entry in that many.
+ *
+ * RETURNS:
+ *
+ * Success - The entry of the file/line or the blank entry where it
+ * should go.
+ *
+ * Failure - NULL if it is not in the first TABLE_PROBE_MAX entries
+ * and none of them are blank.
+ *
+ * ARGUMENTS:
+ *
+ * mem_table -> Memory table we are working on.
  *
  * old_file -> File name or return address of the allocation to
  * delete.
@@ -598,15 +667,15 @@ static mem_entry_t	*table_find(mem_table_t *mem_table,
 				    const unsigned int old_line)
 {
   unsigned int	bucket;
-  mem_entry_t	*entry_p, *tab_end_p;
+  mem_entry_t	*entry_p;
+  int		probe_c;
   
   bucket = which_bucket(mem_table->mt_entry_n, old_file, old_line);
   entry_p = mem_table->mt_entries + bucket;
   
-  /* the end is if we come around to the start again */
-  tab_end_p = entry_p;
-  
-  do {
+  for (probe_c = 0;
+       probe_c < TABLE_PROBE_MAX && probe_c < mem_table->mt_entry_n;
+       probe_c++) {
     if (entry_p->me_file == old_file && entry_p->me_line == old_line) {
       return entry_p;
     }
@@ -618,9 +687,69 @@ static mem_entry_t	*table_find(mem_table_t *mem_table,
     if (entry_p == mem_table->mt_bounds_p) {
       entry_p = mem_table->mt_entries;
     }
-  } while (entry_p != tab_end_p);
+  }
   
-  return &mem_table->mt_other_pointers;
+  return NULL;
+}
+
+/*
+ * static int table_grow
+ *
+ * DESCRIPTION:
+ *
+ * Move the entries of a table into administrative space with twice as
+ * many entries.  The space comes from the heap and never from the
+ * user's allocations.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0 if we could not get the space.  The table is unchanged.
+ *
+ * ARGUMENTS:
+ *
+ * mem_table <-> Memory table we are growing.
+ */
+static	int	table_grow(mem_table_t *mem_table)
+{
+  mem_entry_t	*entries, *bounds_p, *old_p, *entry_p;
+  int		entry_n;
+  
+  entry_n = mem_table->mt_entry_n * 2;
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("growing memory table to %d entries", entry_n);
+  }
+  
+  entries = _dmalloc_chunk_admin_alloc(entry_n * sizeof(*entries));
+  if (entries == NULL) {
+    /* error code set in _dmalloc_chunk_admin_alloc */
+    return 0;
+  }
+  bounds_p = entries + entry_n;
+  
+  /* put the entries in their new buckets, they come to us blank */
+  for (old_p = mem_table->mt_entries; old_p < mem_table->mt_bounds_p; old_p++) {
+    if (old_p->me_file == NULL) {
+      continue;
+    }
+    entry_p = entries + which_bucket(entry_n, old_p->me_file, old_p->me_line);
+    while (entry_p->me_file != NULL) {
+      entry_p++;
+      if (entry_p == bounds_p) {
+	entry_p = entries;
+      }
+    }
+    *entry_p = *old_p;
+    entry_p->me_entry_pos_p = entry_p;
+  }
+  
+  mem_table->mt_entries = entries;
+  mem_table->mt_entry_n = entry_n;
+  mem_table->mt_bounds_p = bounds_p;
+  
+  return 1;
 }
 
 /*
@@ -650,16 +779,25 @@ void	_dmalloc_table_insert(mem_table_t *mem_table,
 {
   mem_entry_t	*entry_p;
   
-  entry_p = table_find(mem_table, file, line);
-  if (entry_p->me_file == NULL
-      && mem_table->mt_in_use_c > mem_table->mt_entry_n / 2) {
-    /* do we have too many entries in the table?  then put in other bucket. */
-    entry_p = &mem_table->mt_other_pointers;
-  } else if (entry_p != &mem_table->mt_other_pointers) {
-    /* we found an open slot so update the file/line */
-    entry_p->me_file = file;
-    entry_p->me_line = line;
-    mem_table->mt_in_use_c++;
+  while (1) {
+    entry_p = table_find(mem_table, file, line);
+    if (entry_p != NULL && entry_p->me_file != NULL) {
+      break;
+    }
+    if (entry_p != NULL
+	&& mem_table->mt_in_use_c <= mem_table->mt_entry_n / 2) {
+      /* we found an open slot so update the file/line */
+      entry_p->me_file = file;
+      entry_p->me_line = line;
+      mem_table->mt_in_use_c++;
+      break;
+    }
+    /* the table is too full or too crowded around the bucket */
+    if (! table_grow(mem_table)) {
+      /* we only use the other bucket if we run out of memory */
+      entry_p = &mem_table->mt_other_pointers;
+      break;
+    }
   }
   
   /* update the info for the entry */
@@ -699,7 +837,7 @@ void	_dmalloc_table_delete(mem_table_t *mem_table, const char *old_file,
   mem_entry_t	*entry_p;
   
   entry_p = table_find(mem_table, old_file, old_line);
-  if (entry_p->me_file == NULL) {
+  if (entry_p == NULL || entry_p->me_file == NULL) {
     /* if we didn't find it, account for it in the other_pointers?? */
     entry_p = &mem_table->mt_other_pointers;
   }
@@ -729,9 +867,14 @@ void	_dmalloc_table_delete(mem_table_t *mem_table, const char *old_file,
  * display all entries in the table.
  *
  * in_use_column_b -> Display the in-use numbers in a column.
+ *
+ * scale -> If the table holds 1 in this many allocations then its
+ * numbers are multiplied by this to estimate the totals.  Set to 1 if
+ * the table holds all of them.
  */
 void	_dmalloc_table_log_info(mem_table_t *mem_table, const int log_n,
-				const int in_use_column_b)
+				const int in_use_column_b,
+				const unsigned long scale)
 {
   mem_entry_t	*entry_p, total;
   int		entry_c;
@@ -743,10 +886,12 @@ void	_dmalloc_table_log_info(mem_table_t *mem_table, const int log_n,
     return;
   }
   
+  merge_entries(mem_table);
+  
   /* sort the entries by their total-size */
   split((unsigned char *)mem_table->mt_entries,
 	(unsigned char *)(mem_table->mt_bounds_p - 1),
-	sizeof(*mem_table->mt_entries));
+	sizeof(*mem_table->mt_entries), entry_cmp);
   
   /* display the column headers */  
   if (in_use_column_b) {
@@ -756,33 +901,37 @@ void	_dmalloc_table_log_info(mem_table_t *mem_table, const int log_n,
     dmalloc_message(" total-size  count  source");
   }
   
+  if (scale > 1) {
+    dmalloc_message(" estimated from 1 in %lu allocations", scale);
+  }
+  
   memset(&total, 0, sizeof(total));
   
   entry_c = 0;
   for (entry_p = mem_table->mt_entries;
        entry_p < mem_table->mt_bounds_p;
        entry_p++) {
-    if (entry_p->me_file != NULL) {
+    if (entry_p->me_file != NULL && entry_p->me_merge_p == NULL) {
       entry_c++;
       /* can we still print the pointer information? */
       if (log_n == 0 || entry_c < log_n) {
 	(void)_dmalloc_chunk_desc_pnt(source, sizeof(source),
 				      entry_p->me_file, entry_p->me_line);
-	log_entry(entry_p, in_use_column_b, source);
+	log_entry(entry_p, in_use_column_b, source, scale);
       }
       add_entry(&total, entry_p);
     }
   }
-  if (mem_table->mt_in_use_c >= MEMORY_TABLE_SIZE) {
+  if (mem_table->mt_other_pointers.me_total_c > 0) {
     strncpy(source, "Other pointers", sizeof(source));
     source[sizeof(source) - 1] = '\0';
-    log_entry(&mem_table->mt_other_pointers, in_use_column_b, source);
+    log_entry(&mem_table->mt_other_pointers, in_use_column_b, source, scale);
     add_entry(&total, &mem_table->mt_other_pointers);
   }
   
   /* dump our total */
   (void)loc_snprintf(source, sizeof(source), "Total of %d", entry_c);
-  log_entry(&total, in_use_column_b, source);
+  log_entry(&total, in_use_column_b, source, scale);
   
   /*
    * If we sorted the array, we have to put it back the way it was if
@@ -806,5 +955,14 @@ void	_dmalloc_table_log_info(mem_table_t *mem_table, const int log_n,
     swap_entry = *entry_p->me_entry_pos_p;
     *entry_p->me_entry_pos_p = *entry_p;
     *entry_p = swap_entry;
+  }  
+  /* now take the merged entries back out of the ones they were added to */
+  for (entry_p = mem_table->mt_entries;
+       entry_p < mem_table->mt_bounds_p;
+       entry_p++) {
+    if (entry_p->me_merge_p != NULL) {
+      sub_entry(entry_p->me_merge_p, entry_p);
+      entry_p->me_merge_p = NULL;
+    }
   }
 }
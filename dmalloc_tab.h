@@ -32,6 +32,8 @@ typedef struct mem_entry_st {
   unsigned long		me_in_use_c;		/* pointers currently in use */
   /* we use this so we can easily un-sort the list */
   struct mem_entry_st	*me_entry_pos_p;	/* pos of entry in table */
+  /* entry with the same file-name we were added to while logging */
+  struct mem_entry_st	*me_merge_p;		/* merged entry's position */
 } mem_entry_t;
 
 /* memory table */
@@ -70,6 +72,25 @@ extern
 void	_dmalloc_table_init(mem_table_t *mem_table, mem_entry_t *mem_entries,
 			    const int mem_entries_byte_size);
 
+/*
+ * void _dmalloc_table_clear
+ *
+ * DESCRIPTION:
+ *
+ * Clear out the allocation information in our table but keep the
+ * entries that it has grown into.
+ *
+ * RETURNS:
+ *
+ * None.
+ *
+ * ARGUMENTS:
+ *
+ * mem_table -> Memory table we are working on.
+ */
+extern
+void	_dmalloc_table_clear(mem_table_t *mem_table);
+
 /*
  * void _dmalloc_table_insert
  *
@@ -144,10 +165,15 @@ void	_dmalloc_table_delete(mem_table_t *mem_table, const char *old_file,
  * display all entries in the table.
  *
  * in_use_column_b -> Display the in-use numbers in a column.
+ *
+ * scale -> If the table holds 1 in this many allocations then its
+ * numbers are multiplied by this to estimate the totals.  Set to 1 if
+ * the table holds all of them.
  */
 extern
 void	_dmalloc_table_log_info(mem_table_t *mem_table, const int log_n,
-				const int in_use_column_b);
+				const int in_use_column_b,
+				const unsigned long scale);
 
 /*<<<<<<<<<<   This is end of the auto-generated output from fillproto. */
 
@@ -38,6 +38,12 @@
  */
 #define MAX_QSORT_PARTITION	8
 
+/*
+ * Most entries that we look at to find the place for a file/line.  If
+ * we have to look further then the table is made larger.
+ */
+#define TABLE_PROBE_MAX		32
+
 /* comparison function */
 typedef int	(*compare_t)(const void *element1_p, const void *element2_p);
 
@@ -40,6 +40,20 @@ extern "C" {
 #include "return.h"
 }
 
+#if __cplusplus >= 201703L
+#include <new>				/* for std::align_val_t */
+
+/* we can align up to the block-size -- see BASIC_BLOCK in conf.h */
+#define ALIGN_MAX	((size_t)1 << BASIC_BLOCK)
+#endif
+
+/* the standard delete operators are declared not to throw since C++11 */
+#if __cplusplus >= 201103L
+#define DELETE_NOEXCEPT	noexcept
+#else
+#define DELETE_NOEXCEPT
+#endif
+
 /*
  * An overload function for the C++ new.
  */
@@ -68,7 +82,7 @@ operator new[](size_t size)
  * An overload function for the C++ delete.
  */
 void
-operator delete(void *pnt)
+operator delete(void *pnt) DELETE_NOEXCEPT
 {
   char	*file;
   GET_RET_ADDR(file);
@@ -79,9 +93,69 @@ operator delete(void *pnt)
  * An overload function for the C++ delete[].  Thanks to Jens Krinke.
  */
 void
-operator delete[](void *pnt)
+operator delete[](void *pnt) DELETE_NOEXCEPT
 {
   char	*file;
   GET_RET_ADDR(file);
   dmalloc_free(file, 0, pnt, DMALLOC_FUNC_DELETE_ARRAY);
 }
+
+#if __cplusplus >= 201703L
+
+/*
+ * An overload function for the C++17 new of over-aligned types.  We
+ * cannot hand back less alignment than was asked for.
+ */
+void *
+operator new(size_t size, std::align_val_t alignment)
+{
+  char	*file;
+  if (static_cast<size_t>(alignment) > ALIGN_MAX) {
+    throw std::bad_alloc();
+  }
+  GET_RET_ADDR(file);
+  return dmalloc_malloc(file, 0, size, DMALLOC_FUNC_NEW,
+			static_cast<size_t>(alignment),
+			0 /* no xalloc messages */);
+}
+
+/*
+ * An overload function for the C++17 new[] of over-aligned types.  We
+ * cannot hand back less alignment than was asked for.
+ */
+void *
+operator new[](size_t size, std::align_val_t alignment)
+{
+  char	*file;
+  if (static_cast<size_t>(alignment) > ALIGN_MAX) {
+    throw std::bad_alloc();
+  }
+  GET_RET_ADDR(file);
+  return dmalloc_malloc(file, 0, size, DMALLOC_FUNC_NEW_ARRAY,
+			static_cast<size_t>(alignment),
+			0 /* no xalloc messages */);
+}
+
+/*
+ * An overload function for the C++17 delete of over-aligned types.
+ */
+void
+operator delete(void *pnt, std::align_val_t) DELETE_NOEXCEPT
+{
+  char	*file;
+  GET_RET_ADDR(file);
+  dmalloc_free(file, 0, pnt, DMALLOC_FUNC_DELETE);
+}
+
+/*
+ * An overload function for the C++17 delete[] of over-aligned types.
+ */
+void
+operator delete[](void *pnt, std::align_val_t) DELETE_NOEXCEPT
+{
+  char	*file;
+  GET_RET_ADDR(file);
+  dmalloc_free(file, 0, pnt, DMALLOC_FUNC_DELETE_ARRAY);
+}
+
+#endif /* __cplusplus >= 201703L */
@@ -58,12 +58,22 @@
 #define LOGFILE_LABEL		"log"
 #define START_LABEL		"start"
 #define LIMIT_LABEL		"limit"
+#define RESERVE_LABEL		"reserve"
+#define SAMPLE_LABEL		"sample-rate"
+#define GUARD_LABEL		"guard"
+#define QUARANTINE_LABEL	"quarantine"
+#define QUARANTINE_COUNT_LABEL	"quarantine-count"
+#define BUDGET_LABEL		"check-budget"
+#define VERIFY_LABEL		"verify-period"
+#define CHECK_THREADS_LABEL	"check-threads"
 
 #define ASSIGNMENT_CHAR		'='
 
 /* local variables */
 static	char		log_path[512]	= { '\0' }; /* storage for env path */
 static	char		start_file[512] = { '\0' }; /* file to start at */
+static	char		guard_all[512]	= { '\0' }; /* storage for guard */
+static	char		guard_file[512] = { '\0' }; /* file to guard */
 
 /****************************** local utilities ******************************/
 
@@ -159,6 +169,46 @@ void	_dmalloc_start_break(char *start_all, char **start_file_p,
   }
 }
 
+/*
+ * Break up GUARD_STR into GFILE_P and GLINE_P or into the size range
+ * GMIN_P to GMAX_P
+ */
+void	_dmalloc_guard_break(const char *guard_str, char **guard_file_p,
+			     int *guard_line_p, unsigned long *guard_min_p,
+			     unsigned long *guard_max_p)
+{
+  char	*guard_p;
+  
+  SET_POINTER(guard_file_p, NULL);
+  SET_POINTER(guard_line_p, 0);
+  SET_POINTER(guard_min_p, 0);
+  SET_POINTER(guard_max_p, 0);
+  
+  if (guard_str == NULL) {
+    return;
+  }
+  
+  guard_p = strchr(guard_str, ':');
+  if (guard_p != NULL) {
+    (void)strncpy(guard_file, guard_str, sizeof(guard_file));
+    guard_file[sizeof(guard_file) - 1] = '\0';
+    SET_POINTER(guard_file_p, guard_file);
+    guard_p = guard_file + (guard_p - guard_str);
+    *guard_p = '\0';
+    SET_POINTER(guard_line_p, atoi(guard_p + 1));
+  }
+  else if (guard_str[0] == 's') {
+    SET_POINTER(guard_min_p, loc_atoul(guard_str + 1));
+    guard_p = strchr(guard_str, '-');
+    if (guard_p == NULL) {
+      SET_POINTER(guard_max_p, loc_atoul(guard_str + 1));
+    }
+    else {
+      SET_POINTER(guard_max_p, loc_atoul(guard_p + 1));
+    }
+  }
+}
+
 /*
  * Process the values of dmalloc environ variable(s) from ENVIRON
  * string.
@@ -171,7 +221,13 @@ void	_dmalloc_environ_process(const char *env_str, DMALLOC_PNT *addr_p,
 				 int *start_line_p,
 				 unsigned long *start_iter_p,
 				 unsigned long *start_size_p,
-				 unsigned long *limit_p)
+				 unsigned long *limit_p,
+				 unsigned long *reserve_p,
+				 unsigned long *sample_p, char **guard_p,
+				 unsigned long *quarantine_p,
+				 unsigned long *quarantine_count_p,
+				 unsigned long *budget_p, unsigned long *verify_p,
+				 unsigned long *check_threads_p)
 {
   char		*env_p, *this_p;
   char		buf[1024];
@@ -190,6 +246,14 @@ void	_dmalloc_environ_process(const char *env_str, DMALLOC_PNT *addr_p,
   SET_POINTER(start_iter_p, 0);
   SET_POINTER(start_size_p, 0);
   SET_POINTER(limit_p, 0);
+  SET_POINTER(reserve_p, 0);
+  SET_POINTER(sample_p, 0);
+  SET_POINTER(guard_p, NULL);
+  SET_POINTER(quarantine_p, 0);
+  SET_POINTER(quarantine_count_p, 0);
+  SET_POINTER(budget_p, 0);
+  SET_POINTER(verify_p, 0);
+  SET_POINTER(check_threads_p, 0);
   
   /* make a copy */
   (void)strncpy(buf, env_str, sizeof(buf));
@@ -282,6 +346,80 @@ void	_dmalloc_environ_process(const char *env_str, DMALLOC_PNT *addr_p,
       continue;
     }
     
+    /* set the size of the heap address space reservations */
+    len = strlen(RESERVE_LABEL);
+    if (strncmp(this_p, RESERVE_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(reserve_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* fully check only 1 in this many allocations */
+    len = strlen(SAMPLE_LABEL);
+    if (strncmp(this_p, SAMPLE_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(sample_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* end the allocations from a file:line or of a size at a guard page */
+    len = strlen(GUARD_LABEL);
+    if (strncmp(this_p, GUARD_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      (void)strncpy(guard_all, this_p, sizeof(guard_all));
+      guard_all[sizeof(guard_all) - 1] = '\0';
+      SET_POINTER(guard_p, guard_all);
+      continue;
+    }
+    
+    /* hold on to this many bytes of freed memory before reusing it */
+    len = strlen(QUARANTINE_LABEL);
+    if (strncmp(this_p, QUARANTINE_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(quarantine_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* hold on to this many freed pointers before reusing them */
+    len = strlen(QUARANTINE_COUNT_LABEL);
+    if (strncmp(this_p, QUARANTINE_COUNT_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(quarantine_count_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* check only this many blocks of the heap at a time */
+    len = strlen(BUDGET_LABEL);
+    if (strncmp(this_p, BUDGET_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(budget_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* milliseconds between the verify thread's heap checks */
+    len = strlen(VERIFY_LABEL);
+    if (strncmp(this_p, VERIFY_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(verify_p, loc_atoul(this_p));
+      continue;
+    }
+    
+    /* split the full heap check between threads */
+    len = strlen(CHECK_THREADS_LABEL);
+    if (strncmp(this_p, CHECK_THREADS_LABEL, len) == 0
+	&& *(this_p + len) == ASSIGNMENT_CHAR) {
+      this_p += len + 1;
+      SET_POINTER(check_threads_p, loc_atoul(this_p));
+      continue;
+    }
+    
     /* need to check the short/long debug options */
     for (attr_p = attributes; attr_p->at_string != NULL; attr_p++) {
       if (strcmp(this_p, attr_p->at_string) == 0) {
@@ -319,7 +457,15 @@ void	_dmalloc_environ_set(char *buf, const int buf_size,
 			     const int start_line,
 			     const unsigned long start_iter,
 			     const unsigned long start_size,
-			     const unsigned long limit_val)
+			     const unsigned long limit_val,
+			     const unsigned long reserve_val,
+			     const unsigned long sample_val,
+			     const char *guard_str,
+			     const unsigned long quarantine_val,
+			     const unsigned long quarantine_count,
+			     const unsigned long budget_val,
+			     const unsigned long verify_val,
+			     const unsigned long check_threads)
 {
   char	*buf_p = buf, *bounds_p = buf + buf_size;
   
@@ -387,6 +533,39 @@ void	_dmalloc_environ_set(char *buf, const int buf_size,
     buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
 			  LIMIT_LABEL, ASSIGNMENT_CHAR, limit_val);
   }
+  if (reserve_val > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  RESERVE_LABEL, ASSIGNMENT_CHAR, reserve_val);
+  }
+  if (sample_val > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  SAMPLE_LABEL, ASSIGNMENT_CHAR, sample_val);
+  }
+  if (guard_str != NULL) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%s,",
+			  GUARD_LABEL, ASSIGNMENT_CHAR, guard_str);
+  }
+  if (quarantine_val > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  QUARANTINE_LABEL, ASSIGNMENT_CHAR, quarantine_val);
+  }
+  if (quarantine_count > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  QUARANTINE_COUNT_LABEL, ASSIGNMENT_CHAR,
+			  quarantine_count);
+  }
+  if (budget_val > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  BUDGET_LABEL, ASSIGNMENT_CHAR, budget_val);
+  }
+  if (verify_val > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  VERIFY_LABEL, ASSIGNMENT_CHAR, verify_val);
+  }
+  if (check_threads > 0) {
+    buf_p += loc_snprintf(buf_p, bounds_p - buf_p, "%s%c%lu,",
+			  CHECK_THREADS_LABEL, ASSIGNMENT_CHAR, check_threads);
+  }
   
   /* cut off the last comma */
   if (buf_p > buf) {
@@ -39,6 +39,15 @@ void	_dmalloc_start_break(char *start_all, char **start_file_p,
 			     int *start_line_p, unsigned long *start_iter_p,
 			     unsigned long *start_size_p);
 
+/*
+ * Break up GUARD_STR into GFILE_P and GLINE_P or into the size range
+ * GMIN_P to GMAX_P
+ */
+extern
+void	_dmalloc_guard_break(const char *guard_str, char **guard_file_p,
+			     int *guard_line_p, unsigned long *guard_min_p,
+			     unsigned long *guard_max_p);
+
 /*
  * Process the values of dmalloc environ variable(s) from ENVIRON
  * string.
@@ -52,7 +61,13 @@ void	_dmalloc_environ_process(const char *env_str, DMALLOC_PNT *addr_p,
 				 int *start_line_p,
 				 unsigned long *start_iter_p,
 				 unsigned long *start_size_p,
-				 unsigned long *limit_p);
+				 unsigned long *limit_p,
+				 unsigned long *reserve_p,
+				 unsigned long *sample_p, char **guard_p,
+				 unsigned long *quarantine_p,
+				 unsigned long *quarantine_count_p,
+				 unsigned long *budget_p, unsigned long *verify_p,
+				 unsigned long *check_threads_p);
 
 /*
  * Set dmalloc environ variable(s) with the values (maybe SHORT debug
@@ -69,7 +84,15 @@ void	_dmalloc_environ_set(char *buf, const int buf_size,
 			     const int start_line,
 			     const unsigned long start_iter,
 			     const unsigned long start_size,
-			     const unsigned long limit_val);
+			     const unsigned long limit_val,
+			     const unsigned long reserve_val,
+			     const unsigned long sample_val,
+			     const char *guard_str,
+			     const unsigned long quarantine_val,
+			     const unsigned long quarantine_count,
+			     const unsigned long budget_val,
+			     const unsigned long verify_val,
+			     const unsigned long check_threads);
 
 /*<<<<<<<<<<   This is end of the auto-generated output from fillproto. */
 
@@ -116,7 +116,7 @@ TIME_TYPE	_dmalloc_start = 0;
 #endif
 #endif
 
-/* when we are going to startup our locking subsystem */
+/* old lock-on setting, now only used to see if threads are configured */
 int		_dmalloc_lock_on = 0;
 
 /* global flag which indicates when we are aborting */
@@ -293,8 +293,7 @@ void	_dmalloc_open_log(void)
 		  _dmalloc_check_interval, (unsigned long)_dmalloc_address,
 		  _dmalloc_address_seen_n, _dmalloc_memory_limit);
 #if LOCK_THREADS
-  dmalloc_message("threads enabled, lock-on = %d, lock-init = %d",
-		  _dmalloc_lock_on, THREAD_INIT_LOCK);
+  dmalloc_message("threads enabled");
 #endif
     
 #if LOG_PNT_TIMEVAL
@@ -76,7 +76,7 @@ TIME_TYPE	_dmalloc_start;
 #endif /* if HAVE_TIME */
 #endif /* if LOG_PNT_TIMEVAL == 0 */
 
-/* when we are going to startup our locking subsystem */
+/* old lock-on setting, now only used to see if threads are configured */
 extern
 int		_dmalloc_lock_on;
 
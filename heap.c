@@ -24,6 +24,9 @@
  * heap as well as reporting the current position of the heap.
  */
 
+/* for mremap and its flags on linux */
+#define _GNU_SOURCE
+
 #if HAVE_UNISTD_H
 # include <unistd.h>				/* for write */
 #endif
@@ -52,9 +55,135 @@
 /* exported variables */
 void		*_dmalloc_heap_low = NULL;	/* base of our heap */
 void		*_dmalloc_heap_high = NULL;	/* end of our heap */
+unsigned long	_dmalloc_heap_reserve = 0;	/* reservation size setting */
+unsigned long	_dmalloc_heap_reserved = 0;	/* address space reserved */
+unsigned long	_dmalloc_heap_committed = 0;	/* reserved space usable */
+
+#if HAVE_MMAP && USE_MMAP && MAP_ANON && HEAP_RESERVE_SIZE > 0
+#define HEAP_RESERVE_OKAY	1
+
+/* the address space reservation that we are carving blocks out of */
+static	char	*reserve_next = NULL;		/* next byte to hand out */
+static	char	*reserve_commit = NULL;		/* end of the usable space */
+static	char	*reserve_end = NULL;		/* end of the reservation */
+#else
+#define HEAP_RESERVE_OKAY	0
+#endif
+
+/* can we move and grow the allocations which have their own mappings? */
+#if INTERNAL_MEMORY_SPACE == 0 && HAVE_MMAP && USE_MMAP && MAP_ANON \
+	&& defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+#define HEAP_REMAP_OKAY		1
+#else
+#define HEAP_REMAP_OKAY		0
+#endif
 
 /****************************** local functions ******************************/
 
+#if HEAP_RESERVE_OKAY
+/*
+ * static unsigned long reserve_size
+ *
+ * DESCRIPTION:
+ *
+ * Get the size of our address space reservations from the reserve
+ * token or the default, rounded up to the commit size.
+ *
+ * RETURNS:
+ *
+ * Size of the reservations in bytes.
+ *
+ * ARGUMENTS:
+ *
+ * None.
+ */
+static	unsigned long	reserve_size(void)
+{
+  unsigned long	size;
+  
+  if (_dmalloc_heap_reserve > 0) {
+    size = _dmalloc_heap_reserve;
+  }
+  else {
+    size = HEAP_RESERVE_SIZE;
+  }
+  
+  return (size + HEAP_COMMIT_SIZE - 1) / HEAP_COMMIT_SIZE * HEAP_COMMIT_SIZE;
+}
+
+/*
+ * static void *heap_carve
+ *
+ * DESCRIPTION:
+ *
+ * Carve bytes out of our reserved address space.  A new range is
+ * reserved if the current one is used up and the reserved space is
+ * made usable HEAP_COMMIT_SIZE bytes at a time.
+ *
+ * RETURNS:
+ *
+ * Success - Block aligned pointer.
+ *
+ * Failure - SBRK_ERROR
+ *
+ * ARGUMENTS:
+ *
+ * incr -> Number of bytes we need.
+ */
+static	void	*heap_carve(const int incr)
+{
+  char		*ret;
+  unsigned long	size, need, commit_size;
+  
+  /* we need a new reservation if the current one is used up */
+  if (reserve_next == NULL || incr > reserve_end - reserve_next) {
+    size = reserve_size();
+    /* reserve an extra block so we can align the start */
+    ret = mmap(0L, size + BLOCK_SIZE, PROT_NONE,
+#ifdef MAP_NORESERVE
+	       MAP_PRIVATE | MAP_ANON | MAP_NORESERVE,
+#else
+	       MAP_PRIVATE | MAP_ANON,
+#endif
+	       -1 /* no fd */, 0 /* no offset */);
+    if (ret == MAP_FAILED) {
+      return SBRK_ERROR;
+    }
+    _dmalloc_heap_reserved += size + BLOCK_SIZE;
+    
+    reserve_next = ret + (BLOCK_SIZE - (long)ret % BLOCK_SIZE) % BLOCK_SIZE;
+    reserve_commit = reserve_next;
+    reserve_end = reserve_next + size;
+    
+    if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+      dmalloc_message("reserved heap space of %lu bytes at %#lx",
+		      size, (unsigned long)reserve_next);
+    }
+  }
+  
+  /* make more of the reservation usable if we need to */
+  if (reserve_next + incr > reserve_commit) {
+    need = reserve_next + incr - reserve_commit;
+    commit_size = (need + HEAP_COMMIT_SIZE - 1) / HEAP_COMMIT_SIZE *
+      HEAP_COMMIT_SIZE;
+    if (commit_size > (unsigned long)(reserve_end - reserve_commit)) {
+      commit_size = reserve_end - reserve_commit;
+    }
+    if (mprotect(reserve_commit, commit_size,
+		 PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+      return SBRK_ERROR;
+    }
+    reserve_commit += commit_size;
+    _dmalloc_heap_committed += commit_size;
+  }
+  
+  ret = reserve_next;
+  reserve_next += incr;
+  
+  return ret;
+}
+#endif /* if HEAP_RESERVE_OKAY */
+
 /*
  * static void *heap_extend
  *
@@ -93,6 +222,13 @@ static	void	*heap_extend(const int incr)
   }
 #else
 #if HAVE_MMAP && USE_MMAP
+#if HEAP_RESERVE_OKAY
+  /* carve block multiples out of our reservations unless they are big */
+  if (incr % BLOCK_SIZE == 0 && (unsigned long)incr <= reserve_size() / 2) {
+    ret = heap_carve(incr);
+  }
+  else
+#endif
 #if MAP_ANON
   /* if we have and can use mmap, then do so */
   ret = mmap(0L, incr, PROT_READ | PROT_WRITE | PROT_EXEC,
@@ -235,3 +371,99 @@ void	*_dmalloc_heap_alloc(const unsigned int size)
   
   return heap_new;
 }
+
+/*
+ * int _dmalloc_heap_mapped
+ *
+ * DESCRIPTION:
+ *
+ * Tell whether an allocation of a size from _dmalloc_heap_alloc gets
+ * a mapping of its own which _dmalloc_heap_remap can grow.
+ *
+ * RETURNS:
+ *
+ * 1 if it does otherwise 0.
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes in the allocation.
+ */
+int	_dmalloc_heap_mapped(const unsigned int size)
+{
+#if HEAP_REMAP_OKAY
+#if HEAP_RESERVE_OKAY
+  /* see heap_extend */
+  if (size % BLOCK_SIZE == 0 && (unsigned long)size <= reserve_size() / 2) {
+    return 0;
+  }
+#endif
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/*
+ * void *_dmalloc_heap_remap
+ *
+ * DESCRIPTION:
+ *
+ * Grow an allocation which has its own mapping by asking the system
+ * to remap it.  The system may move the pages somewhere else in which
+ * case the old memory is no longer valid.
+ *
+ * RETURNS:
+ *
+ * Success - Block aligned pointer to the start of the allocation.
+ *
+ * Failure - HEAP_ALLOC_ERROR and the allocation is unchanged.  This
+ * does not set dmalloc_errno.
+ *
+ * ARGUMENTS:
+ *
+ * old_p -> Start of the mapping.
+ *
+ * old_size -> Number of bytes in the mapping.
+ *
+ * new_size -> Number of bytes we need.
+ */
+void	*_dmalloc_heap_remap(void *old_p, const unsigned int old_size,
+			     const unsigned int new_size)
+{
+#if HEAP_REMAP_OKAY
+  char	*ret, *high;
+  
+  ret = mremap(old_p, old_size, new_size, MREMAP_MAYMOVE);
+  if (ret == MAP_FAILED) {
+    return HEAP_ALLOC_ERROR;
+  }
+  
+  if ((long)ret % BLOCK_SIZE != 0) {
+    /* we can only use block aligned memory so put it back */
+    if (mremap(ret, new_size, old_size, MREMAP_MAYMOVE | MREMAP_FIXED,
+	       old_p) == MAP_FAILED) {
+      dmalloc_errno = ERROR_ALLOC_FAILED;
+      dmalloc_error("_dmalloc_heap_remap");
+    }
+    return HEAP_ALLOC_ERROR;
+  }
+  
+  if (ret < (char *)_dmalloc_heap_low) {
+    _dmalloc_heap_low = ret;
+  }
+  high = ret + new_size;
+  if (high > (char *)_dmalloc_heap_high) {
+    _dmalloc_heap_high = high;
+  }
+  
+  if (BIT_IS_SET(_dmalloc_flags, DEBUG_LOG_ADMIN)) {
+    dmalloc_message("remapped heap space from %#lx (%u bytes) to %#lx (%u bytes)",
+		    (unsigned long)old_p, old_size, (unsigned long)ret,
+		    new_size);
+  }
+  
+  return ret;
+#else
+  return HEAP_ALLOC_ERROR;
+#endif
+}
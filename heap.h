@@ -29,6 +29,17 @@
  */
 #define HEAP_ALLOC_ERROR	0L
 
+/*
+ * The memory that we get from the system is new and reads as zeros
+ * if it was mapped or comes from our internal space.  We don't trust
+ * sbrk since someone else may have lowered the break after writing.
+ */
+#if INTERNAL_MEMORY_SPACE || (HAVE_MMAP && USE_MMAP)
+#define HEAP_ALLOC_ZEROS	1
+#else
+#define HEAP_ALLOC_ZEROS	0
+#endif
+
 /* test whether pointer PNT is in the heap space */
 #define IS_IN_HEAP(pnt)		\
   ((char *)(pnt) >= (char *)_dmalloc_heap_low \
@@ -42,6 +53,15 @@ void		*_dmalloc_heap_low;	/* base of our heap */
 extern
 void		*_dmalloc_heap_high;	/* end of our heap */
 
+extern
+unsigned long	_dmalloc_heap_reserve;	/* reservation size setting */
+
+extern
+unsigned long	_dmalloc_heap_reserved;	/* address space reserved */
+
+extern
+unsigned long	_dmalloc_heap_committed;	/* reserved space usable */
+
 /*
  * int _heap_startup
  *
@@ -82,6 +102,53 @@ int	_dmalloc_heap_startup(void);
 extern
 void	*_dmalloc_heap_alloc(const unsigned int size);
 
+/*
+ * int _dmalloc_heap_mapped
+ *
+ * DESCRIPTION:
+ *
+ * Tell whether an allocation of a size from _dmalloc_heap_alloc gets
+ * a mapping of its own which _dmalloc_heap_remap can grow.
+ *
+ * RETURNS:
+ *
+ * 1 if it does otherwise 0.
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes in the allocation.
+ */
+extern
+int	_dmalloc_heap_mapped(const unsigned int size);
+
+/*
+ * void *_dmalloc_heap_remap
+ *
+ * DESCRIPTION:
+ *
+ * Grow an allocation which has its own mapping by asking the system
+ * to remap it.  The system may move the pages somewhere else in which
+ * case the old memory is no longer valid.
+ *
+ * RETURNS:
+ *
+ * Success - Block aligned pointer to the start of the allocation.
+ *
+ * Failure - HEAP_ALLOC_ERROR and the allocation is unchanged.  This
+ * does not set dmalloc_errno.
+ *
+ * ARGUMENTS:
+ *
+ * old_p -> Start of the mapping.
+ *
+ * old_size -> Number of bytes in the mapping.
+ *
+ * new_size -> Number of bytes we need.
+ */
+extern
+void	*_dmalloc_heap_remap(void *old_p, const unsigned int old_size,
+			     const unsigned int new_size);
+
 /*<<<<<<<<<<   This is end of the auto-generated output from fillproto. */
 
 #endif /* ! __HEAP_H__ */
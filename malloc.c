@@ -25,6 +25,7 @@
  * chunk.c which is the real heap manager.
  */
 
+#include <errno.h>				/* for posix_memalign */
 #include <stdio.h>				/* for sprintf sometimes */
 #if HAVE_STDLIB_H
 # include <stdlib.h>				/* for atexit */
@@ -73,6 +74,7 @@
 #if HAVE_PTHREADS_H
 #include <pthreads.h>
 #endif
+#include <time.h>				/* for nanosleep */
 #endif
 
 #if SIGNAL_OKAY && HAVE_SIGNAL_H
@@ -112,7 +114,14 @@ char		*dmalloc_logpath = NULL;
 
 /* local variables */
 static	int		enabled_b = 0;		/* have we started yet? */
+#if LOCK_THREADS && defined(THREAD_LOCAL)
+/* can't be here twice but other threads can be */
+static	THREAD_LOCAL int	in_alloc_b = 0;
+/* starting up or locking so the threads library may call back in */
+static	THREAD_LOCAL int	in_start_b = 0;
+#else
 static	int		in_alloc_b = 0;		/* can't be here twice */
+#endif
 static	int		do_shutdown_b = 0;	/* execute shutdown soon */
 static	int		memalign_warn_b = 0;	/* memalign warning printed?*/
 static	dmalloc_track_t	tracking_func = NULL;	/* memory trxn tracking func */
@@ -122,27 +131,78 @@ static	char		*start_file = NULL;	/* file to start at */
 static	int		start_line = 0;		/* line to start */
 static	unsigned long	start_iter = 0;		/* start after X iterations */
 static	unsigned long	start_size = 0;		/* start after X bytes */
-static	int		thread_lock_c = 0;	/* lock counter */
+static	unsigned long	verify_period = 0;	/* ms between verify checks */
 
 /****************************** thread locking *******************************/
 
 #if LOCK_THREADS
 #ifdef THREAD_MUTEX_T
-/*
- * Define a global variable we use as a lock counter.
- *
- * NOTE: we do not use the PTHREAD_MUTEX_INITIALIZER since this
- * basically delays the pthread_mutex_init call to when
- * pthread_mutex_lock is called for the first time (at least on
- * freebsd).  Since we don't want to go recursive into the pthread
- * library when we go to lock our mutex variable, we want to force the
- * initialization to happen beforehand with a call to
- * pthread_mute_init.
- */
+#ifdef PTHREAD_MUTEX_INITIALIZER
+static THREAD_MUTEX_T dmalloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+#else
 static THREAD_MUTEX_T dmalloc_mutex;
+#endif
 #else
 #error We need to have THREAD_MUTEX_T defined by the configure script
 #endif
+
+/* run the startup only once no matter how many threads call in */
+static	pthread_once_t	startup_once = PTHREAD_ONCE_INIT;
+static	const char	*startup_str = NULL;	/* options for the startup */
+
+/*
+ * The bootstrap area that the threads library's allocations are
+ * handed out of while we are starting up or locking.  The union
+ * aligns it for any type.
+ */
+static	union {
+  char		bs_buf[THREAD_BOOTSTRAP_SIZE];
+  double	bs_align;
+  long		bs_long;
+  void		*bs_pnt;
+} bootstrap;
+static	unsigned long	bootstrap_used = 0;	/* bytes given out */
+
+static	int		verify_running_b = 0;	/* verify thread going? */
+static	int		verify_stop_b = 0;	/* library has shut down */
+
+/* is the pointer from the bootstrap area? */
+#define IS_BOOTSTRAP(pnt)	((char *)(pnt) >= bootstrap.bs_buf \
+				 && (char *)(pnt) < bootstrap.bs_buf \
+				 + THREAD_BOOTSTRAP_SIZE)
+
+#ifdef THREAD_LOCAL
+#define START_ENTER()		(in_start_b = 1)
+#define START_LEAVE()		(in_start_b = 0)
+#define IN_START()		(in_start_b)
+#define IN_ALLOC()		(in_alloc_b)
+#else
+/*
+ * Without per-thread variables we let one thread at a time into the
+ * startup sections and remember which one it is.  We also remember
+ * which thread holds the lock so we can tell a recursive call.
+ */
+static	THREAD_MUTEX_T	start_mutex = PTHREAD_MUTEX_INITIALIZER;
+static	volatile int	start_b = 0;		/* a thread is starting */
+static	pthread_t	start_thread;		/* the one starting */
+static	pthread_t	lock_thread_id;		/* the one with the lock */
+
+#define START_ENTER()		do { \
+				  pthread_mutex_lock(&start_mutex); \
+				  start_thread = pthread_self(); \
+				  start_b = 1; \
+				} while (0)
+#define START_LEAVE()		do { \
+				  start_b = 0; \
+				  pthread_mutex_unlock(&start_mutex); \
+				} while (0)
+#define IN_START()		(start_b \
+				 && pthread_equal(start_thread, \
+						  pthread_self()))
+#define IN_ALLOC()		(in_alloc_b \
+				 && pthread_equal(lock_thread_id, \
+						  pthread_self()))
+#endif
 #endif
 
 /*
@@ -153,31 +213,15 @@ static THREAD_MUTEX_T dmalloc_mutex;
  * a thread mutex variable.  The problem is that most thread libraries
  * uses malloc itself and do not like to go recursive.
  *
- * There are two places where we may have this problem.  One is when
- * we try to use our mutex-lock variable when pthreads is starting up
- * in a shaky state.  The thread library allocates some space, the
- * dmalloc library needs to lock its mutex variable so calls back into
- * the pthread library before it is ready for a call, and a core dump
- * is probably the result.
- *
- * We hopefully solve this by having the dmalloc library not lock
- * during the first couple of memory transactions.  The number is
- * controlled by lock-on dmalloc program environmental setting (set
- * with ``dmalloc -o X'').  You will have to play with the value.  Too
- * many will cause two threads to march into the dmalloc code at the
- * same time generating a ERROR_IN_TWICE error.  Too few and you will
- * get a core dump in the pthreads initialization code.
- *
- * The second place where we might go recursive is when we go to
- * actually initialize our mutex-lock before we can use it.  The
- * THREAD_INIT_LOCK variable (in settings.h) defines that the
- * initialization happens 2 memory transactions before the library
- * begins to use the mutex (lock-on - 2).  It we waited to initialize
- * the variable right before we used it, the pthread library might
- * want to allocate some memory for the variable causing a recursive
- * call and probably a seg-fault -- at least in OSF.  If people need
- * to have this variable also be runtime configurable or would like to
- * present an alternative default, please let me know.
+ * The mutex is initialized statically so there is nothing to set up
+ * before the first lock.  Each thread has its own in-alloc flag so a
+ * thread calling back into the library can be told apart from another
+ * thread that is waiting on the lock.  While a thread is starting up
+ * the library or taking the lock, any allocations that the threads or
+ * C library make from that thread are handed out of a small static
+ * bootstrap area instead of going recursive.  The startup itself is
+ * run once with pthread_once so the library is safe from the very
+ * first call.
  */
 
 #if LOCK_THREADS
@@ -186,12 +230,18 @@ static THREAD_MUTEX_T dmalloc_mutex;
  */
 static	void	lock_thread(void)
 {
-  /* we only lock if the lock-on counter has reached 0 */
-  if (thread_lock_c == 0) {
 #if HAVE_PTHREAD_MUTEX_LOCK
-    pthread_mutex_lock(&dmalloc_mutex);
+#ifdef THREAD_LOCAL
+  /* the first lock may have the threads library allocate */
+  START_ENTER();
+  pthread_mutex_lock(&dmalloc_mutex);
+  START_LEAVE();
+#else
+  /* the startup took the lock once so it is set up by now */
+  pthread_mutex_lock(&dmalloc_mutex);
+  lock_thread_id = pthread_self();
+#endif
 #endif
-  }
 }
 
 /*
@@ -199,36 +249,154 @@ static	void	lock_thread(void)
  */
 static	void	unlock_thread(void)
 {
-  /* if the lock-on counter has not reached 0 then count it down */
-  if (thread_lock_c > 0) {
-    thread_lock_c--;
-    /*
-     * As we approach the time when we start mutex locking the
-     * library, we need to init the mutex variable.  This sets how
-     * many times before we start locking should we init the variable
-     * taking in account that the init itself might generate a call
-     * into the library.  Ugh.
-     */
-    if (thread_lock_c == THREAD_INIT_LOCK) {
-#if HAVE_PTHREAD_MUTEX_INIT
-      /*
-       * NOTE: we do not use the PTHREAD_MUTEX_INITIALIZER since this
-       * basically delays the pthread_mutex_init call to when
-       * pthread_mutex_lock is called for the first time (at least on
-       * freebsd).  Since we don't want to go recursive into the
-       * pthread library when we go to lock our mutex variable, we
-       * want to force the initialization to happen beforehand with a
-       * call to pthread_mute_init.
-       */
-      pthread_mutex_init(&dmalloc_mutex, THREAD_LOCK_INIT_VAL);
+#if HAVE_PTHREAD_MUTEX_UNLOCK
+  pthread_mutex_unlock(&dmalloc_mutex);
+#endif
+}
+
+/*
+ * static void *bootstrap_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Hand out memory from the bootstrap area to a thread that called
+ * back into the library while it was starting up or locking.  The
+ * memory is zeroed and is never reused.
+ *
+ * RETURNS:
+ *
+ * Success - Pointer to the memory.
+ *
+ * Failure - NULL
+ *
+ * ARGUMENTS:
+ *
+ * size -> Number of bytes needed.
+ *
+ * alignment -> Alignment of the memory or 0 for the default.
+ */
+static	void	*bootstrap_alloc(const DMALLOC_SIZE size,
+				 const DMALLOC_SIZE alignment)
+{
+  unsigned long	used, start, align, base;
+  
+  align = ALLOCATION_ALIGNMENT;
+  if (alignment > align) {
+    align = alignment;
+  }
+  base = (unsigned long)bootstrap.bs_buf;
+  
+  /* the size of the pointer is kept in front of it for realloc */
+  do {
+    used = bootstrap_used;
+    start = base + used + sizeof(DMALLOC_SIZE);
+    start = (start + align - 1) / align * align - base;
+    if (start + size > THREAD_BOOTSTRAP_SIZE) {
+      dmalloc_errno = ERROR_ALLOC_FAILED;
+      return NULL;
+    }
+#ifdef THREAD_LOCAL
+  } while (! __sync_bool_compare_and_swap(&bootstrap_used, used,
+					  start + size));
+#else
+  } while (0);
+  /* only the one starting thread gets here */
+  bootstrap_used = start + size;
 #endif
+  
+  *(DMALLOC_SIZE *)(bootstrap.bs_buf + start - sizeof(DMALLOC_SIZE)) = size;
+  return bootstrap.bs_buf + start;
+}
+
+/*
+ * static void *verify_thread
+ *
+ * DESCRIPTION:
+ *
+ * Body of the verify thread.  Every verify-period milliseconds it
+ * takes the library lock like any other call and checks the heap so
+ * the threads that are allocating do not have to.  With the
+ * check-budget setting each pass only looks at part of the heap so
+ * the lock is not held for long.  The thread exits when the setting
+ * is cleared or the library shuts down.
+ *
+ * RETURNS:
+ *
+ * Always NULL.
+ *
+ * ARGUMENTS:
+ *
+ * arg -> Unused.
+ */
+static	void	*verify_thread(void *arg)
+{
+  struct timespec	pause;
+  unsigned long		period;
+  
+  (void)arg;
+  
+  while (1) {
+    period = verify_period;
+    pause.tv_sec = period / 1000;
+    pause.tv_nsec = (period % 1000) * 1000000;
+    (void)nanosleep(&pause, NULL);
+    
+    lock_thread();
+    if (verify_period == 0 || verify_stop_b || _dmalloc_aborting_b) {
+      verify_running_b = 0;
+      unlock_thread();
+      break;
+    }
+    
+    in_alloc_b = 1;
+    if (_dmalloc_check_budget > 0) {
+      (void)_dmalloc_chunk_heap_step();
+    }
+    else {
+      (void)_dmalloc_chunk_heap_check();
     }
+    in_alloc_b = 0;
+    
+    unlock_thread();
   }
-  else if (thread_lock_c == 0) {
-#if HAVE_PTHREAD_MUTEX_UNLOCK
-    pthread_mutex_unlock(&dmalloc_mutex);
+  
+  return NULL;
+}
+
+/*
+ * Start the verify thread if the verify-period setting asks for it
+ * and it is not already going.  Called without the library lock.
+ */
+static	void	verify_start(void)
+{
+  pthread_t	thread;
+  
+  if (verify_period == 0 || verify_running_b || verify_stop_b) {
+    return;
+  }
+#ifdef THREAD_LOCAL
+  if (! __sync_bool_compare_and_swap(&verify_running_b, 0, 1)) {
+    return;
+  }
+  
+  /* the threads library may allocate while making the thread */
+  START_ENTER();
+#else
+  /* the threads library may allocate while making the thread */
+  START_ENTER();
+  if (verify_running_b) {
+    START_LEAVE();
+    return;
+  }
+  verify_running_b = 1;
 #endif
+  if (pthread_create(&thread, NULL, verify_thread, NULL) == 0) {
+    (void)pthread_detach(thread);
   }
+  else {
+    verify_running_b = 0;
+  }
+  START_LEAVE();
 }
 #endif
 
@@ -271,6 +439,7 @@ static	void	process_environ(const char *option_str)
    * into problems
    */
   static char	options[1024];
+  char		*guard_str;
   
   /* process the options flag */
   if (option_str == NULL) {
@@ -285,8 +454,13 @@ static	void	process_environ(const char *option_str)
 			   (long *)&_dmalloc_address_seen_n, &_dmalloc_flags,
 			   &_dmalloc_check_interval, &_dmalloc_lock_on,
 			   &dmalloc_logpath, &start_file, &start_line,
-			   &start_iter, &start_size, &_dmalloc_memory_limit);
-  thread_lock_c = _dmalloc_lock_on;
+			   &start_iter, &start_size, &_dmalloc_memory_limit,
+			   &_dmalloc_heap_reserve, &_dmalloc_sample_rate,
+			   &guard_str, &_dmalloc_quarantine_size,
+			   &_dmalloc_quarantine_count, &_dmalloc_check_budget,
+			   &verify_period, &_dmalloc_check_threads);
+  _dmalloc_guard_break(guard_str, &_dmalloc_guard_file, &_dmalloc_guard_line,
+		       &_dmalloc_guard_min, &_dmalloc_guard_max);
   
   /* if we set the start stuff, then check-heap comes on later */
   if (start_iter > 0 || start_size > 0) {
@@ -327,7 +501,7 @@ static	RETSIGTYPE	signal_handler(const int sig)
 /*
  * startup the memory-allocation module
  */
-static	int	dmalloc_startup(const char *debug_str)
+static	int	startup_library(const char *debug_str)
 {
   static int	some_up_b = 0;
   const char	*env_str;
@@ -400,12 +574,6 @@ static	int	dmalloc_startup(const char *debug_str)
     }
   }
   
-#if LOCK_THREADS
-  if (thread_lock_c > 0) {
-    return 1;
-  }
-#endif
-  
   /*
    * We have initialized all of our code.
    *
@@ -416,7 +584,8 @@ static	int	dmalloc_startup(const char *debug_str)
   
   /*
    * NOTE: we may go recursive below here becasue atexit or on_exit
-   * may ask for memory to be allocated.  We won't worry about it and
+   * may ask for memory to be allocated.  With threads this comes out
+   * of the bootstrap area.  Otherwise we won't worry about it and
    * will just give it to them.  We hope that atexit didn't start the
    * allocating.  Ugh.
    */
@@ -457,6 +626,65 @@ static	int	dmalloc_startup(const char *debug_str)
   return 1;
 }
 
+#if LOCK_THREADS
+/*
+ * Called by pthread_once to start the library.
+ */
+static	void	startup_once_func(void)
+{
+#ifndef PTHREAD_MUTEX_INITIALIZER
+#if HAVE_PTHREAD_MUTEX_INIT
+  pthread_mutex_init(&dmalloc_mutex, THREAD_LOCK_INIT_VAL);
+#endif
+#endif
+#ifndef THREAD_LOCAL
+  /* take the lock once while the threads library may still allocate */
+  pthread_mutex_lock(&dmalloc_mutex);
+  pthread_mutex_unlock(&dmalloc_mutex);
+#endif
+  (void)startup_library(startup_str);
+}
+#endif
+
+/*
+ * static int dmalloc_startup
+ *
+ * DESCRIPTION:
+ *
+ * Start up the library if it has not been already.  With threads,
+ * only the first caller does the work and the others wait for it to
+ * finish.
+ *
+ * RETURNS:
+ *
+ * Success - 1 if the library is running.
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * debug_str -> Options string to use instead of the environment or
+ * NULL.
+ */
+static	int	dmalloc_startup(const char *debug_str)
+{
+#if LOCK_THREADS
+  if (enabled_b) {
+    return enabled_b;
+  }
+  START_ENTER();
+  /* NOTE: a caller without options must not drop another's string */
+  if (debug_str != NULL) {
+    startup_str = debug_str;
+  }
+  (void)pthread_once(&startup_once, startup_once_func);
+  START_LEAVE();
+  return enabled_b;
+#else
+  return startup_library(debug_str);
+#endif
+}
+
 /*
  * static int dmalloc_in
  *
@@ -489,10 +717,22 @@ static	int	dmalloc_in(const char *file, const int line,
   }
   
   /*
-   * NOTE: we need to do this outside of lock to get env vars
-   * otherwise our _dmalloc_lock_on variable won't be initialized and
-   * the THREAD_LOCK will flip.
+   * NOTE: we check this before locking since the flag is per-thread
+   * and the lock would otherwise hang a recursive call.
    */
+#if LOCK_THREADS
+  if (IN_ALLOC() || IN_START()) {
+#else
+  if (in_alloc_b) {
+#endif
+    dmalloc_errno = ERROR_IN_TWICE;
+    dmalloc_error("dmalloc_in");
+    /* NOTE: dmalloc_error may die already */
+    _dmalloc_die(0);
+    /*NOTREACHED*/
+  }
+  
+  /* NOTE: we need to do this outside of lock to get env vars */
   if (! enabled_b) {
     if (! dmalloc_startup(NULL /* no options string */)) {
       return 0;
@@ -503,18 +743,10 @@ static	int	dmalloc_in(const char *file, const int line,
   lock_thread();
 #endif
   
-  if (in_alloc_b) {
-    dmalloc_errno = ERROR_IN_TWICE;
-    dmalloc_error("dmalloc_in");
-    /* NOTE: dmalloc_error may die already */
-    _dmalloc_die(0);
-    /*NOTREACHED*/
-  }
-  
   in_alloc_b = 1;
   
   /* increment our interval */
-  _dmalloc_iter_c++;
+  ITER_INCREMENT();
   
   /* check start file/line specifications */
   if ((! BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_HEAP))
@@ -559,13 +791,52 @@ static	int	dmalloc_in(const char *file, const int line,
   }
   
   /* after all that, do we need to check the heap? */
+#if LOCK_THREADS
+  /* the verify thread does the checking if it is going */
+  if (check_heap_b && BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_HEAP)
+      && (! verify_running_b)) {
+#else
   if (check_heap_b && BIT_IS_SET(_dmalloc_flags, DEBUG_CHECK_HEAP)) {
-    (void)_dmalloc_chunk_heap_check();
+#endif
+    if (_dmalloc_check_budget > 0) {
+      (void)_dmalloc_chunk_heap_step();
+    }
+    else {
+      (void)_dmalloc_chunk_heap_check();
+    }
   }
   
   return 1;
 }
 
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+/*
+ * Can we use the thread caches?  Not until we have started and not
+ * when the settings need to see every transaction.  The fast paths
+ * must also check that they are not called back from inside the
+ * library but the cache is stocked and spilled with the lock held.
+ */
+static	int	cache_usable(void)
+{
+  return (enabled_b && (! _dmalloc_aborting_b)
+	  && (! do_shutdown_b) && start_file == NULL && start_iter == 0
+	  && start_size == 0 && _dmalloc_check_interval == 0
+	  && _dmalloc_address == NULL && _dmalloc_memory_limit == 0);
+}
+
+/*
+ * Called by the threads library with a thread's cache when it exits.
+ */
+static	void	cache_destroy(void *cache_p)
+{
+  lock_thread();
+  in_alloc_b = 1;
+  _dmalloc_chunk_cache_release(cache_p);
+  in_alloc_b = 0;
+  unlock_thread();
+}
+#endif
+
 /*
  * Going out of the alloc routines back to user space.
  */
@@ -575,6 +846,13 @@ static	void	dmalloc_out(void)
   
 #if LOCK_THREADS
   unlock_thread();
+  verify_start();
+  if (_dmalloc_check_threads > 1 && (! verify_stop_b)) {
+    /* the threads library may allocate while making the threads */
+    START_ENTER();
+    _dmalloc_chunk_check_start();
+    START_LEAVE();
+  }
 #endif
   
   if (do_shutdown_b) {
@@ -621,16 +899,13 @@ void	dmalloc_shutdown(void)
   }
   
 #if LOCK_THREADS
-  lock_thread();
-#endif
-  
-  /* we do it again in case the lock synced the flag to true now */
-  if (in_alloc_b) {
-#if LOCK_THREADS
-    unlock_thread();
-#endif
+  /* the bootstrap allocations are not ours to report */
+  if (IN_START()) {
     return;
   }
+  lock_thread();
+  verify_stop_b = 1;
+#endif
   
   in_alloc_b = 1;
   
@@ -766,6 +1041,28 @@ DMALLOC_PNT	dmalloc_malloc(const char *file, const int line,
   }
 #endif
   
+#if LOCK_THREADS
+  /* the threads library is calling back in while we start or lock */
+  if (IN_START()) {
+    return bootstrap_alloc(size, (func_id == DMALLOC_FUNC_VALLOC
+				  ? BLOCK_SIZE : alignment));
+  }
+#endif
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  /* try the thread's cache before we lock the library */
+  if (alignment == 0 && func_id != DMALLOC_FUNC_VALLOC && (! IN_ALLOC())
+      && cache_usable()) {
+    new_p = _dmalloc_chunk_cache_malloc(file, line, size, func_id);
+    if (new_p != NULL) {
+      if (tracking_func != NULL) {
+	tracking_func(file, line, func_id, size, alignment, NULL, new_p);
+      }
+      return new_p;
+    }
+  }
+#endif
+  
   if (! dmalloc_in(file, line, 1)) {
     if (tracking_func != NULL) {
       tracking_func(file, line, func_id, size, alignment, NULL, NULL);
@@ -782,23 +1079,30 @@ DMALLOC_PNT	dmalloc_malloc(const char *file, const int line,
     }
   }
   else if (alignment >= BLOCK_SIZE) {
+    if (alignment > BLOCK_SIZE && (! memalign_warn_b)) {
+      dmalloc_message("WARNING: memalign of %ld bytes larger than block-size, aligning to %d",
+		      (long)alignment, BLOCK_SIZE);
+      memalign_warn_b = 1;
+    }
     align = BLOCK_SIZE;
   }
+  else if (alignment <= ALLOCATION_ALIGNMENT) {
+    /* all of our allocations are already aligned this much */
+    align = 0;
+  }
   else {
-    /*
-     * NOTE: Currently, there is no support in the library for
-     * memalign on less than block boundaries.  It will be non-trivial
-     * to support valloc with fence-post checking and the lack of the
-     * flag width for dblock allocations.
-     */
-    if (! memalign_warn_b) {
-      dmalloc_message("WARNING: memalign called without library support");
-      memalign_warn_b = 1;
+    /* round up to a power of two like the system memalign */
+    for (align = ALLOCATION_ALIGNMENT * 2; align < alignment; align *= 2) {
     }
-    align = 0;
-    /* align = alignment */
   }
   
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  /* stock the thread's cache for the next time */
+  if (align == 0 && cache_usable()) {
+    _dmalloc_chunk_cache_fill(size, cache_destroy);
+  }
+#endif
+  
   new_p = _dmalloc_chunk_malloc(file, line, size, func_id, align);
   
   check_pnt(file, line, new_p, "malloc");
@@ -870,6 +1174,26 @@ DMALLOC_PNT	dmalloc_realloc(const char *file, const int line,
   }
 #endif
   
+#if LOCK_THREADS
+  /* move bootstrap memory into the heap or grow it in the bootstrap */
+  if (old_pnt != NULL && IS_BOOTSTRAP(old_pnt)) {
+    DMALLOC_SIZE	old_size;
+    
+    old_size = *((DMALLOC_SIZE *)old_pnt - 1);
+    new_p = dmalloc_malloc(file, line, new_size,
+			   (func_id == DMALLOC_FUNC_RECALLOC
+			    ? DMALLOC_FUNC_CALLOC : DMALLOC_FUNC_MALLOC),
+			   0 /* no alignment */, xalloc_b);
+    if (new_p != NULL) {
+      (void)memcpy(new_p, old_pnt, (old_size < new_size ? old_size : new_size));
+    }
+    return new_p;
+  }
+  if (IN_START() && old_pnt == NULL) {
+    return bootstrap_alloc(new_size, 0 /* no alignment */);
+  }
+#endif
+  
   if (! dmalloc_in(file, line, 1)) {
     if (tracking_func != NULL) {
       tracking_func(file, line, func_id, new_size, 0, old_pnt, NULL);
@@ -962,6 +1286,31 @@ int	dmalloc_free(const char *file, const int line, DMALLOC_PNT pnt,
 {
   int		ret;
   
+#if LOCK_THREADS
+  /* bootstrap memory is never reused */
+  if (pnt != NULL && IS_BOOTSTRAP(pnt)) {
+    return FREE_NOERROR;
+  }
+  /*
+   * The threads library may free its own memory while we start or
+   * lock.  We cannot take the lock then so we leave the pointer be.
+   */
+  if (IN_START()) {
+    return FREE_NOERROR;
+  }
+#endif
+  
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  /* try to free into the thread's cache before we lock the library */
+  if ((! IN_ALLOC()) && cache_usable()
+      && _dmalloc_chunk_cache_free(file, line, pnt, func_id)) {
+    if (tracking_func != NULL) {
+      tracking_func(file, line, DMALLOC_FUNC_FREE, 0, 0, pnt, NULL);
+    }
+    return FREE_NOERROR;
+  }
+#endif
+  
   if (! dmalloc_in(file, line, 1)) {
     if (tracking_func != NULL) {
       tracking_func(file, line, func_id, 0, 0, pnt, NULL);
@@ -971,6 +1320,13 @@ int	dmalloc_free(const char *file, const int line, DMALLOC_PNT pnt,
   
   check_pnt(file, line, pnt, "free");
   
+#if LOCK_THREADS && THREAD_CACHE_SIZE > 0
+  /* make room in the thread's cache for the next time */
+  if (cache_usable()) {
+    _dmalloc_chunk_cache_spill();
+  }
+#endif
+  
   ret = _dmalloc_chunk_free(file, line, pnt, func_id);
   
   dmalloc_out();
@@ -1050,6 +1406,49 @@ char	*dmalloc_strndup(const char *file, const int line,
   return new_string;
 }
 
+/*
+ * DMALLOC_PNT dmalloc_aligned_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Allocate and return a memory block of a certain size which has
+ * been aligned to a certain alignment the way the C11 aligned_alloc
+ * function does.  We can align up to the block-size so larger
+ * alignments are refused rather than handed back short.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - 0L with errno set to EINVAL if the alignment is not a
+ * power of two or is larger than the block-size.
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address of the caller.
+ *
+ * line -> Line-number of the caller.
+ *
+ * alignment -> Value to which the allocation must be aligned.
+ *
+ * size -> Number of bytes requested.
+ */
+DMALLOC_PNT	dmalloc_aligned_alloc(const char *file, const int line,
+				      const DMALLOC_SIZE alignment,
+				      const DMALLOC_SIZE size)
+
+{
+  if (alignment == 0
+      || (alignment & (alignment - 1)) != 0
+      || alignment > BLOCK_SIZE) {
+    errno = EINVAL;
+    return NULL;
+  }
+  
+  return dmalloc_malloc(file, line, size, DMALLOC_FUNC_MEMALIGN, alignment,
+			0 /* no xalloc messages */);
+}
+
 /*************************** external memory calls ***************************/
 
 /*
@@ -1191,8 +1590,8 @@ DMALLOC_PNT	recalloc(DMALLOC_PNT old_pnt, DMALLOC_SIZE new_size)
  * ARGUMENTS:
  *
  * alignment -> Value to which the allocation must be aligned.  This
- * should probably be a multiple of 2 with a maximum value equivalent
- * to the block-size which is often 1k or 4k.
+ * should be a power of 2 with a maximum value equivalent to the
+ * block-size which is often 4k.
  *
  * size -> Number of bytes requested.
  */
@@ -1207,6 +1606,91 @@ DMALLOC_PNT	memalign(DMALLOC_SIZE alignment, DMALLOC_SIZE size)
 			0 /* no xalloc messages */);
 }
 
+/*
+ * int posix_memalign
+ *
+ * DESCRIPTION:
+ *
+ * Overloading the posix_memalign(3) function.  Allocate a memory
+ * block of a certain size which has been aligned to a certain
+ * alignment and pass it back in a pointer.
+ *
+ * RETURNS:
+ *
+ * Success - 0
+ *
+ * Failure - EINVAL if the alignment is not a power of two multiple of
+ * the size of a pointer or is larger than the block-size or ENOMEM if
+ * there is no memory.
+ *
+ * ARGUMENTS:
+ *
+ * memptr <- Pointer which will be set to the allocation on success.
+ *
+ * alignment -> Value to which the allocation must be aligned.
+ *
+ * size -> Number of bytes requested.
+ */
+#undef posix_memalign
+int	posix_memalign(DMALLOC_PNT *memptr, DMALLOC_SIZE alignment,
+		       DMALLOC_SIZE size)
+{
+  char		*file;
+  DMALLOC_PNT	pnt;
+  
+  GET_RET_ADDR(file);
+  
+  /* we can align up to a block and must not hand back less */
+  if (alignment == 0
+      || alignment % sizeof(void *) != 0
+      || (alignment & (alignment - 1)) != 0
+      || alignment > BLOCK_SIZE) {
+    return EINVAL;
+  }
+  
+  pnt = dmalloc_malloc(file, DMALLOC_DEFAULT_LINE, size,
+		       DMALLOC_FUNC_MEMALIGN, alignment,
+		       0 /* no xalloc messages */);
+  if (pnt == NULL) {
+    return ENOMEM;
+  }
+  
+  *memptr = pnt;
+  return 0;
+}
+
+/*
+ * DMALLOC_PNT aligned_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Overloading the C11 aligned_alloc(3) function.  Allocate and return
+ * a memory block of a certain size which have been aligned to a
+ * certain alignment.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - 0L with errno set to EINVAL if the alignment is not a
+ * power of two or is larger than the block-size.
+ *
+ * ARGUMENTS:
+ *
+ * alignment -> Value to which the allocation must be aligned.  This
+ * must be a power of 2 no larger than the block-size.
+ *
+ * size -> Number of bytes requested.
+ */
+#undef aligned_alloc
+DMALLOC_PNT	aligned_alloc(DMALLOC_SIZE alignment, DMALLOC_SIZE size)
+{
+  char		*file;
+  
+  GET_RET_ADDR(file);
+  return dmalloc_aligned_alloc(file, DMALLOC_DEFAULT_LINE, alignment, size);
+}
+
 /*
  * DMALLOC_PNT valloc
  *
@@ -1614,10 +2098,19 @@ unsigned int	dmalloc_debug(const unsigned int flags)
     (void)dmalloc_startup(NULL /* no options string */);
   }
   
+  /* we lock so the allocation routines see the flags change at once */
+  if (! dmalloc_in(NULL /* no file-name */, 0 /* no line-number */,
+		   0 /* don't-check-heap */)) {
+    return _dmalloc_flags;
+  }
+  
   old_flags = _dmalloc_flags;
   
   /* add the new flags */
   _dmalloc_flags = flags;
+  _dmalloc_chunk_flags_changed();
+  
+  dmalloc_out();
   
   return old_flags;
 }
@@ -1682,6 +2175,7 @@ void	dmalloc_debug_setup(const char *options_str)
   }
   
   process_environ(options_str);
+  _dmalloc_chunk_flags_changed();
   dmalloc_out();
 }
 
@@ -1845,7 +2339,7 @@ unsigned long	dmalloc_memory_allocated(void)
     (void)dmalloc_startup(NULL /* no options string */);
   }
   
-  return _dmalloc_alloc_total;
+  return _dmalloc_chunk_memory_allocated();
 }
 
 /*
@@ -2118,6 +2612,11 @@ void	dmalloc_get_stats(DMALLOC_PNT *heap_low_p,
 			  unsigned long *max_pnt_np,
 			  unsigned long *max_one_p)
 {
+  if (! enabled_b) {
+    (void)dmalloc_startup(NULL /* no options string */);
+  }
+  
+  /* no locking so monitoring threads do not stall the allocations */
   _dmalloc_chunk_get_stats(heap_low_p, heap_high_p, total_space_p,
 			   user_space_p, current_allocated_p, current_pnt_np,
 			   max_allocated_p, max_pnt_np, max_one_p);
@@ -190,6 +190,38 @@ char	*dmalloc_strndup(const char *file, const int line,
 			 const char *string, const int len,
 			 const int xalloc_b);
 
+/*
+ * DMALLOC_PNT dmalloc_aligned_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Allocate and return a memory block of a certain size which has
+ * been aligned to a certain alignment the way the C11 aligned_alloc
+ * function does.  We can align up to the block-size so larger
+ * alignments are refused rather than handed back short.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - 0L with errno set to EINVAL if the alignment is not a
+ * power of two or is larger than the block-size.
+ *
+ * ARGUMENTS:
+ *
+ * file -> File-name or return-address of the caller.
+ *
+ * line -> Line-number of the caller.
+ *
+ * alignment -> Value to which the allocation must be aligned.
+ *
+ * size -> Number of bytes requested.
+ */
+extern
+DMALLOC_PNT	dmalloc_aligned_alloc(const char *file, const int line,
+				      const DMALLOC_SIZE alignment,
+				      const DMALLOC_SIZE size);
+
 /*
  * DMALLOC_PNT malloc
  *
@@ -300,14 +332,69 @@ DMALLOC_PNT	recalloc(DMALLOC_PNT old_pnt, DMALLOC_SIZE new_size);
  * ARGUMENTS:
  *
  * alignment -> Value to which the allocation must be aligned.  This
- * should probably be a multiple of 2 with a maximum value equivalent
- * to the block-size which is often 1k or 4k.
+ * should be a power of 2 with a maximum value equivalent to the
+ * block-size which is often 4k.
  *
  * size -> Number of bytes requested.
  */
 extern
 DMALLOC_PNT	memalign(DMALLOC_SIZE alignment, DMALLOC_SIZE size);
 
+/*
+ * int posix_memalign
+ *
+ * DESCRIPTION:
+ *
+ * Overloading the posix_memalign(3) function.  Allocate a memory
+ * block of a certain size which has been aligned to a certain
+ * alignment and pass it back in a pointer.
+ *
+ * RETURNS:
+ *
+ * Success - 0
+ *
+ * Failure - EINVAL if the alignment is not a power of two multiple of
+ * the size of a pointer or is larger than the block-size or ENOMEM if
+ * there is no memory.
+ *
+ * ARGUMENTS:
+ *
+ * memptr <- Pointer which will be set to the allocation on success.
+ *
+ * alignment -> Value to which the allocation must be aligned.
+ *
+ * size -> Number of bytes requested.
+ */
+extern
+int	posix_memalign(DMALLOC_PNT *memptr, DMALLOC_SIZE alignment,
+		       DMALLOC_SIZE size);
+
+/*
+ * DMALLOC_PNT aligned_alloc
+ *
+ * DESCRIPTION:
+ *
+ * Overloading the C11 aligned_alloc(3) function.  Allocate and return
+ * a memory block of a certain size which have been aligned to a
+ * certain alignment.
+ *
+ * RETURNS:
+ *
+ * Success - Valid pointer.
+ *
+ * Failure - 0L with errno set to EINVAL if the alignment is not a
+ * power of two or is larger than the block-size.
+ *
+ * ARGUMENTS:
+ *
+ * alignment -> Value to which the allocation must be aligned.  This
+ * must be a power of 2 no larger than the block-size.
+ *
+ * size -> Number of bytes requested.
+ */
+extern
+DMALLOC_PNT	aligned_alloc(DMALLOC_SIZE alignment, DMALLOC_SIZE size);
+
 /*
  * DMALLOC_PNT valloc
  *
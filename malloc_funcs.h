@@ -128,6 +128,26 @@ DMALLOC_PNT	recalloc(DMALLOC_PNT old_pnt, DMALLOC_SIZE new_size);
 extern
 DMALLOC_PNT	memalign(DMALLOC_SIZE alignment, DMALLOC_SIZE size);
 
+/*
+ * Allocate a SIZE block of bytes that has been aligned to ALIGNMENT
+ * bytes and set MEMPTR to it.  ALIGNMENT must be a power of two
+ * multiple of the size of a pointer.
+ *
+ * Returns 0 on success, EINVAL on a bad alignment, or ENOMEM.
+ */
+extern
+int	posix_memalign(DMALLOC_PNT *memptr, DMALLOC_SIZE alignment,
+		       DMALLOC_SIZE size);
+
+/*
+ * Allocate and return a SIZE block of bytes that has been aligned to
+ * ALIGNMENT bytes.  ALIGNMENT must be a power of two.
+ *
+ * Returns 0L on error.
+ */
+extern
+DMALLOC_PNT	aligned_alloc(DMALLOC_SIZE alignment, DMALLOC_SIZE size);
+
 /*
  * Allocate and return a SIZE block of bytes that has been aligned to
  * a page-size.
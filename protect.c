@@ -43,28 +43,38 @@
 #include "heap.h"
 #include "protect.h"
 
+/* is a pointer on a block boundary and the block it is in */
+#define ON_BLOCK(pnt)		((unsigned long)(pnt) % BLOCK_SIZE == 0)
+#define BLOCK_ROUND(pnt)	\
+	((char *)(pnt) - (unsigned long)(pnt) % BLOCK_SIZE)
+
+#if PROTECT_ALLOWED
+
 /*
- * void _dmalloc_protect_set_read_only
+ * static int protect_blocks
  *
  * DESCRIPTION:
  *
- * Set the protections on a block to be read-only.
+ * Set the protections on a number of blocks.
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
  * mem -> Pointer to block that we are protecting.
  *
  * block_n -> Number of blocks that we are protecting.
+ *
+ * prot -> Protection flags to pass to mprotect.
  */
-void	_dmalloc_protect_set_read_only(void *mem, const int block_n)
+static	int	protect_blocks(void *mem, const int block_n, const int prot)
 {
-#if PROTECT_ALLOWED && PROTECT_BLOCKS
-  int	size = block_n * BLOCK_SIZE;
-  void	*block_pnt;
+  unsigned long	size = (unsigned long)block_n * BLOCK_SIZE;
+  void		*block_pnt;
   
   if (ON_BLOCK(mem)) {
     block_pnt = mem;
@@ -73,23 +83,58 @@ void	_dmalloc_protect_set_read_only(void *mem, const int block_n)
     block_pnt = BLOCK_ROUND(mem);
   }
   
-  if (mprotect(block_pnt, size, PROT_READ) != 0) {
-    dmalloc_message("mprotect on '%#lx' size %d failed",
+  if (mprotect(block_pnt, size, prot) != 0) {
+    dmalloc_message("mprotect on '%#lx' size %lu failed",
 		    (unsigned long)block_pnt, size);
+    return 0;
   }
+  
+  return 1;
+}
+
+#endif /* PROTECT_ALLOWED */
+
+/*
+ * int _dmalloc_protect_set_read_only
+ *
+ * DESCRIPTION:
+ *
+ * Set the protections on a block to be read-only.
+ *
+ * RETURNS:
+ *
+ * Success - 1
+ *
+ * Failure - 0
+ *
+ * ARGUMENTS:
+ *
+ * mem -> Pointer to block that we are protecting.
+ *
+ * block_n -> Number of blocks that we are protecting.
+ */
+int	_dmalloc_protect_set_read_only(void *mem, const int block_n)
+{
+#if PROTECT_ALLOWED
+  return protect_blocks(mem, block_n, PROT_READ);
+#else
+  return 0;
 #endif
 }
 
 /*
- * void _dmalloc_protect_set_read_write
+ * int _dmalloc_protect_set_read_write
  *
  * DESCRIPTION:
  *
- * Set the protections on a block to be read-write.
+ * Set the protections on a block to be read-write, and executable
+ * where the system has it, to match the heap mapping.
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
@@ -97,18 +142,10 @@ void	_dmalloc_protect_set_read_only(void *mem, const int block_n)
  *
  * block_n -> Number of blocks that we are protecting.
  */
-void	_dmalloc_protect_set_read_write(void *mem, const int block_n)
+int	_dmalloc_protect_set_read_write(void *mem, const int block_n)
 {
-#if PROTECT_ALLOWED && PROTECT_BLOCKS
-  int	prot, size = block_n * BLOCK_SIZE;
-  void	*block_pnt;
-  
-  if (ON_BLOCK(mem)) {
-    block_pnt = mem;
-  }
-  else {
-    block_pnt = BLOCK_ROUND(mem);
-  }
+#if PROTECT_ALLOWED
+  int	prot;
   
   /*
    * We set executable if possible in case the user has allocated
@@ -118,15 +155,14 @@ void	_dmalloc_protect_set_read_write(void *mem, const int block_n)
 #ifdef PROT_EXEC
   prot |= PROT_EXEC;
 #endif
-  if (mprotect(block_pnt, size, prot) != 0) {
-    dmalloc_message("mprotect on '%#lx' size %d failed",
-		    (unsigned long)block_pnt, size);
-  }
+  return protect_blocks(mem, block_n, prot);
+#else
+  return 0;
 #endif
 }
 
 /*
- * void _dmalloc_protect_set_no_access
+ * int _dmalloc_protect_set_no_access
  *
  * DESCRIPTION:
  *
@@ -134,7 +170,9 @@ void	_dmalloc_protect_set_read_write(void *mem, const int block_n)
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
@@ -142,22 +180,11 @@ void	_dmalloc_protect_set_read_write(void *mem, const int block_n)
  *
  * block_n -> Number of blocks that we are protecting.
  */
-void	_dmalloc_protect_set_no_access(void *mem, const int block_n)
+int	_dmalloc_protect_set_no_access(void *mem, const int block_n)
 {
-#if PROTECT_ALLOWED && PROTECT_BLOCKS
-  int	size = block_n * BLOCK_SIZE;
-  void	*block_pnt;
-  
-  if (ON_BLOCK(mem)) {
-    block_pnt = mem;
-  }
-  else {
-    block_pnt = BLOCK_ROUND(mem);
-  }
-  
-  if (mprotect(block_pnt, size, PROT_NONE) != 0) {
-    dmalloc_message("mprotect on '%#lx' size %d failed",
-		    (unsigned long)block_pnt, size);
-  }
+#if PROTECT_ALLOWED
+  return protect_blocks(mem, block_n, PROT_NONE);
+#else
+  return 0;
 #endif
 }
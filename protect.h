@@ -25,7 +25,7 @@
 /*<<<<<<<<<<  The below prototypes are auto-generated by fillproto */
 
 /*
- * void _dmalloc_protect_set_read_only
+ * int _dmalloc_protect_set_read_only
  *
  * DESCRIPTION:
  *
@@ -33,7 +33,9 @@
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
@@ -42,18 +44,21 @@
  * block_n -> Number of blocks that we are protecting.
  */
 extern
-void	_dmalloc_protect_set_read_only(void *mem, const int block_n);
+int	_dmalloc_protect_set_read_only(void *mem, const int block_n);
 
 /*
- * void _dmalloc_protect_set_read_write
+ * int _dmalloc_protect_set_read_write
  *
  * DESCRIPTION:
  *
- * Set the protections on a block to be read-write.
+ * Set the protections on a block to be read-write, and executable
+ * where the system has it, to match the heap mapping.
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
@@ -62,10 +67,10 @@ void	_dmalloc_protect_set_read_only(void *mem, const int block_n);
  * block_n -> Number of blocks that we are protecting.
  */
 extern
-void	_dmalloc_protect_set_read_write(void *mem, const int block_n);
+int	_dmalloc_protect_set_read_write(void *mem, const int block_n);
 
 /*
- * void _dmalloc_protect_set_no_access
+ * int _dmalloc_protect_set_no_access
  *
  * DESCRIPTION:
  *
@@ -73,7 +78,9 @@ void	_dmalloc_protect_set_read_write(void *mem, const int block_n);
  *
  * RETURNS:
  *
- * None.
+ * Success - 1
+ *
+ * Failure - 0
  *
  * ARGUMENTS:
  *
@@ -82,7 +89,7 @@ void	_dmalloc_protect_set_read_write(void *mem, const int block_n);
  * block_n -> Number of blocks that we are protecting.
  */
 extern
-void	_dmalloc_protect_set_no_access(void *mem, const int block_n);
+int	_dmalloc_protect_set_no_access(void *mem, const int block_n);
 
 /*<<<<<<<<<<   This is end of the auto-generated output from fillproto. */
 